@@ -0,0 +1,96 @@
+/**
+ * Node definitions for the libvirt test driver, so the benchmarks need no
+ * real hypervisor.
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+
+function uuid(i, kind) {
+    return '6695eb01-f6a4-' + kind + '-79aa-' + ('000000000000' + i.toString(16)).slice(-12);
+}
+
+function domain(i) {
+    return [
+        '  <domain type="test">',
+        '    <name>bench-' + i + '</name>',
+        '    <uuid>' + uuid(i, '0001') + '</uuid>',
+        '    <memory>262144</memory>',
+        '    <currentMemory>131072</currentMemory>',
+        '    <vcpu>2</vcpu>',
+        '    <os><type arch="x86_64">hvm</type></os>',
+        '    <devices>',
+        '      <disk type="file" device="disk">',
+        '        <source file="/bench/bench-' + i + '.img"/>',
+        '        <target dev="vda" bus="virtio"/>',
+        '      </disk>',
+        '      <interface type="network">',
+        '        <source network="default"/>',
+        '      </interface>',
+        '    </devices>',
+        '  </domain>'
+    ].join('\n');
+}
+
+function volume(i) {
+    return [
+        '    <volume>',
+        '      <name>bench-' + i + '.img</name>',
+        '      <capacity>1073741824</capacity>',
+        '      <allocation>' + (i % 1024 + 1) * 1048576 + '</allocation>',
+        '    </volume>'
+    ].join('\n');
+}
+
+function pool(volumes) {
+    var xml = [
+        '  <pool type="dir">',
+        '    <name>bench</name>',
+        '    <uuid>' + uuid(0, '0002') + '</uuid>',
+        '    <capacity>1099511627776</capacity>',
+        '    <allocation>0</allocation>',
+        '    <available>1099511627776</available>',
+        '    <source/>',
+        '    <target><path>/bench</path></target>'
+    ];
+
+    for (var i = 0; i < volumes; i++) {
+        xml.push(volume(i));
+    }
+
+    xml.push('  </pool>');
+    return xml.join('\n');
+}
+
+/**
+ * Writes a node with the given number of running domains, and a pool with
+ * a volume per domain, to a temporary file
+ *
+ * @param domains {Number}
+ *        the number of domains
+ * @return {String} the URI of the test driver reading the file
+ */
+exports.create = function(domains) {
+    var file = path.join(os.tmpdir(), 'virt-bench-' + process.pid + '-' + domains + '.xml');
+    var xml = ['<node>'];
+
+    for (var i = 0; i < domains; i++) {
+        xml.push(domain(i));
+    }
+
+    xml.push(pool(domains));
+    xml.push('</node>');
+
+    fs.writeFileSync(file, xml.join('\n'));
+    process.on('exit', function() {
+        try {
+            fs.unlinkSync(file);
+        } catch (e) {
+        }
+    });
+
+    return 'test://' + file;
+};
@@ -0,0 +1,230 @@
+/**
+ * Measures the throughput, latency, event loop lag and heap growth of a
+ * benchmark case.
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// interval of the event loop lag probe in milliseconds
+var LAG_INTERVAL = 5;
+
+// a synchronous run yields to the event loop after this many milliseconds
+var SLICE = 10;
+
+function now() {
+    var t = process.hrtime();
+    return t[0] * 1e3 + t[1] / 1e6;
+}
+
+/**
+ * Growable array of samples in milliseconds
+ */
+function Samples() {
+    this.values = new Float64Array(1024);
+    this.length = 0;
+}
+
+Samples.prototype.push = function(value) {
+    if (this.length === this.values.length) {
+        var values = new Float64Array(this.values.length * 2);
+        values.set(this.values);
+        this.values = values;
+    }
+
+    this.values[this.length++] = value;
+};
+
+/**
+ * Summarizes the samples, in microseconds
+ */
+Samples.prototype.summary = function() {
+    var sorted = Array.prototype.slice.call(this.values.subarray(0, this.length)).sort(function(a, b) {
+        return a - b;
+    });
+    var n = sorted.length;
+    var sum = 0;
+
+    for (var i = 0; i < n; i++) {
+        sum += sorted[i];
+    }
+
+    function at(q) {
+        return 0 === n ? 0 : round(sorted[Math.min(n - 1, Math.floor(q * n))] * 1e3);
+    }
+
+    return {
+        count : n,
+        mean  : 0 === n ? 0 : round(sum / n * 1e3),
+        p50   : at(0.5),
+        p99   : at(0.99),
+        max   : 0 === n ? 0 : round(sorted[n - 1] * 1e3)
+    };
+};
+
+function round(value) {
+    return Math.round(value * 100) / 100;
+}
+
+/**
+ * Samples how late a repeating timer fires while the case runs
+ */
+function LagProbe() {
+    var self = this;
+    var expected = now() + LAG_INTERVAL;
+
+    this.samples = new Samples();
+    this.timer = setInterval(function() {
+        var t = now();
+        self.samples.push(Math.max(0, t - expected));
+        expected = t + LAG_INTERVAL;
+    }, LAG_INTERVAL);
+}
+
+LagProbe.prototype.stop = function() {
+    clearInterval(this.timer);
+
+    // in milliseconds, the samples are kept in milliseconds as well
+    var summary = this.samples.summary();
+    ['mean', 'p50', 'p99', 'max'].forEach(function(key) {
+        summary[key] = round(summary[key] / 1e3);
+    });
+
+    return summary;
+};
+
+function heap() {
+    if ('function' === typeof global.gc) {
+        global.gc();
+    }
+
+    return process.memoryUsage().heapUsed;
+}
+
+/**
+ * Calls <code>fn()</code> back to back for the given duration, yielding to
+ * the event loop every few milliseconds so that the lag is observable
+ */
+function runSync(fn, duration, latency, done) {
+    var end = now() + duration;
+
+    (function slice() {
+        var t = now();
+        var until = Math.min(end, t + SLICE);
+
+        try {
+            while (t < until) {
+                fn();
+
+                var t1 = now();
+                latency.push(t1 - t);
+                t = t1;
+            }
+        } catch (e) {
+            return done(e);
+        }
+
+        if (t < end) {
+            setImmediate(slice);
+        } else {
+            done();
+        }
+    })();
+}
+
+/**
+ * Keeps <code>concurrency</code> calls of <code>fn(callback)</code> in
+ * flight for the given duration
+ */
+function runAsync(fn, duration, concurrency, latency, done) {
+    var end = now() + duration;
+    var inflight = 0;
+    var failure = null;
+
+    function next() {
+        if (failure || now() >= end) {
+            if (0 === inflight) {
+                done(failure);
+            }
+            return;
+        }
+
+        var t = now();
+        inflight++;
+
+        fn(function(err) {
+            inflight--;
+            latency.push(now() - t);
+            failure = failure || err;
+            next();
+        });
+    }
+
+    for (var i = 0; i < concurrency; i++) {
+        next();
+    }
+}
+
+/**
+ * Runs a case for the given duration after a short warm-up.
+ *
+ * @param options {Object}
+ *        <code>mode</code> 'sync' or 'async', <code>duration</code> and
+ *        <code>warmup</code> in milliseconds and the
+ *        <code>concurrency</code> of asynchronous runs, and an optional
+ *        <code>before</code> function called right before the measurement
+ * @param fn {Function}
+ *        the operation, takes a callback in asynchronous mode
+ * @param callback {Function}
+ *        invoked with the error and the result
+ */
+exports.run = function(options, fn, callback) {
+    function measure(duration, done) {
+        var latency = new Samples();
+        var started = now();
+
+        function finish(err) {
+            done(err, latency, now() - started);
+        }
+
+        if ('sync' === options.mode) {
+            runSync(fn, duration, latency, finish);
+        } else {
+            runAsync(fn, duration, options.concurrency, latency, finish);
+        }
+    }
+
+    measure(options.warmup, function(err) {
+        if (err) {
+            return callback(err);
+        }
+
+        if (options.before) {
+            options.before();
+        }
+
+        var before = heap();
+        var probe = new LagProbe();
+
+        measure(options.duration, function(err, latency, elapsed) {
+            var lag = probe.stop();
+
+            if (err) {
+                return callback(err);
+            }
+
+            var after = heap();
+
+            callback(null, {
+                ops       : latency.length,
+                opsPerSec : round(latency.length / elapsed * 1e3),
+                latency   : latency.summary(),
+                lag       : lag,
+                heap      : {
+                    before : before,
+                    after  : after,
+                    growth : after - before
+                }
+            });
+        });
+    });
+};
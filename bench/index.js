@@ -0,0 +1,283 @@
+/**
+ * Benchmarks of the bindings against the libvirt test driver.
+ *
+ * <pre>
+ * node --expose-gc bench [options]
+ *
+ *   --domains n       domains of the generated test node, 1000 by default
+ *   --uri uri         hypervisor to use instead, e.g. test:///default
+ *   --duration ms     measured time per case, 2000 by default
+ *   --warmup ms       warm-up time per case, 500 by default
+ *   --concurrency n   calls in flight in async mode, 16 by default
+ *   --filter regexp   only run the matching cases
+ *   --instrument      add the native split of libvirt and v8 time
+ *   --out file        write the results there instead of stdout
+ *   --baseline file   compare with earlier results, exits with 1 on
+ *                     regressions
+ *   --threshold r     tolerated relative regression, 0.1 by default
+ * </pre>
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+var fs = require('fs');
+var os = require('os');
+var virt = require('../');
+var fixture = require('./fixture');
+var harness = require('./harness');
+
+var Connection = virt.Connection;
+
+function parse(argv) {
+    var options = {
+        domains     : 1000,
+        duration    : 2000,
+        warmup      : 500,
+        concurrency : 16,
+        threshold   : 0.1
+    };
+
+    for (var i = 0; i < argv.length; i++) {
+        var key = argv[i].replace(/^--/, '');
+
+        if ('instrument' === key) {
+            options.instrument = true;
+        } else if (/^(domains|duration|warmup|concurrency|threshold)$/.test(key)) {
+            options[key] = Number(argv[++i]);
+        } else if (/^(uri|filter|out|baseline)$/.test(key)) {
+            options[key] = argv[++i];
+        } else {
+            throw new Error('Unknown option ' + argv[i]);
+        }
+    }
+
+    return options;
+}
+
+/**
+ * A method called with the given arguments, synchronously or with a
+ * callback appended
+ */
+function method(target, name, args) {
+    args = args || [];
+
+    return {
+        sync : function(ctx) {
+            var self = target(ctx);
+            return self[name].apply(self, args);
+        },
+        async : function(ctx, callback) {
+            var self = target(ctx);
+            return self[name].apply(self, args.concat([callback]));
+        }
+    };
+}
+
+function conn(ctx) {
+    return ctx.conn;
+}
+
+function pool(ctx) {
+    return ctx.pool;
+}
+
+function domain(ctx) {
+    return ctx.domain;
+}
+
+var cases = {
+    'Connection#getHostname'         : method(conn, 'getHostname'),
+    'Connection#getLibVersion'       : method(conn, 'getLibVersion'),
+    'Connection#getNodeInfo'         : method(conn, 'getNodeInfo'),
+    'Connection#getCapabilities'     : method(conn, 'getCapabilities'),
+    'Connection#isAlive'             : method(conn, 'isAlive'),
+    'Connection#listAllDomains'      : method(conn, 'listAllDomains'),
+    'Connection#getAllDomainStats'   : method(conn, 'getAllDomainStats'),
+    'Connection#listAllStoragePools' : method(conn, 'listAllStoragePools'),
+    'StoragePool#listAllVolumes'     : method(pool, 'listAllVolumes'),
+    'StoragePool#getVolumeInventory' : method(pool, 'getVolumeInventory'),
+    'Domain#getXMLDesc'              : method(domain, 'getXMLDesc', [0]),
+    'Connection.gather'              : {
+        stats : 'gather',
+        async : function(ctx, callback) {
+            Connection.gather(ctx.conns, ['getHostname', 'getNodeInfo'], { timeout: 10000 }, callback);
+        }
+    }
+};
+
+function setup(uri) {
+    var ctx = {
+        conn  : Connection.open(uri),
+        conns : []
+    };
+
+    for (var i = 0; i < 8; i++) {
+        ctx.conns.push(Connection.open(uri));
+    }
+
+    var pools = ctx.conn.listAllStoragePools();
+    var domains = ctx.conn.listAllDomains();
+
+    ctx.pool = pools.length > 0 ? pools[pools.length - 1].pool : null;
+    ctx.domain = domains.length > 0 ? domains[0].domain : null;
+    ctx.domains = domains.length;
+
+    return ctx;
+}
+
+function teardown(ctx) {
+    ctx.conns.concat([ctx.conn]).forEach(function(conn) {
+        conn.close();
+    });
+}
+
+/**
+ * Returns the regressions of the results against the baseline
+ */
+function compare(results, baseline, threshold) {
+    var regressions = [];
+
+    results.forEach(function(result) {
+        var base = baseline.results.filter(function(r) {
+            return r.name === result.name && r.mode === result.mode;
+        })[0];
+
+        if (!base) {
+            return;
+        }
+
+        if (result.opsPerSec < base.opsPerSec * (1 - threshold)) {
+            regressions.push({ name: result.name, mode: result.mode, metric: 'opsPerSec', baseline: base.opsPerSec, value: result.opsPerSec });
+        }
+
+        if (result.latency.p99 > base.latency.p99 * (1 + threshold)) {
+            regressions.push({ name: result.name, mode: result.mode, metric: 'latency.p99', baseline: base.latency.p99, value: result.latency.p99 });
+        }
+    });
+
+    return regressions;
+}
+
+function report(result) {
+    process.stderr.write([
+        (result.name + new Array(35).join(' ')).slice(0, 34),
+        (result.mode + new Array(7).join(' ')).slice(0, 6),
+        ('          ' + result.opsPerSec.toFixed(0)).slice(-10) + ' ops/s',
+        '  p50 ' + result.latency.p50 + 'us',
+        '  p99 ' + result.latency.p99 + 'us',
+        '  lag ' + result.lag.max + 'ms',
+        '  heap ' + (result.heap.growth / 1024).toFixed(0) + 'KiB'
+    ].join('') + '\n');
+}
+
+function main() {
+    var options = parse(process.argv.slice(2));
+    var uri = options.uri || fixture.create(options.domains);
+    var filter = options.filter ? new RegExp(options.filter) : null;
+    var ctx = setup(uri);
+    var runs = [];
+    var results = [];
+
+    Object.keys(cases).forEach(function(name) {
+        if (filter && !filter.test(name)) {
+            return;
+        }
+
+        ['sync', 'async'].forEach(function(mode) {
+            if (cases[name][mode]) {
+                runs.push({ name: name, mode: mode });
+            }
+        });
+    });
+
+    if ('function' !== typeof global.gc) {
+        process.stderr.write('heap growth includes garbage, run with --expose-gc\n');
+    }
+
+    virt.setInstrumentation(!!options.instrument);
+
+    (function next() {
+        var run = runs.shift();
+
+        if (!run) {
+            return finish();
+        }
+
+        var fn = cases[run.name][run.mode];
+        var settings = {
+            mode        : run.mode,
+            duration    : options.duration,
+            warmup      : options.warmup,
+            concurrency : options.concurrency,
+            before      : virt.resetStats
+        };
+
+        harness.run(settings, 'sync' === run.mode ? function() {
+            fn(ctx);
+        } : function(callback) {
+            fn(ctx, callback);
+        }, function(err, result) {
+            if (err) {
+                result = { error: err.message };
+            } else if (options.instrument) {
+                result.native = virt.getStats()[cases[run.name].stats || run.name];
+            }
+
+            result.name = run.name;
+            result.mode = run.mode;
+            results.push(result);
+
+            if (err) {
+                process.stderr.write(run.name + ' ' + run.mode + ': ' + err.message + '\n');
+            } else {
+                report(result);
+            }
+
+            setImmediate(next);
+        });
+    })();
+
+    function finish() {
+        teardown(ctx);
+        virt.setInstrumentation(false);
+
+        var output = {
+            meta : {
+                date        : new Date().toISOString(),
+                node        : process.version,
+                libvirt     : virt.getVersion(),
+                hostname    : os.hostname(),
+                cpus        : os.cpus().length,
+                uri         : options.uri || 'test driver with ' + options.domains + ' domains',
+                domains     : ctx.domains,
+                duration    : options.duration,
+                concurrency : options.concurrency
+            },
+            results : results.filter(function(result) {
+                return !result.error;
+            }),
+            errors : results.filter(function(result) {
+                return result.error;
+            })
+        };
+
+        if (options.baseline) {
+            output.regressions = compare(output.results, JSON.parse(fs.readFileSync(options.baseline, 'utf8')), options.threshold);
+            output.regressions.forEach(function(r) {
+                process.stderr.write('REGRESSION ' + r.name + ' ' + r.mode + ' ' + r.metric + ': ' + r.baseline + ' -> ' + r.value + '\n');
+            });
+        }
+
+        var json = JSON.stringify(output, null, 2) + '\n';
+
+        if (options.out) {
+            fs.writeFileSync(options.out, json);
+        } else {
+            process.stdout.write(json);
+        }
+
+        process.exitCode = (output.regressions && output.regressions.length > 0) ? 1 : 0;
+    }
+}
+
+main();
@@ -3,28 +3,59 @@
         {
             "target_name" : "virt",
             "sources" : [
+                "src/virt-arena.h",
+                "src/virt-bitset.h",
+                "src/virt-bitset.cc",
+                "src/virt-cache.h",
+                "src/virt-cache.cc",
+                "src/virt-cpu-matrix.h",
+                "src/virt-cpu-matrix.cc",
                 "src/virt-domain.h",
                 "src/virt-domain.cc",
                 "src/virt-domain-snapshot.h",
                 "src/virt-domain-snapshot.cc",
                 "src/virt-event.h",
                 "src/virt-event.cc",
+                "src/virt-executor.h",
+                "src/virt-executor.cc",
+                "src/virt-external-string.h",
+                "src/virt-gather.h",
+                "src/virt-gather.cc",
+                "src/virt-hash.h",
                 "src/virt-host.h",
                 "src/virt-host.cc",
+                "src/virt-instance.h",
+                "src/virt-instance.cc",
                 "src/virt-interface.h",
                 "src/virt-interface.cc",
+                "src/virt-inventory.h",
+                "src/virt-inventory.cc",
+                "src/virt-mirror.h",
+                "src/virt-mirror.cc",
                 "src/virt-network.h",
                 "src/virt-network.cc",
                 "src/virt-node-device.h",
                 "src/virt-node-device.cc",
                 "src/virt-network-filter.h",
                 "src/virt-network-filter.cc",
+                "src/virt-pool.h",
+                "src/virt-pool.cc",
+                "src/virt-ring.h",
                 "src/virt-secret.h",
                 "src/virt-secret.cc",
                 "src/virt-storage.h",
                 "src/virt-storage.cc",
+                "src/virt-stats.h",
+                "src/virt-stats.cc",
                 "src/virt-stream.h",
                 "src/virt-stream.cc",
+                "src/virt-thread-pool.h",
+                "src/virt-thread-pool.cc",
+                "src/virt-typed-parameter.h",
+                "src/virt-typed-parameter.cc",
+                "src/virt-worker.h",
+                "src/virt-xml.h",
+                "src/virt-xml.cc",
                 "src/virt.cc"
             ],
             "include_dirs" : [
@@ -6,12 +6,20 @@
  * @version 2.0.0
  */
 
+var stream = require('stream');
+var util = require('util');
 var virt = require('./build/Release/virt.node');
 
 
 /**
  * Hypervisor Connection
  * 
+ * <p>Every method which talks to the hypervisor also accepts an optional
+ * callback as its last argument. When the callback is given, the libvirt
+ * call is performed on the libuv thread pool and the callback is invoked
+ * with <code>(err, result)</code>, otherwise the call blocks and the result
+ * is returned directly.</p>
+ * 
  * @class
  * @see {@link https://libvirt.org/html/libvirt-libvirt-host.html#virConnect}
  */
@@ -28,11 +36,41 @@ var Interface = virt.Interface;
 /**
  * Domain
  * 
+ * <p>The typed parameter getters accept an optional trailing callback just
+ * like the methods of {@link Connection}.</p>
+ * 
  * @class
  * @see {@link http://libvirt.org/html/libvirt-libvirt-domain.html#virDomain}
  */
 var Domain = virt.Domain;
 
+/**
+ * Data stream
+ * 
+ * <p>Streams are non-blocking, use {@link Stream#createReadStream()} and
+ * {@link Stream#createWriteStream()} to transfer data as node streams.</p>
+ * 
+ * @class
+ * @see {@link http://libvirt.org/html/libvirt-libvirt-stream.html#virStream}
+ */
+var Stream = virt.Stream;
+
+/**
+ * Storage pool
+ * 
+ * @class
+ * @see {@link http://libvirt.org/html/libvirt-libvirt-storage.html#virStoragePool}
+ */
+var StoragePool = virt.StoragePool;
+
+/**
+ * Storage volume
+ * 
+ * @class
+ * @see {@link http://libvirt.org/html/libvirt-libvirt-storage.html#virStorageVol}
+ */
+var StorageVolume = virt.StorageVolume;
+
 /**
  * <p>This function should be called first to get a connection to the
  * Hypervisor and xen store</p>
@@ -108,6 +146,136 @@ Connection.openReadOnly = function() {
     return virt.virConnectOpenReadOnly.apply(virt, arguments);
 };
 
+/**
+ * Returns a pooled connection to the hypervisor.
+ * 
+ * <p>Connections are pooled by URI and read-only flag. An idle pooled
+ * connection which is still alive is handed out first, otherwise a new one
+ * is opened as long as the URI has less connections than the pool limit,
+ * beyond that the least used connection is shared. Connections which are
+ * closed by the hypervisor are dropped from the pool.</p>
+ * 
+ * <p>The connection is given back to the pool by {@link Connection#close()}.</p>
+ * 
+ * @param name {String}
+ *        URI of the hypervisor, optional
+ * @param readOnly {Boolean}
+ *        whether to open a read-only connection, optional
+ * @return {Connection} the hypervisor connection
+ * @throws {Error}
+ */
+Connection.acquire = function(name, readOnly) {
+    return virt.acquireConnection.apply(virt, arguments);
+};
+
+/**
+ * Sets the maximum number of pooled connections per URI, 4 by default
+ * 
+ * @param limit {Number}
+ *        the maximum number of connections
+ * @throws {Error}
+ */
+Connection.setPoolLimit = function(limit) {
+    return virt.setConnectionPoolLimit.apply(virt, arguments);
+};
+
+/**
+ * Closes the idle pooled connections, the connections in use are closed
+ * once given back to the pool
+ * 
+ * @return {Number} the number of connections closed
+ */
+Connection.drainPool = function() {
+    return virt.drainConnectionPool.apply(virt, arguments);
+};
+
+/**
+ * Runs host queries against many connections at once.
+ * 
+ * <p>Every connection gets a slot on a bounded pool of native threads which
+ * runs the queries one after the other, so a slow host only delays its own
+ * slot. A slot running longer than the timeout is reported as timed out and
+ * left to finish in the background.</p>
+ * 
+ * <p>A query is the name of a host method without arguments, or an array
+ * of the name and its integer arguments, e.g.
+ * <code>['getNodeCellsFreeMemory', 0, 2]</code>. Supported are
+ * getHostname, getLibVersion, getNodeCPUStats, getNodeCellsFreeMemory,
+ * getNodeFreeMemory, getNodeInfo and getNodeMemoryStats.</p>
+ * 
+ * <p>The result has one object per connection in the same order, with the
+ * result of each query under its name, an <code>errors</code> object with
+ * the messages of the queries that failed, an <code>error</code> message if
+ * the host timed out or the connection is closed, and the
+ * <code>elapsed</code> milliseconds.</p>
+ * 
+ * @param connections {Array}
+ *        the connections to query
+ * @param queries {Array}
+ *        the queries to run on every connection
+ * @param options {Object}
+ *        <code>timeout</code> in milliseconds per host, optional
+ * @param callback {Function}
+ *        invoked with the error and the results
+ * @throws {Error}
+ */
+Connection.gather = function(connections, queries, options, callback) {
+    return virt.gather.apply(virt, arguments);
+};
+
+/**
+ * Compares every guest CPU with every host, the matrix of
+ * {@link Connection#compareCPU} over all pairs in one pass.
+ * 
+ * <p>The CPU of every host is read from its capabilities, and every
+ * distinct guest CPU is compared once per distinct host CPU, on one of
+ * the hosts which have it; the comparisons run in parallel on the native
+ * threads shared with {@link Connection.gather}, see
+ * {@link Connection.setGatherConcurrency}. The answers are kept across
+ * calls keyed by the hashes of both CPU descriptions, whitespace between
+ * elements aside.</p>
+ * 
+ * <p>The result has the <code>matrix</code>, an Int8Array with the
+ * virCPUCompareResult of guest <code>i</code> on host <code>j</code> at
+ * <code>i * connections.length + j</code>, the <code>baseline</code> CPU
+ * of the hosts if asked for, the number of comparisons
+ * <code>compared</code> and of the answers <code>memoized</code>, and
+ * <code>errors</code> if any, each with the index of the
+ * <code>host</code> or <code>guest</code> or with <code>baseline</code>,
+ * and the <code>error</code> message. Failed pairs are
+ * VIR_CPU_COMPARE_ERROR in the matrix.</p>
+ * 
+ * @param cpus {Array}
+ *        the XML descriptions of the guest CPUs
+ * @param connections {Array}
+ *        the hosts to compare with
+ * @param options {Object}
+ *        the <code>flags</code> of the comparisons, <code>baseline</code>
+ *        to compute the baseline CPU of the hosts with the
+ *        <code>baselineFlags</code>, and the number of threads
+ *        <code>concurrency</code>, 16 by default, optional
+ * @param callback {Function}
+ *        invoked with the error and the result, optional
+ * @return {Object} the result if there is no callback
+ * @throws {Error}
+ */
+Connection.compareCPUMatrix = function(cpus, connections, options, callback) {
+    return virt.compareCPUMatrix.apply(virt, arguments);
+};
+
+/**
+ * Sets the maximum number of native threads shared by
+ * {@link Connection.gather} and {@link Connection.compareCPUMatrix}, i.e.
+ * of hosts queried at once, 16 by default
+ * 
+ * @param concurrency {Number}
+ *        the maximum number of threads
+ * @throws {Error}
+ */
+Connection.setGatherConcurrency = function(concurrency) {
+    return virt.setGatherConcurrency.apply(virt, arguments);
+};
+
 /**
  * Registers a callback to be invoked when the connection event occurred
  * 
@@ -133,6 +301,41 @@ Connection.prototype.removeEventListener = function(event, listener) {
     return virt.removeEventListener.apply(virt, arguments);
 };
 
+/**
+ * Adds a callback to receive notifications of arbitrary domain events
+ * occurring on this connection.
+ * 
+ * <p>libvirt events are buffered natively and delivered in batches: the
+ * listener is invoked at most once per event loop iteration with an array of
+ * all events received since the last invocation. Each event is an object
+ * with the <code>domain</code> and <code>eventID</code> properties plus the
+ * payload of the event, e.g. <code>event</code> and <code>detail</code> for
+ * VIR_DOMAIN_EVENT_ID_LIFECYCLE or <code>disk</code>, <code>type</code> and
+ * <code>status</code> for VIR_DOMAIN_EVENT_ID_BLOCK_JOB. RTC and balloon
+ * changes which are still pending are replaced by the latest change of the
+ * same domain.</p>
+ * 
+ * @param eventID {Number}
+ *        the event type to receive, one of the virDomainEventID constants
+ * @param listener {Function}
+ *        the callback function
+ * @param domain {Domain}
+ *        the domain to receive events for, optional
+ * @return {Number} the callback identifier
+ * @throws {Error}
+ * @function Connection#addDomainEventListener
+ */
+
+/**
+ * Removes a callback previously registered with
+ * {@link Connection#addDomainEventListener()}
+ * 
+ * @param callbackId {Number}
+ *        the callback identifier
+ * @throws {Error}
+ * @function Connection#removeDomainEventListener
+ */
+
 /**
  * Computes the most feature-rich CPU which is compatible with all given host CPUs.
  * 
@@ -144,10 +347,8 @@ Connection.prototype.removeEventListener = function(event, listener) {
  * {@code undefined} on error.
  * @see VIR_CONNECT_BASELINE_CPU_EXPAND_FEATURES
  * @see VIR_CONNECT_BASELINE_CPU_MIGRATABLE
+ * @function Connection#baselineCPU
  */
-Connection.prototype.baselineCPU = function() {
-    return virt.virConnectBaselineCPU.apply(virt, arguments);
-};
 
 /**
  * This function closes the connection to the Hypervisor.
@@ -156,10 +357,8 @@ Connection.prototype.baselineCPU = function() {
  * success. The returned value should not be assumed to be the total
  * reference count. A return of 0 implies no references remain and the
  * connection is closed and memory has been freed.
+ * @function Connection#close
  */
-Connection.prototype.close = function() {
-    return virt.virConnectClose.apply(virt, arguments);
-};
 
 /**
  * Compares the given CPU description with the host CPU
@@ -174,10 +373,8 @@ Connection.prototype.close = function() {
  * @see VIR_CPU_COMPARE_IDENTICAL
  * @see VIR_CPU_COMPARE_SUPERSET
  * @see VIR_CPU_COMPARE_LAST
+ * @function Connection#compareCPU
  */
-Connection.prototype.compareCPU = function() {
-    return virt.virConnectCompareCPU.apply(virt, arguments);
-};
 
 /**
  * Get the list of supported CPU models for a specific architecture.
@@ -197,11 +394,16 @@ Connection.prototype.getCPUModelNames = function() {
 /**
  * Get the capabilities of the hypervisor / driver.
  * 
- * @return {String} a XML string defining the capabilities.
+ * @param selectors {Array}
+ *        paths of the values to extract instead of returning the whole
+ *        document, e.g. <code>//cell/@id</code>; a path ends
+ *        with <code>@name</code> to select an attribute, starts with
+ *        <code>//</code> to match at any depth and may use <code>*</code>
+ *        for any element. Optional
+ * @return {String|Object} a XML string defining the capabilities, or the
+ *         arrays of the values keyed by selector
+ * @function Connection#getCapabilities
  */
-Connection.prototype.getCapabilities = function() {
-    return virt.virConnectGetCapabilities.apply(virt, arguments);
-};
 
 /**
  * This returns a system hostname on which the hypervisor is running
@@ -214,10 +416,8 @@ Connection.prototype.getCapabilities = function() {
  *        hypervisor connection
  * @return {String} the hostname which must be freed by the caller
  * @throws {Error}
+ * @function Connection#getHostname
  */
-Connection.prototype.getHostname = function() {
-    return virt.virConnectGetHostname.apply(virt, arguments);
-};
 
 /**
  * Returns the version of libvirt used by the daemon running on the host
@@ -226,10 +426,8 @@ Connection.prototype.getHostname = function() {
  *        hypervisor connection
  * @return {Number} libvirt library version used on the connection
  * @throws {Error}
+ * @function Connection#getLibVersion
  */
-Connection.prototype.getLibVersion = function() {
-    return virt.virConnectGetLibVersion.apply(virt, arguments);
-};
 
 /**
  * Provides the maximum number of virtual CPUs supported for a guest VM of
@@ -240,10 +438,8 @@ Connection.prototype.getLibVersion = function() {
  *        value of the 'type' attribute in the <domain> element
  * @return {Number} the maximum of virtual CPU
  * @throws {Error}
+ * @function Connection#getMaxVcpus
  */
-Connection.prototype.getMaxVcpus = function() {
-    return virt.virConnectGetMaxVcpus.apply(virt, arguments);
-};
 
 /**
  * This returns the XML description of the sysinfo details for the host on
@@ -251,13 +447,17 @@ Connection.prototype.getMaxVcpus = function() {
  * element of a domain XML. This information is generally available only
  * for hypervisors running with root privileges.
  * 
- * @param flags {Number}
- * @return {String} the XML string
+ * @param selectors {Array}
+ *        paths of the values to extract instead of returning the whole
+ *        document, e.g. <code>/sysinfo/system/entry</code>; a path ends
+ *        with <code>@name</code> to select an attribute, starts with
+ *        <code>//</code> to match at any depth and may use <code>*</code>
+ *        for any element. Optional
+ * @return {String|Object} the XML string, or the arrays of the values keyed
+ *         by selector
  * @throws {Error}
+ * @function Connection#getSysinfo
  */
-Connection.prototype.getSysinfo = function() {
-    return virt.virConnectGetSysinfo.apply(virt, arguments);
-};
 
 /**
  * Get the name of the Hypervisor driver used. This is merely the driver
@@ -268,10 +468,8 @@ Connection.prototype.getSysinfo = function() {
  * 
  * @return {String} the name of the Hypervisor driver used
  * @throws {Error}
+ * @function Connection#getType
  */
-Connection.prototype.getType = function() {
-    return virt.virConnectGetType.apply(virt, arguments);
-};
 
 /**
  * This returns the URI (name) of the hypervisor connection. Normally this
@@ -283,10 +481,8 @@ Connection.prototype.getType = function() {
  * 
  * @return {String} the URI string
  * @throws {Error}
+ * @function Connection#getURI
  */
-Connection.prototype.getURI = function() {
-    return virt.virConnectGetURI.apply(virt, arguments);
-};
 
 /**
  * Get the version level of the Hypervisor running. This may work only with
@@ -295,37 +491,29 @@ Connection.prototype.getURI = function() {
  * 
  * @return {Number} the version of the running hypervisor
  * @throws {Error}
+ * @function Connection#getVersion
  */
-Connection.prototype.getVersion = function() {
-    return virt.virConnectGetVersion.apply(virt, arguments);
-};
 
 /**
  * Determine if the connection to the hypervisor is still alive
  * 
  * @return {Boolean} true if alive, false if dead
+ * @function Connection#isAlive
  */
-Connection.prototype.isAlive = function() {
-    return virt.virConnectIsAlive.apply(virt, arguments);
-};
 
 /**
  * Determine if the connection to the hypervisor is encrypted
  * 
  * @return {Boolean} true if encrypted, false if not encrypted
+ * @function Connection#isEncrypted
  */
-Connection.prototype.isEncrypted = function() {
-    return virt.virConnectIsEncrypted.apply(virt, arguments);
-};
 
 /**
  * Determine if the connection to the hypervisor is secure
  * 
  * @return {Boolean} true if secure, false if not secure
+ * @function Connection#isSecure
  */
-Connection.prototype.isSecure = function() {
-    return virt.virConnectIsSecure.apply(virt, arguments);
-};
 
 /**
  * <p>Increment the reference count on the connection. For each additional
@@ -339,10 +527,8 @@ Connection.prototype.isSecure = function() {
  * thread using a connection would increment the reference count.</p>
  * 
  * @throws {Error}
+ * @function Connection#ref
  */
-Connection.prototype.ref = function() {
-    return virt.virConnectRef.apply(virt, arguments);
-};
 
 /**
  * Start sending keepalive messages after <code>interval</code> seconds of
@@ -361,10 +547,56 @@ Connection.prototype.ref = function() {
  * @return {Boolean} true on success, false when remote party doesn't
  * support keepalive messages
  * @throws {Error}
+ * @function Connection#setKeepAlive
+ */
+
+/**
+ * <p>Enables or disables the dedicated thread of this connection.</p>
+ * 
+ * <p>By default, asynchronous calls are executed on the shared libuv thread
+ * pool. With the dedicated thread enabled, the asynchronous calls of this
+ * connection, of its domains and of its interfaces are executed on its own
+ * native thread in the order they were made, so a slow hypervisor neither
+ * blocks other connections nor starves the file system and DNS work of the
+ * thread pool.</p>
+ * 
+ * <p>The thread is stopped when the connection is closed.</p>
+ * 
+ * @param enabled {Boolean}
+ *        true to execute the calls on a dedicated thread
+ * @function Connection#setDedicatedThread
+ */
+
+/**
+ * <p>Enables caching of the results of slow-changing host queries.</p>
+ * 
+ * <p>The cacheable queries are <code>capabilities</code>,
+ * <code>hostname</code>, <code>libVersion</code>, <code>maxVcpus</code>,
+ * <code>nodeInfo</code>, <code>securityModel</code> and
+ * <code>sysinfo</code>. A cached result is returned as is until its time to
+ * live expires, objects are shared between the calls and are therefore
+ * frozen, copy them to make changes. The cache is cleared when the
+ * connection is closed or found dead.</p>
+ * 
+ * @param ttls {Object|Number}
+ *        the time to live in milliseconds keyed by query, or a single time
+ *        to live for all of them; 0 disables caching
+ * @throws {Error}
+ * @function Connection#setCacheTTL
+ */
+
+/**
+ * Returns the cache counters of this connection
+ * 
+ * @return {Object} the <code>hits</code>, <code>misses</code> and
+ *         <code>size</code> of the cache
+ * @function Connection#getCacheStats
+ */
+
+/**
+ * Drops all the cached results of this connection
+ * @function Connection#clearCache
  */
-Connection.prototype.setKeepAlive = function() {
-    return virt.virConnectSetKeepAlive.apply(virt, arguments);
-};
 
 /**
  * Sometimes, when trying to start a new domain, it may be necessary to
@@ -389,12 +621,13 @@ Connection.prototype.allocNodePages = function(allocations, startCell, cellCount
 /**
  * Get CPU map of host node CPUs
  * 
- * @return {Array} CPUs present on the host node
+ * <p>The map has a bit per CPU of the host, set if the CPU is online, see
+ * {@link CPUMap} for counting and iterating them.</p>
+ * 
+ * @return {Uint8Array} CPUs present on the host node
  * @throws {Error}
+ * @function Connection#getNodeCPUMap
  */
-Connection.prototype.getNodeCPUMap = function() {
-    return virt.virNodeGetCPUMap.apply(virt, arguments);
-};
 
 /**
  * This function provides individual cpu statistics of the node. If you
@@ -405,10 +638,8 @@ Connection.prototype.getNodeCPUMap = function() {
  *        number of node cpu
  * @return {Object}
  * @throws {Error}
+ * @function Connection#getNodeCPUStats
  */
-Connection.prototype.getNodeCPUStats = function() {
-    return virt.virNodeGetCPUStats.apply(virt, arguments);
-};
 
 /**
  * Returns the free memory in one or more NUMA cells
@@ -417,20 +648,16 @@ Connection.prototype.getNodeCPUStats = function() {
  *        index of first cell
  * @return the free memory
  * @throws {Error}
+ * @function Connection#getNodeCellsFreeMemory
  */
-Connection.prototype.getNodeCellsFreeMemory = function(startCell) {
-    return virt.virNodeGetCellsFreeMemory.apply(virt, arguments);
-};
 
 /**
  * Returns the free memory available on the Node
  * 
  * @return the available free memory in bytes
  * @throws {Error}
+ * @function Connection#getNodeFreeMemory
  */
-Connection.prototype.getNodeFreeMemory = function() {
-    return virt.virNodeGetFreeMemory.apply(virt, arguments);
-};
 
 /**
  * Queries the host system on free pages of specified size
@@ -453,10 +680,8 @@ Connection.prototype.getNodeFreePages = function(startCell, cellCount) {
  * 
  * @return {NodeInfo}
  * @throws {Error}
+ * @function Connection#getNodeInfo
  */
-Connection.prototype.getNodeInfo = function() {
-    return virt.virNodeGetInfo.apply(virt, arguments);
-};
 
 /**
  * Get all node memory parameters (parameters unsupported by OS will be
@@ -464,10 +689,8 @@ Connection.prototype.getNodeInfo = function() {
  * 
  * @return {Array}
  * @throws {Error}
+ * @function Connection#getNodeMemoryParameters
  */
-Connection.prototype.getNodeMemoryParameters = function() {
-    return virt.virNodeGetMemoryParameters.apply(virt, arguments);
-};
 
 /**
  * Returns the memory stats of the node
@@ -476,31 +699,28 @@ Connection.prototype.getNodeMemoryParameters = function() {
  *        number of node cell
  * @return {Object}
  * @throws {Error}
+ * @function Connection#getNodeMemoryStats
  */
-Connection.prototype.getNodeMemoryStats = function() {
-    return virt.virNodeGetMemoryStats.apply(virt, arguments);
-};
 
 /**
  * Returns the security model of a hypervisor
  * 
  * @return {Object}
  * @throws {Error}
+ * @function Connection#getNodeSecurityModel
  */
-Connection.prototype.getNodeSecurityModel = function() {
-    return virt.virNodeGetSecurityModel.apply(virt, arguments);
-};
 
 /**
  * Change all or a subset of the node memory tunables
  * 
  * @param params {Array}
- *        scheduler parameter objects
+ *        <code>{ type, field, value }</code> parameter objects
+ * @param flags {Number}
+ *        extra flags; not used yet, so callers should always pass 0,
+ *        optional
  * @throws {Error}
+ * @function Connection#setNodeMemoryParameters
  */
-Connection.prototype.setNodeMemoryParameters = function() {
-    return virt.virNodeSetMemoryParameters.apply(virt, arguments);
-};
 
 /**
  * Attempt to suspend the node (host machine) for the given duration of time
@@ -513,10 +733,8 @@ Connection.prototype.setNodeMemoryParameters = function() {
  * @param duration {Number}
  *        the time duration in seconds for which the host has to be suspended
  * @throws {Error}
+ * @function Connection#suspendNodeForDuration
  */
-Connection.prototype.suspendNodeForDuration = function() {
-    return virt.virNodeSuspendForDuration.apply(virt, arguments);
-};
 
 /**
  * Returns the list of interfaces
@@ -545,10 +763,8 @@ Connection.prototype.listDefinedInterfaces = function() {
  * 
  * @return {Array}
  * @throws {Error}
+ * @function Connection#listInterfaces
  */
-Connection.prototype.listInterfaces = function() {
-    return virt.virConnectListInterfaces.apply(virt, arguments);
-};
 
 /**
  * Returns the number of defined (inactive) interfaces on the physical host
@@ -661,16 +877,175 @@ Connection.prototype.lookupInterfaceByMACString = function() {
     return virt.virInterfaceLookupByMACString.apply(virt, arguments);
 };
 
+/**
+ * Queries statistics for all domains on this connection with a single call.
+ * 
+ * <p>The numeric stats are returned in a columnar layout: the
+ * <code>domains</code> property holds the domain names, and each property of
+ * <code>stats</code> is a <code>Float64Array</code> named after the stats
+ * field (e.g. <code>cpu.time</code>, <code>balloon.current</code>) whose
+ * i-th element belongs to the i-th domain. Fields a domain does not report
+ * are <code>NaN</code>, string fields are omitted.</p>
+ * 
+ * @param stats {Number}
+ *        bitwise OR of the virDomainStatsTypes constants, 0 for all
+ *        supported stats, optional
+ * @param flags {Number}
+ *        bitwise OR of the virConnectGetAllDomainStatsFlags constants,
+ *        optional
+ * @return {Object}
+ * @throws {Error}
+ * @function Connection#getAllDomainStats
+ */
+
+/**
+ * Pins the vCPUs and emulator threads of many domains at once, e.g. to
+ * apply the pinning plan of a whole host.
+ * 
+ * <p>Each entry of the plan has the <code>domain</code>, an optional array
+ * <code>vcpus</code> with the CPU map of every vCPU to pin (null to leave
+ * a vCPU alone) and an optional <code>emulator</code> CPU map. A CPU map
+ * is a <code>Uint8Array</code> as returned by
+ * {@link Connection#getNodeCPUMap} or an array of CPU numbers. All
+ * pinnings are applied in a single operation off the event loop. A
+ * failing pinning does not stop the others; the result has the number of
+ * <code>applied</code> pinnings and the <code>failed</code> ones, each
+ * with the <code>index</code> of the entry, its <code>vcpu</code> or
+ * <code>emulator: true</code>, and the <code>error</code>.</p>
+ * 
+ * @param plan {Array}
+ *        the pinnings of the domains of this connection
+ * @param flags {Number}
+ *        bitwise-OR of virDomainModificationImpact, optional
+ * @return {Object}
+ * @throws {Error}
+ * @function Connection#applyCPUPinning
+ */
+
 /**
  * Returns a possibly-filtered list of all domains
  * 
+ * <p>Each element is an object with the <code>domain</code> handle and its
+ * <code>name</code>, <code>uuid</code>, <code>state</code> (one of the
+ * virDomainState constants, -1 if unknown) and <code>id</code> (-1 if the
+ * domain is inactive), so no further lookup is needed per domain.</p>
+ * 
  * @param flags {Number}
+ *        bitwise OR of the virConnectListAllDomainsFlags constants, 0 for
+ *        all domains, optional
  * @return {Array}
  * @throws {Error}
+ * @function Connection#listAllDomains
+ */
+
+/**
+ * Starts mirroring the states of all domains of the connection.
+ * 
+ * <p>The states are read once and kept current by the lifecycle events,
+ * delivered by the libvirt event loop of the module, so that
+ * {@link Connection#lookupMirroredDomainStateByUUID},
+ * {@link Connection#lookupMirroredDomainStateByName} and
+ * {@link Connection#listMirroredDomainStates} are answered without any
+ * call to the hypervisor. They throw until the states have been read. The
+ * mirror ends with {@link Connection#unmirrorDomainStates} or when the
+ * connection is closed. Once the connection is found dead, the queries
+ * throw instead of returning stale states.</p>
+ * 
+ * @return {Number} the generation of the mirrored states
+ * @throws {Error}
+ * @function Connection#mirrorDomainStates
+ */
+
+/**
+ * Stops mirroring the states of the domains
+ * 
+ * @throws {Error}
+ * @function Connection#unmirrorDomainStates
+ */
+
+/**
+ * Returns the mirrored state of a domain, an object with its
+ * <code>uuid</code>, <code>name</code>, <code>state</code> (one of the
+ * virDomainState constants) and whether it is <code>persistent</code>
+ * 
+ * @param uuid {String}
+ *        the UUID of the domain
+ * @return {Object} the state, null if there is no such domain
+ * @throws {Error}
+ * @function Connection#lookupMirroredDomainStateByUUID
+ */
+
+/**
+ * Returns the mirrored state of a domain, see
+ * {@link Connection#lookupMirroredDomainStateByUUID}
+ * 
+ * @param name {String}
+ *        the name of the domain
+ * @return {Object} the state, null if there is no such domain
+ * @throws {Error}
+ * @function Connection#lookupMirroredDomainStateByName
+ */
+
+/**
+ * Returns the mirrored states of the domains, see
+ * {@link Connection#lookupMirroredDomainStateByUUID}
+ * 
+ * @param states {Array}
+ *        the virDomainState constants to filter by, or a single one,
+ *        optional
+ * @return {Array} the states of the domains
+ * @throws {Error}
+ * @function Connection#listMirroredDomainStates
+ */
+
+/**
+ * Returns the generation of the mirrored states, which changes whenever
+ * any of them does. Comparing it with an earlier value tells whether the
+ * states need to be read again.
+ * 
+ * @return {Number}
+ * @throws {Error}
+ * @function Connection#getMirroredDomainStateGeneration
+ */
+
+/**
+ * Returns what changed in the inventory of the connection since the last
+ * call: the domains, interfaces, networks and storage pools which have
+ * been added or removed, or whose XML description changed.
+ * 
+ * <p>The first call reports every object as added. The descriptions are
+ * read and hashed off the event loop; the kinds with events are only
+ * read again where the events say something happened, the scan of a kind
+ * is <code>'full'</code>, <code>'partial'</code> or <code>'skipped'</code>
+ * then. Interfaces have no events and are always read completely.</p>
+ * 
+ * <p>If the scan of a kind fails its message is reported in
+ * <code>errors</code>, and its changes are reported by the next call.</p>
+ * 
+ * @param options {Object}
+ *        <code>types</code>, the kinds to diff out of
+ *        <code>'domain'</code>, <code>'interface'</code>,
+ *        <code>'network'</code> and <code>'storagePool'</code>, all of
+ *        them by default, and <code>full</code> to read every object
+ *        again regardless of the events, optional
+ * @return {Object} the <code>changes</code>, each with its
+ *         <code>type</code>, <code>key</code> (the UUID, or the name of an
+ *         interface), <code>name</code>, <code>change</code>
+ *         (<code>'added'</code>, <code>'removed'</code> or
+ *         <code>'changed'</code>) and the <code>hash</code> of the
+ *         description unless removed, the <code>scans</code> by kind and
+ *         the <code>errors</code> by kind if any
+ * @throws {Error}
+ * @function Connection#diffInventory
+ */
+
+/**
+ * Drops the inventory of the connection, the next
+ * {@link Connection#diffInventory} reports every object as added
+ * 
+ * @throws {Error}
+ * @function Connection#resetInventory
  */
-Connection.prototype.listAllDomains = function() {
-    return virt.virConnectListAllDomains.apply(virt, arguments);
-};
 
 /**
  * Returns the defined but inactive domains
@@ -773,35 +1148,50 @@ Connection.prototype.defineDomainXMLFlags = function() {
 };
 
 /**
- * Adds a callback to receive notifications of domain lifecycle events
- * occurring on a connection. This function requires that an event loop has
- * been previously registered
+ * Releases the domain handle right away instead of when it is garbage
+ * collected, the handle must not be used afterwards. Calls still in flight
+ * complete normally. Also available as <code>Symbol.dispose</code>.
+ * 
+ * @function Domain#free
  */
-Domain.prototype.addEventListener = function(domainEventCallback, opaque) {
-    return virt.virConnectDomainEventRegister.apply(virt, arguments);
-};
 
 /**
- * Removes a callback previously registered
+ * Adds a callback to receive notifications of lifecycle events of this
+ * domain.
+ * 
+ * <p>Events are delivered in batches: the callback is invoked at most once
+ * per event loop iteration with an array of all events received since the
+ * last invocation, each of them being an object with the <code>domain</code>,
+ * <code>eventID</code>, <code>event</code> and <code>detail</code>
+ * properties</p>
  * 
  * @param domainEventCallback {Function}
  *        callback to the function handling domain events
+ * @return {Number} the callback identifier
  * @throws {Error}
+ * @function Domain#addEventListener
  */
-Domain.prototype.removeEventListener = function(domainEventCallback) {
-    return virt.virConnectDomainEventDeregister.apply(virt, arguments);
-};
 
 /**
- * Removes an event callback
+ * Removes a callback previously registered with
+ * {@link Domain#addEventListener()}
  * 
- * @param callbackId
- *        the callback identifier
+ * @param domainEventCallback {Function|Number}
+ *        callback to the function handling domain events, or its
+ *        identifier
  * @throws {Error}
+ * @function Domain#removeEventListener
+ */
+
+/**
+ * Removes an event callback by its identifier only
+ * 
+ * @param callbackId {Number}
+ *        the callback identifier returned by
+ *        {@link Domain#addEventListener()}
+ * @throws {Error}
+ * @function Domain#removeEventListenerAny
  */
-Domain.prototype.removeEventListenerAny = function(callbackId) {
-    return virt.virConnectDomainEventDeregisterAny.apply(virt, arguments);
-};
 
 /**
  * Create a virtual device attachment to backend
@@ -967,10 +1357,8 @@ Domain.prototype.getBlockStats = function() {
  * @param flags {Number}
  *        bitwise-OR of virTypedParameterFlags
  * @return {Array}
+ * @function Domain#getBlockStatsParameters
  */
-Domain.prototype.getBlockStatsParameters = function() {
-    return virt.virDomainBlockStatsFlags.apply(virt, arguments);
-};
 
 /**
  * Dump the core of a domain on a given file for analysis
@@ -1105,10 +1493,8 @@ Domain.prototype.getAutostart = function() {
  *        bitwise-OR of virDomainModificationImpact and virTypedParameterFlags
  * @return {Array} blkio parameter object
  * @throws {Error}
+ * @function Domain#getBlkioParameters
  */
-Domain.prototype.getBlkioParameters = function() {
-    return virt.virDomainGetBlkioParameters.apply(virt, arguments);
-};
 
 /**
  * Returns information about a domain's block device.
@@ -1131,10 +1517,8 @@ Domain.prototype.getBlockInfo = function() {
  *        bitwise-OR of virDomainModificationImpact and virTypedParameterFlags
  * @return {Array} blkio parameter objects
  * @throws {Error}
+ * @function Domain#getBlockIoTune
  */
-Domain.prototype.getBlockIoTune = function() {
-    return virt.virDomainGetBlockIoTune.apply(virt, arguments);
-};
 
 /**
  * Request block job information for the given disk
@@ -1196,18 +1580,16 @@ Domain.prototype.getDiskErrors = function() {
 };
 
 /**
- * Query the CPU affinity setting of all emulator threads of domain, store it
- * in cpumap.
+ * Query the CPU affinity setting of all emulator threads of domain
  * 
  * @param flags {Number}
  *        bitwise-OR of virDomainModificationImpact Must not be
  *        VIR_DOMAIN_AFFECT_LIVE and VIR_DOMAIN_AFFECT_CONFIG concurrently.
- * @return {Array}
+ * @return {Uint8Array} the CPU map of the emulator threads, null if they
+ *         are not pinned
  * @throws {Error}
+ * @function Domain#getEmulatorPinInfo
  */
-Domain.prototype.getEmulatorPinInfo = function() {
-    return virt.virDomainGetEmulatorPinInfo.apply(virt, arguments);
-};
 
 /**
  * Return a list of mapping information for each mounted file systems within
@@ -1260,10 +1642,8 @@ Domain.prototype.getIOThreadInfo = function() {
  *        bitwise-OR of virDomainModificationImpact and virTypedParameterFlags
  * @return {Array} typed parameters
  * @throws {Error}
+ * @function Domain#getInterfaceParameters
  */
-Domain.prototype.getInterfaceParameters = function() {
-    return virt.virDomainGetInterfaceParameters.apply(virt, arguments);
-};
 
 /**
  * Returns information about progress of a background job on a domain.
@@ -1314,10 +1694,8 @@ Domain.prototype.getMaxVcpus = function() {
  *        bitwise-OR of virDomainModificationImpact and virTypedParameterFlags
  * @return {Array} typed parameters
  * @throws {Error}
+ * @function Domain#getMemoryParameters
  */
-Domain.prototype.getMemoryParameters = function() {
-    return virt.virDomainGetMemoryParameters.apply(virt, arguments);
-};
 
 /**
  * Returns the appropriate domain element
@@ -1351,10 +1729,8 @@ Domain.prototype.getName = function() {
  *        bitwise-OR of virDomainModificationImpact and virTypedParameterFlags
  * @return {Array} typed parameters
  * @throws {Error}
+ * @function Domain#getNumaParameters
  */
-Domain.prototype.getNumaParameters = function() {
-    return virt.virDomainGetNumaParameters.apply(virt, arguments);
-};
 
 /**
  * Returns the type of domain operation system.
@@ -1373,10 +1749,8 @@ Domain.prototype.getOSType = function() {
  *        bitwise-OR of virDomainModificationImpact and virTypedParameterFlags
  * @return {Array} typed parameters
  * @throws {Error}
+ * @function Domain#getSchedulerParameters
  */
-Domain.prototype.getSchedulerParameters = function() {
-    return virt.virDomainGetSchedulerParametersFlags.apply(virt, arguments);
-};
 
 /**
  * Returns the scheduler type
@@ -1448,19 +1822,16 @@ Domain.prototype.getUUIDString = function() {
 /**
  * Returns the CPU affinity setting of all virtual CPUs of domain
  * 
- * @param ncpumaps
- *        the number of cpumap
- * @param manlen
- *        the number of bytes in one cpumap
+ * <p>The CPU maps of the vCPUs are <code>Uint8Array</code> views of a
+ * single buffer, with a bit per CPU of the host.</p>
+ * 
  * @param flags
  *        bitwise-OR of virDomainModificationImpact Must not be
  *        VIR_DOMAIN_AFFECT_LIVE and VIR_DOMAIN_AFFECT_CONFIG concurrently.
- * @return {Array} the virtual CPUs
+ * @return {Array} the CPU map of every virtual CPU
  * @throws {Error}
+ * @function Domain#getVcpuPinInfo
  */
-Domain.prototype.getVcpuPinInfo = function() {
-    return virt.virDomainGetVcpuPinInfo.apply(virt, arguments);
-};
 
 /**
  * Returns the information about virtual CPUs of domain
@@ -1490,14 +1861,22 @@ Domain.prototype.getVcpusFlags = function() {
 /**
  * Returns the XML description of the domain
  * 
+ * <p>With selectors, the document is scanned natively and only the selected
+ * values are returned, so the XML never enters the JS heap.</p>
+ * 
  * @param flags {Number}
  *        bitwise-OR of virDomainXMLFlags
- * @return {String}
+ * @param selectors {Array}
+ *        paths of the values to extract instead of returning the whole
+ *        document, e.g. <code>/domain/devices/disk/source/@file</code>; a path ends
+ *        with <code>@name</code> to select an attribute, starts with
+ *        <code>//</code> to match at any depth and may use <code>*</code>
+ *        for any element. Optional
+ * @return {String|Object} the XML string, or the arrays of the values keyed
+ *         by selector
  * @throws {Error}
+ * @function Domain#getXMLDesc
  */
-Domain.prototype.getXMLDesc = function() {
-    return virt.virDomainGetXMLDesc.apply(virt, arguments);
-};
 
 /**
  * Check if a domain has a managed save image as created by
@@ -1701,54 +2080,129 @@ Domain.prototype.setAutostart = function() {
 };
 
 /**
- * Sets the appropriate domain element given by type to the value of metadata
+ * Change all or a subset of the blkio tunables
  * 
- * @param type {Number}
- *        type of metadata, from virDomainMetadataType
- * @param metadata {String}
-          new metadata text
- * @param key {String}
-          XML namespace key, or null
- * @param uri {String}
- *        XML namespace URI, or null
+ * <p>The parameters of all the setters are
+ * <code>{ type, field, value }</code> objects as returned by the matching
+ * getters, with <code>type</code> one of the virTypedParameterType
+ * constants.</p>
+ * 
+ * @param params {Array}
+ *        blkio parameter objects
  * @param flags {Number}
- *        bitwise-OR of virDomainModificationImpact
+ *        bitwise-OR of virDomainModificationImpact, optional
  * @throws {Error}
+ * @function Domain#setBlkioParameters
  */
-Domain.prototype.setMetadata = function() {
-    return virt.virDomainSetMetadata.apply(virt, arguments);
-};
 
 /**
- * When a domain is suspended or restored from a file the domain's OS has no
- * idea that there was a big gap in the time. Depending on how long the gap
- * was, NTP might not be able to resynchronize the guest.
+ * Change the I/O tunables for a block device
  * 
- * @param nanoseconds {Number}
- *        time to set, in nanoseconds
+ * @param disk {String}
+ *        path to the block device, or device shorthand
+ * @param params {Array}
+ *        block I/O tune parameter objects
  * @param flags {Number}
- *        bitwise-OR of virDomainSetTimeFlags
+ *        bitwise-OR of virDomainModificationImpact, optional
  * @throws {Error}
+ * @function Domain#setBlockIoTune
  */
-Domain.prototype.setTime = function() {
-    return virt.virDomainSetTime.apply(virt, arguments);
-};
 
 /**
- * Shutdown a domain
+ * Change a subset or all parameters of interface
  * 
+ * @param device {String}
+ *        the interface name or mac address
+ * @param params {Array}
+ *        interface parameter objects
  * @param flags {Number}
- *        bitwise-OR of virDomainShutdownFlagValues
+ *        bitwise-OR of virDomainModificationImpact, optional
  * @throws {Error}
+ * @function Domain#setInterfaceParameters
  */
-Domain.prototype.shutdown = function() {
-    return virt.virDomainShutdownFlags.apply(virt, arguments);
-};
 
 /**
- * Suspends an active domain, the process is frozen without further access to
- * CPU resources and I/O but the memory used by the domain at the hypervisor
- * level will stay allocated
+ * Change all or a subset of the memory tunables
+ * 
+ * @param params {Array}
+ *        memory parameter objects
+ * @param flags {Number}
+ *        bitwise-OR of virDomainModificationImpact, optional
+ * @throws {Error}
+ * @function Domain#setMemoryParameters
+ */
+
+/**
+ * Change all or a subset of the numa tunables
+ * 
+ * @param params {Array}
+ *        numa parameter objects
+ * @param flags {Number}
+ *        bitwise-OR of virDomainModificationImpact, optional
+ * @throws {Error}
+ * @function Domain#setNumaParameters
+ */
+
+/**
+ * Change the scheduler parameters
+ * 
+ * @param params {Array}
+ *        scheduler parameter objects
+ * @param flags {Number}
+ *        bitwise-OR of virDomainModificationImpact, optional
+ * @throws {Error}
+ * @function Domain#setSchedulerParameters
+ */
+
+/**
+ * Sets the appropriate domain element given by type to the value of metadata
+ * 
+ * @param type {Number}
+ *        type of metadata, from virDomainMetadataType
+ * @param metadata {String}
+          new metadata text
+ * @param key {String}
+          XML namespace key, or null
+ * @param uri {String}
+ *        XML namespace URI, or null
+ * @param flags {Number}
+ *        bitwise-OR of virDomainModificationImpact
+ * @throws {Error}
+ */
+Domain.prototype.setMetadata = function() {
+    return virt.virDomainSetMetadata.apply(virt, arguments);
+};
+
+/**
+ * When a domain is suspended or restored from a file the domain's OS has no
+ * idea that there was a big gap in the time. Depending on how long the gap
+ * was, NTP might not be able to resynchronize the guest.
+ * 
+ * @param nanoseconds {Number}
+ *        time to set, in nanoseconds
+ * @param flags {Number}
+ *        bitwise-OR of virDomainSetTimeFlags
+ * @throws {Error}
+ */
+Domain.prototype.setTime = function() {
+    return virt.virDomainSetTime.apply(virt, arguments);
+};
+
+/**
+ * Shutdown a domain
+ * 
+ * @param flags {Number}
+ *        bitwise-OR of virDomainShutdownFlagValues
+ * @throws {Error}
+ */
+Domain.prototype.shutdown = function() {
+    return virt.virDomainShutdownFlags.apply(virt, arguments);
+};
+
+/**
+ * Suspends an active domain, the process is frozen without further access to
+ * CPU resources and I/O but the memory used by the domain at the hypervisor
+ * level will stay allocated
  * 
  * @throws {Error}
  */
@@ -1780,6 +2234,14 @@ Domain.prototype.updateDevice = function() {
     return virt.virDomainUpdateDeviceFlags.apply(virt, arguments);
 };
 
+/**
+ * Releases the interface handle right away instead of when it is garbage
+ * collected, the handle must not be used afterwards. Calls still in flight
+ * complete normally. Also available as <code>Symbol.dispose</code>.
+ * 
+ * @function Interface#free
+ */
+
 /**
  * Activate an interface (i.e. call "ifup")
  * 
@@ -1833,10 +2295,8 @@ Interface.prototype.getName = function() {
  * 
  * @return {String}
  * @throws {Error}
+ * @function Interface#getXMLDesc
  */
-Interface.prototype.getXMLDesc = function() {
-    return virt.virInterfaceGetXMLDesc.apply(virt, arguments);
-};
 
 /**
  * Determine if the interface is currently running
@@ -1866,30 +2326,466 @@ Interface.prototype.undefine = function() {
     return virt.virInterfaceUndefine.apply(virt, arguments);
 };
 
-(function(prototypes) {
-    for (var i = 0; i < prototypes.length; i++) {
-        var prototype = prototypes[i];
+/**
+ * Returns the storage pools of the connection
+ * 
+ * <p>Each element is an object with the <code>pool</code> handle and its
+ * <code>name</code> and <code>uuid</code>.</p>
+ * 
+ * @param flags {Number}
+ *        bitwise OR of the virConnectListAllStoragePoolsFlags constants, 0
+ *        for all pools, optional
+ * @return {Array}
+ * @throws {Error}
+ * @function Connection#listAllStoragePools
+ */
 
-        for (var name in prototype) {
-            var member = prototype[name];
+/**
+ * Returns the volumes of the pool
+ * 
+ * <p>Each element is an object with the <code>volume</code> handle and its
+ * <code>name</code> and <code>key</code>.</p>
+ * 
+ * @param flags {Number}
+ *        reserved, pass 0, optional
+ * @return {Array}
+ * @throws {Error}
+ * @function StoragePool#listAllVolumes
+ */
+
+/**
+ * Gets the info of every volume of the pool in a single call.
+ * 
+ * <p>The result holds parallel arrays, the i-th element of each belongs to
+ * the same volume: <code>names</code> and <code>keys</code> are arrays of
+ * strings, <code>capacity</code> and <code>allocation</code> are
+ * <code>Float64Array</code>s in bytes and <code>type</code> is an
+ * <code>Int32Array</code> of the virStorageVolType constants. Volumes
+ * deleted while the inventory is taken are left out.</p>
+ * 
+ * @return {Object}
+ * @throws {Error}
+ * @function StoragePool#getVolumeInventory
+ */
+
+/**
+ * Releases the pool handle right away instead of when it is garbage
+ * collected, the handle must not be used afterwards. Calls still in flight
+ * complete normally. Also available as <code>Symbol.dispose</code>.
+ * 
+ * @function StoragePool#free
+ */
+
+/**
+ * Releases the volume handle right away instead of when it is garbage
+ * collected, the handle must not be used afterwards. Calls still in flight
+ * complete normally. Also available as <code>Symbol.dispose</code>.
+ * 
+ * @function StorageVolume#free
+ */
+
+/**
+ * Fetches a storage volume based on its globally unique key
+ * 
+ * @param key {String}
+ *        globally unique key
+ * @return {StorageVolume} the storage volume
+ * @throws {Error}
+ * @function Connection#lookupStorageVolumeByKey
+ */
+
+/**
+ * Fetches a storage volume based on its locally (host) unique path
+ * 
+ * @param path {String}
+ *        locally unique path
+ * @return {StorageVolume} the storage volume
+ * @throws {Error}
+ * @function Connection#lookupStorageVolumeByPath
+ */
+
+/**
+ * Downloads the content of the volume into a local file.
+ * 
+ * <p>The volume is transferred as sparse stream where libvirt supports it
+ * (libvirt 3.4.0 or higher): holes of the volume are skipped in the file,
+ * which is truncated first, instead of being written as zeros. A driver or
+ * daemon without sparse streams gets a plain transfer instead, unless
+ * <code>VIR_STORAGE_VOL_DOWNLOAD_SPARSE_STREAM</code> is passed in the
+ * flags. The transfer runs on the thread pool when a callback is
+ * given.</p>
+ * 
+ * @param path {String}
+ *        the file to write
+ * @param offset {Number}
+ *        position in bytes to start reading from, optional
+ * @param length {Number}
+ *        limit on amount of data to download, 0 for all, optional
+ * @param flags {Number}
+ *        bitwise OR of the virStorageVolDownloadFlags constants, optional
+ * @return {Object} the number of bytes transferred as <code>data</code>
+ *         and skipped as <code>holes</code>
+ * @throws {Error}
+ * @function StorageVolume#download
+ */
+
+/**
+ * Uploads the content of a local file into the volume.
+ * 
+ * <p>The file is transferred as sparse stream where libvirt supports it
+ * (libvirt 3.4.0 or higher): holes of the file are sent as hole markers
+ * instead of zeros. A driver or daemon without sparse streams gets a plain
+ * transfer instead, unless <code>VIR_STORAGE_VOL_UPLOAD_SPARSE_STREAM</code>
+ * is passed in the flags. The transfer runs on the thread pool when a
+ * callback is given.</p>
+ * 
+ * @param path {String}
+ *        the file to read
+ * @param offset {Number}
+ *        position in bytes to start writing to, optional
+ * @param length {Number}
+ *        limit on amount of data to upload, 0 for all, optional
+ * @param flags {Number}
+ *        bitwise OR of the virStorageVolUploadFlags constants, optional
+ * @return {Object} the number of bytes transferred as <code>data</code>
+ *         and skipped as <code>holes</code>
+ * @throws {Error}
+ * @function StorageVolume#upload
+ */
+
+/**
+ * Creates a new non-blocking stream object which can be used to perform
+ * streamed I/O with other public API functions, e.g. volume upload and
+ * download, or a domain console
+ * 
+ * @param flags {Number}
+ *        bitwise OR of the virStreamFlags constants, optional
+ * @return {Stream} the new stream
+ * @throws {Error}
+ * @function Connection#newStream
+ */
+
+/**
+ * Releases the stream right away instead of when it is garbage collected,
+ * the stream must not be used afterwards. Also available as
+ * <code>Symbol.dispose</code>.
+ * 
+ * @function Stream#free
+ */
+
+/**
+ * Receives data from the stream into the buffer
+ * 
+ * @param buffer {Buffer}
+ *        the buffer to receive into
+ * @param offset {Number}
+ *        the offset of the buffer to start at, optional
+ * @param length {Number}
+ *        the maximum number of bytes to receive, optional
+ * @return {Number} the number of bytes received, 0 at the end of the
+ *         stream, or -2 if no data is available yet
+ * @throws {Error}
+ * @function Stream#recv
+ */
 
-            if ('function' !== typeof member)
-                continue;
+/**
+ * Sends the data of the buffer to the stream
+ * 
+ * @param buffer {Buffer}
+ *        the data to send
+ * @param offset {Number}
+ *        the offset of the data, optional
+ * @param length {Number}
+ *        the number of bytes to send, optional
+ * @return {Number} the number of bytes sent, or -2 if the stream can not
+ *         accept data yet
+ * @throws {Error}
+ * @function Stream#send
+ */
 
-            (function(k, v) {
-                this[k] = function() {
-                    var args = Array.prototype.slice.apply(arguments);
-                    args.unshift(this);
-                    return v.apply(this, args);
-                };
-            }).call(prototype, name, member);
+/**
+ * Registers a callback to be notified when the stream becomes readable or
+ * writable, only one callback is supported per stream
+ * 
+ * @param events {Number}
+ *        bitwise OR of the virStreamEventType constants to watch
+ * @param callback {Function}
+ *        invoked with the events which occurred
+ * @throws {Error}
+ * @function Stream#addEventCallback
+ */
+
+/**
+ * Changes the set of events to watch
+ * 
+ * @param events {Number}
+ *        bitwise OR of the virStreamEventType constants to watch
+ * @throws {Error}
+ * @function Stream#updateEventCallback
+ */
+
+/**
+ * Removes the callback registered with {@link Stream#addEventCallback()}
+ * 
+ * @throws {Error}
+ * @function Stream#removeEventCallback
+ */
+
+/**
+ * Indicates that there is no further data to be transmitted on the stream
+ * and waits for the other end to confirm
+ * 
+ * @param callback {Function}
+ *        invoked with the error once the stream is finished, optional
+ * @throws {Error}
+ * @function Stream#finish
+ */
+
+/**
+ * Requests that the in progress data transfer be cancelled abnormally
+ * 
+ * @param callback {Function}
+ *        invoked with the error once the stream is aborted, optional
+ * @throws {Error}
+ * @function Stream#abort
+ */
+
+var VIR_STREAM_EVENT_READABLE = 1;
+var VIR_STREAM_EVENT_WRITABLE = 2;
+var VIR_STREAM_EVENT_ERROR    = 4;
+var VIR_STREAM_EVENT_HANGUP   = 8;
+
+// received data is sliced out of buffers of this size
+var STREAM_POOL_SIZE = 256 * 1024;
+
+// a new buffer is allocated when the current one has less space left
+var STREAM_POOL_MIN_SPACE = 16 * 1024;
+
+function allocBuffer(size) {
+    return Buffer.allocUnsafe ? Buffer.allocUnsafe(size) : new Buffer(size);
+}
+
+/**
+ * Shares the single event callback of a stream between its readable and
+ * writable side, and only watches the events one of them is waiting for
+ * 
+ * @private
+ */
+function StreamWatcher(st) {
+    this.stream = st;
+    this.events = 0;
+    this.registered = false;
+    this.closed = false;
+    this.onreadable = null;
+    this.onwritable = null;
+}
+
+StreamWatcher.get = function(st) {
+    return st._watcher || (st._watcher = new StreamWatcher(st));
+};
+
+StreamWatcher.prototype.set = function(event, handler) {
+    if (VIR_STREAM_EVENT_READABLE === event) {
+        this.onreadable = handler;
+    } else {
+        this.onwritable = handler;
+    }
+
+    var events = (this.onreadable ? VIR_STREAM_EVENT_READABLE : 0)
+               | (this.onwritable ? VIR_STREAM_EVENT_WRITABLE : 0);
+
+    if (this.closed || events === this.events) {
+        return;
+    }
+
+    this.events = events;
+
+    if (this.registered) {
+        this.stream.updateEventCallback(events);
+    } else {
+        this.stream.addEventCallback(events, this.dispatch.bind(this));
+        this.registered = true;
+    }
+};
+
+StreamWatcher.prototype.dispatch = function(events) {
+    var failed = events & (VIR_STREAM_EVENT_ERROR | VIR_STREAM_EVENT_HANGUP);
+    var onreadable = this.onreadable;
+    var onwritable = this.onwritable;
+
+    // the handlers retry the I/O which then reports the end or the error
+    if (onreadable && (failed || (events & VIR_STREAM_EVENT_READABLE))) {
+        onreadable();
+    }
+
+    if (onwritable && (failed || (events & VIR_STREAM_EVENT_WRITABLE))) {
+        onwritable();
+    }
+};
+
+/**
+ * Stops watching and finishes or aborts the stream off the loop, the
+ * callback is invoked with the error once the stream is complete
+ */
+StreamWatcher.prototype.close = function(abort, callback) {
+    callback = callback || function() {};
+
+    if (this.closed) {
+        return process.nextTick(callback, null);
+    }
+
+    this.closed = true;
+    this.onreadable = this.onwritable = null;
+
+    var error = null;
+
+    try {
+        if (this.registered) {
+            this.stream.removeEventCallback();
+        }
+    } catch (e) {
+        error = e;
+    }
+
+    var end = abort ? this.stream.abort : this.stream.finish;
+
+    end.call(this.stream, function(err) {
+        callback(error || err);
+    });
+};
+
+/**
+ * @private
+ */
+function StreamReadable(st, options) {
+    stream.Readable.call(this, options);
+    this._stream = st;
+    this._pool = null;
+    this._poolOffset = 0;
+    this._onreadable = this._read.bind(this);
+}
+
+util.inherits(StreamReadable, stream.Readable);
+
+StreamReadable.prototype._read = function() {
+    var watcher = StreamWatcher.get(this._stream);
+
+    try {
+        for (;;) {
+            if (!this._pool || this._pool.length - this._poolOffset < STREAM_POOL_MIN_SPACE) {
+                this._pool = allocBuffer(STREAM_POOL_SIZE);
+                this._poolOffset = 0;
+            }
+
+            var n = this._stream.recv(this._pool, this._poolOffset);
+
+            if (-2 === n) {
+                watcher.set(VIR_STREAM_EVENT_READABLE, this._onreadable);
+                return;
+            }
+
+            if (0 === n) {
+                watcher.close(false, function(err) {
+                    if (err) {
+                        this.emit('error', err);
+                    } else {
+                        this.push(null);
+                    }
+                }.bind(this));
+                return;
+            }
+
+            // a view of the pool, the data is not copied
+            var chunk = this._pool.slice(this._poolOffset, this._poolOffset + n);
+            this._poolOffset += n;
+
+            if (!this.push(chunk)) {
+                // stop watching until the consumer asks for more
+                watcher.set(VIR_STREAM_EVENT_READABLE, null);
+                return;
+            }
         }
+    } catch (e) {
+        watcher.close(true);
+        this.emit('error', e);
     }
-})([
-    Connection.prototype,
-    Domain.prototype,
-    Interface.prototype,
-]);
+};
+
+/**
+ * @private
+ */
+function StreamWritable(st, options) {
+    stream.Writable.call(this, options);
+    this._stream = st;
+}
+
+util.inherits(StreamWritable, stream.Writable);
+
+StreamWritable.prototype._write = function(chunk, encoding, callback) {
+    var st = this._stream;
+    var watcher = StreamWatcher.get(st);
+    var offset = 0;
+
+    (function send() {
+        try {
+            while (offset < chunk.length) {
+                var n = st.send(chunk, offset, chunk.length - offset);
+
+                if (-2 === n) {
+                    // the callback is held back until libvirt accepts the
+                    // rest, which makes the writer buffer up and back off
+                    watcher.set(VIR_STREAM_EVENT_WRITABLE, send);
+                    return;
+                }
+
+                offset += n;
+            }
+
+            watcher.set(VIR_STREAM_EVENT_WRITABLE, null);
+        } catch (e) {
+            watcher.close(true);
+            return callback(e);
+        }
+
+        callback();
+    })();
+};
+
+StreamWritable.prototype._final = function(callback) {
+    StreamWatcher.get(this._stream).close(false, callback);
+};
+
+/**
+ * Returns a readable node stream of the data received from the stream.
+ * 
+ * <p>Data is received into preallocated buffers and handed out as slices
+ * of them without copying. The stream is only watched for readability
+ * while the consumer wants more data, and is finished once all data has
+ * been received.</p>
+ * 
+ * @param options {Object}
+ *        the options of <code>stream.Readable</code>, optional
+ * @return {stream.Readable}
+ */
+Stream.prototype.createReadStream = function(options) {
+    return new StreamReadable(this, options);
+};
+
+/**
+ * Returns a writable node stream which sends the written data to the
+ * stream.
+ * 
+ * <p>Written buffers are sent without copying, a write completes once
+ * libvirt accepted all of its data so the writer backs off while the
+ * stream is not writable. The stream is finished when the writer ends.</p>
+ * 
+ * @param options {Object}
+ *        the options of <code>stream.Writable</code>, optional
+ * @return {stream.Writable}
+ */
+Stream.prototype.createWriteStream = function(options) {
+    return new StreamWritable(this, options);
+};
 
 /**
  * @see {@link https://libvirt.org/html/libvirt-libvirt-host.html#virConnectAuth}
@@ -1996,6 +2892,185 @@ function PageAllocation() {
 
 }
 
+// explicit resource management, e.g. `using conn = Connection.open(uri)`
+if ('undefined' !== typeof Symbol && 'symbol' === typeof Symbol.dispose) {
+    // closing a closed connection does nothing
+    Connection.prototype[Symbol.dispose] = function() {
+        this.close();
+    };
+
+    [Domain, Interface, StoragePool, StorageVolume, Stream].forEach(function(clazz) {
+        clazz.prototype[Symbol.dispose] = clazz.prototype.free;
+    });
+}
+
+/**
+ * The native methods replaced by {@link timerify}
+ */
+var timerified = null;
+
+/**
+ * Wraps the native methods with <code>performance.timerify()</code>, so that
+ * every call is reported as <code>function</code> entry to perf_hooks
+ * observers and to the <code>node.perf.timerify</code> trace events
+ * category. Asynchronous calls are only timed until they are queued.
+ * 
+ * @param enable {Boolean}
+ *        whether to wrap or to restore the methods
+ * @private
+ */
+function timerify(enable) {
+    if (!enable === !timerified) {
+        return;
+    }
+
+    if (timerified) {
+        timerified.forEach(function(method) {
+            method.proto[method.name] = method.fn;
+        });
+        timerified = null;
+        return;
+    }
+
+    var performance = require('perf_hooks').performance;
+    var classes = {
+        Connection    : Connection,
+        Domain        : Domain,
+        Interface     : Interface,
+        StoragePool   : StoragePool,
+        StorageVolume : StorageVolume,
+        Stream        : Stream
+    };
+
+    timerified = [];
+
+    Object.keys(classes).forEach(function(clazz) {
+        var proto = classes[clazz].prototype;
+
+        Object.getOwnPropertyNames(proto).forEach(function(name) {
+            var fn = proto[name];
+
+            if ('constructor' === name || 'function' !== typeof fn
+                    || !/\[native code\]/.test(Function.prototype.toString.call(fn))) {
+                return;
+            }
+
+            var wrapper = function() {
+                return fn.apply(this, arguments);
+            };
+
+            Object.defineProperty(wrapper, 'name', { value: clazz + '#' + name });
+            proto[name] = performance.timerify(wrapper);
+            timerified.push({ proto: proto, name: name, fn: fn });
+        });
+    });
+}
+
+// number of bits set per byte value
+var POPCOUNT = new Uint8Array(256);
+
+for (var i = 1; i < 256; i++) {
+    POPCOUNT[i] = (i & 1) + POPCOUNT[i >> 1];
+}
+
+/**
+ * Helpers for CPU maps, the <code>Uint8Array</code> bitsets used by libvirt
+ * where CPU <code>n</code> is bit <code>n % 8</code> of byte
+ * <code>n / 8</code>
+ */
+var CPUMap = {
+
+    /**
+     * Creates an empty map
+     * 
+     * @param ncpus {Number}
+     *        the number of CPUs
+     * @return {Uint8Array}
+     */
+    create : function(ncpus) {
+        return new Uint8Array((ncpus + 7) >> 3);
+    },
+
+    /**
+     * Creates a map of the given CPUs
+     * 
+     * @param cpus {Array}
+     *        the CPU numbers
+     * @param ncpus {Number}
+     *        the number of CPUs, optional
+     * @return {Uint8Array}
+     */
+    from : function(cpus, ncpus) {
+        var max = -1;
+
+        for (var i = 0; i < cpus.length; i++) {
+            max = Math.max(max, cpus[i]);
+        }
+
+        var map = CPUMap.create(Math.max(ncpus || 0, max + 1));
+
+        for (var j = 0; j < cpus.length; j++) {
+            map[cpus[j] >> 3] |= 1 << (cpus[j] & 7);
+        }
+
+        return map;
+    },
+
+    /**
+     * @return {Boolean} whether the CPU is in the map
+     */
+    has : function(map, cpu) {
+        return 0 !== (map[cpu >> 3] & (1 << (cpu & 7)));
+    },
+
+    set : function(map, cpu) {
+        map[cpu >> 3] |= 1 << (cpu & 7);
+    },
+
+    clear : function(map, cpu) {
+        map[cpu >> 3] &= ~(1 << (cpu & 7));
+    },
+
+    /**
+     * @return {Number} the number of CPUs in the map
+     */
+    count : function(map) {
+        var n = 0;
+
+        for (var i = 0; i < map.length; i++) {
+            n += POPCOUNT[map[i]];
+        }
+
+        return n;
+    },
+
+    /**
+     * Calls <code>fn(cpu)</code> for every CPU in the map in ascending
+     * order, skipping empty bytes
+     */
+    forEach : function(map, fn) {
+        for (var i = 0; i < map.length; i++) {
+            for (var bits = map[i]; 0 !== bits; bits &= bits - 1) {
+                fn((i << 3) + POPCOUNT[(bits & -bits) - 1]);
+            }
+        }
+    },
+
+    /**
+     * @return {Array} the CPU numbers in the map
+     */
+    toArray : function(map) {
+        var cpus = [];
+
+        CPUMap.forEach(map, function(cpu) {
+            cpus.push(cpu);
+        });
+
+        return cpus;
+    }
+
+};
+
 (function() {
 
     /**
@@ -2007,9 +3082,66 @@ function PageAllocation() {
         return virt.virGetVersion.apply(virt, arguments);
     };
 
+    /**
+     * Enables or disables the instrumentation of the native calls.
+     * 
+     * <p>While enabled, every native function counts its calls and errors
+     * and records the latency of the calls, the time spent in libvirt and
+     * the time spent converting between JS and C into histograms, see
+     * {@link getStats}. The time in libvirt is only known for the calls
+     * made by workers, i.e. the methods accepting a callback; for the other
+     * functions it is counted as conversion time. Disabled, the
+     * instrumentation costs a branch per call.</p>
+     * 
+     * @param enabled {Boolean}
+     *        whether to instrument the calls
+     * @param options {Object}
+     *        <code>perfHooks</code> to report the calls of the class
+     *        methods to perf_hooks and trace events as well, optional
+     * @return {Boolean} whether the instrumentation was enabled before
+     * @throws {Error}
+     */
+    this.setInstrumentation = function(enabled, options) {
+        timerify(enabled && options && options.perfHooks);
+        return virt.setInstrumentation(!!enabled);
+    };
+
+    /**
+     * Returns the statistics of the instrumented calls since the last reset,
+     * keyed by the name of the function, e.g. <code>virGetVersion</code> or
+     * <code>Connection#getHostname</code>. Each entry has the number of
+     * <code>calls</code> and <code>errors</code>, and the histograms
+     * <code>latency</code>, <code>libvirt</code> and <code>v8</code> with
+     * <code>count</code>, <code>mean</code>, <code>min</code>,
+     * <code>max</code>, <code>p50</code>, <code>p90</code>, <code>p99</code>
+     * and <code>p999</code> in microseconds.
+     * 
+     * @return {Object} the statistics of the functions called
+     */
+    this.getStats = function() {
+        return virt.getStats();
+    };
+
+    /**
+     * Clears the statistics of the instrumented calls
+     */
+    this.resetStats = function() {
+        return virt.resetStats();
+    };
+
+    this.CPUMap = CPUMap;
+
     this.Connection = Connection;
 
+    this.Domain = Domain;
+
     this.Interface = Interface;
 
+    this.StoragePool = StoragePool;
+
+    this.StorageVolume = StorageVolume;
+
+    this.Stream = Stream;
+
 }).call(module.exports);
 
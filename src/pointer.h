@@ -1,10 +1,17 @@
 #ifndef __POINTER_H__
 #define __POINTER_H__
 
+// libvirt
+#include <libvirt/libvirt.h>
+
+// node
 #include <node.h>
 #include <node_object_wrap.h>
+#include <uv.h>
 
 #include "virt-error.h"
+#include "virt-instance.h"
+#include "virt-stats.h"
 
 #define TRACE() printf("%s#%d\n", __FUNCTION__, __LINE__)
 
@@ -13,11 +20,6 @@
         if ((args).Length() < (argc)) {                          \
             virt::throwError((isolate), "Too few arguments");    \
             return;                                              \
-        }                                                        \
-                                                                 \
-        if (!(args)[0]->IsObject()) {                            \
-            virt::throwTypeError((isolate), "Invalid arguments");\
-            return;                                              \
         }                                                        \
     } while (0);
 
@@ -41,18 +43,157 @@
         }                                                        \
     } while (0);
 
+/**
+ * Describes how the reference held by a wrapper is dropped: the function
+ * releasing it, whether that may block on I/O, and roughly how much native
+ * memory the object keeps alive, which is reported to V8 so that the GC
+ * takes wrappers of expensive objects into account. Ref and Unref take and
+ * drop the additional references of the calls in flight.
+ */
+template <typename T>
+struct PointerTraits;
+
+#define POINTER_TRAITS(type, ref, unref, release, blocking, size)           \
+    template <>                                                             \
+    struct PointerTraits<type> {                                            \
+        static inline int Ref(type ptr) { return ref(ptr); }                \
+        static inline int Unref(type ptr) { return unref(ptr); }            \
+        static inline int Release(type ptr) { return release(ptr); }        \
+        static const bool kBlocking = (blocking);                           \
+        static const int64_t kExternalSize = (size);                        \
+    };
+
+POINTER_TRAITS(virDomainPtr,          virDomainRef,         virDomainFree,         virDomainFree,         false, 1024)
+POINTER_TRAITS(virDomainSnapshotPtr,  virDomainSnapshotRef, virDomainSnapshotFree, virDomainSnapshotFree, false, 1024)
+POINTER_TRAITS(virInterfacePtr,       virInterfaceRef,      virInterfaceFree,      virInterfaceFree,      false, 1024)
+POINTER_TRAITS(virNetworkPtr,         virNetworkRef,        virNetworkFree,        virNetworkFree,        false, 1024)
+POINTER_TRAITS(virNodeDevicePtr,      virNodeDeviceRef,     virNodeDeviceFree,     virNodeDeviceFree,     false, 1024)
+POINTER_TRAITS(virNWFilterPtr,        virNWFilterRef,       virNWFilterFree,       virNWFilterFree,       false, 1024)
+POINTER_TRAITS(virSecretPtr,          virSecretRef,         virSecretFree,         virSecretFree,         false, 1024)
+POINTER_TRAITS(virStoragePoolPtr,     virStoragePoolRef,    virStoragePoolFree,    virStoragePoolFree,    false, 1024)
+POINTER_TRAITS(virStorageVolPtr,      virStorageVolRef,     virStorageVolFree,     virStorageVolFree,     false, 1024)
+POINTER_TRAITS(virStreamPtr,          virStreamRef,         virStreamFree,         virStreamFree,         false, 256 * 1024)
+
+#undef POINTER_TRAITS
+
+/**
+ * Runs a blocking release on the thread pool
+ */
+template <typename T>
+struct DeferredRelease {
+    uv_work_t request;
+    T ptr;
+    int (*release)(T ptr);
+
+    static void Work(uv_work_t *request) {
+        DeferredRelease<T> *self = static_cast<DeferredRelease<T>*>(request->data);
+        self->release(self->ptr);
+    }
+
+    static void After(uv_work_t *request, int status) {
+        delete static_cast<DeferredRelease<T>*>(request->data);
+    }
+
+    /**
+     * Releases the object, on the thread pool if that may block and there
+     * is a loop to defer to, i.e. on the loop thread of a live isolate
+     */
+    static void Run(T ptr, int (*release)(T ptr)) {
+        if (PointerTraits<T>::kBlocking && NULL != virt::Instance::Current()) {
+            DeferredRelease<T> *deferred = new DeferredRelease<T>();
+            deferred->request.data = deferred;
+            deferred->ptr = ptr;
+            deferred->release = release;
+            uv_queue_work(virt::Instance::Current()->loop, &deferred->request, Work, After);
+        } else {
+            release(ptr);
+        }
+    }
+};
+
+namespace virt {
+
+    /**
+     * A reference of a call in flight to the libvirt object it works on,
+     * taken when the call is made and dropped with the worker. Freeing or
+     * closing the wrapper meanwhile only drops the reference of the
+     * wrapper, the object lives on until the call is done.
+     */
+    template <typename T>
+    class Reference {
+    public:
+
+        inline Reference(T ptr = NULL) : ptr(ptr) {
+            if (NULL != ptr) {
+                PointerTraits<T>::Ref(ptr);
+            }
+        }
+
+        inline ~Reference() {
+            if (NULL != this->ptr) {
+                DeferredRelease<T>::Run(this->ptr, PointerTraits<T>::Unref);
+            }
+        }
+
+        inline operator T() const { return this->ptr; }
+
+        /**
+         * Takes a reference of another object instead, for references
+         * which are kept in containers and set after their construction
+         */
+        inline void Reset(T ptr) {
+            if (NULL != ptr) {
+                PointerTraits<T>::Ref(ptr);
+            }
+
+            if (NULL != this->ptr) {
+                DeferredRelease<T>::Run(this->ptr, PointerTraits<T>::Unref);
+            }
+
+            this->ptr = ptr;
+        }
+
+    private:
+
+        Reference(const Reference&);
+
+        Reference& operator=(const Reference&);
+
+        T ptr;
+    };
+
+} // namespace virt
+
 template <typename T>
 class Pointer : public node::ObjectWrap {
 public:
 
+    /**
+     * Installs the prototype methods onto the class template
+     */
+    typedef void (*Initializer)(v8::Local<v8::FunctionTemplate> tpl);
+
+    /**
+     * Exports the class, the prototype methods are native functions with
+     * a signature of the class so they can be called with the instance as
+     * receiver
+     */
     template<class S>
-    inline static void Export(v8::Handle<v8::Object> exports, const char *clazz) {
+    inline static void Export(v8::Handle<v8::Object> exports, const char *clazz, Initializer init = NULL) {
         v8::Isolate *isolate = v8::Isolate::GetCurrent();
         v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, Pointer<T>::New<S>);
         tpl->SetClassName(v8::String::NewFromUtf8(isolate, clazz));
         tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+        if (NULL != init) {
+            virt::stats::SetClass(clazz);
+            init(tpl);
+            virt::stats::SetClass(NULL);
+        }
+
         v8::Local<v8::Function> ctor = tpl->GetFunction();
-        S::constructor.Reset(isolate, ctor);
+        virt::Instance::Current()->SetConstructor<S>(isolate, ctor);
+        virt::Instance::Current()->SetTemplate<S>(isolate, tpl);
         exports->Set(v8::String::NewFromUtf8(isolate, clazz), ctor);
     }
 
@@ -61,7 +202,7 @@ public:
         v8::Isolate *isolate = v8::Isolate::GetCurrent();
         v8::HandleScope scope(isolate);
         v8::Handle<v8::Value> argv[] = { v8::External::New(isolate, t) };
-        v8::Local<v8::Function> ctor = v8::Local<v8::Function>::New(isolate, S::constructor);
+        v8::Local<v8::Function> ctor = virt::Instance::Current()->GetConstructor<S>(isolate);
         args.GetReturnValue().Set(ctor->NewInstance(1, argv));
     }
 
@@ -69,11 +210,68 @@ public:
     inline static v8::Local<v8::Object> NewInstance(T t) {
         v8::Isolate *isolate = v8::Isolate::GetCurrent();
         v8::Handle<v8::Value> argv[] = { v8::External::New(isolate, t) };
-        v8::Local<v8::Function> ctor = v8::Local<v8::Function>::New(isolate, S::constructor);
+        v8::Local<v8::Function> ctor = virt::Instance::Current()->GetConstructor<S>(isolate);
         return ctor->NewInstance(1, argv);
     }
 
-    inline Pointer(T t = NULL) : ptr(t) { }
+    /**
+     * Returns the native object of the value if it is a wrapper of the
+     * class, NULL for anything else including wrappers of other classes
+     */
+    template <class S>
+    inline static S *Cast(v8::Local<v8::Value> value) {
+        v8::Isolate *isolate = v8::Isolate::GetCurrent();
+
+        if (NULL == virt::Instance::Current() || !virt::Instance::Current()->HasInstance<S>(isolate, value)) {
+            return NULL;
+        }
+
+        return node::ObjectWrap::Unwrap<S>(v8::Local<v8::Object>::Cast(value));
+    }
+
+    /**
+     * Releases the libvirt object right away instead of when the wrapper is
+     * collected, the wrapper is null afterwards. Calls in flight hold their
+     * own reference, the object is released once the last of them is done.
+     */
+    template <class S>
+    static void Free(const v8::FunctionCallbackInfo<v8::Value>& args) {
+        S *native = node::ObjectWrap::Unwrap<S>(args.Holder());
+
+        if (NULL != native) {
+            native->Release();
+        }
+    }
+
+    inline Pointer(T t = NULL) : ptr(t) {
+        if (NULL != t) {
+            AdjustExternalMemory(PointerTraits<T>::kExternalSize);
+        }
+    }
+
+    /**
+     * Runs when the wrapper is collected
+     */
+    virtual ~Pointer() {
+        this->Release();
+    }
+
+    /**
+     * Drops the reference of the wrapper, blocking releases go to the
+     * thread pool so neither the GC nor JS ever waits for the daemon
+     */
+    void Release() {
+        T t = this->ptr;
+
+        if (NULL == t) {
+            return;
+        }
+
+        this->SetNull();
+
+        // while the isolate is disposed there is no loop to defer to
+        DeferredRelease<T>::Run(t, PointerTraits<T>::Release);
+    }
 
     inline T operator*() const { return this->ptr; }
 
@@ -91,10 +289,31 @@ public:
 
     inline bool IsNull() const { return NULL == this->ptr; }
 
-    inline void SetNull() { this->ptr = NULL; }
+    /**
+     * Forgets the libvirt object without releasing it, for objects whose
+     * reference has been dropped otherwise
+     */
+    inline void SetNull() {
+        if (NULL != this->ptr) {
+            AdjustExternalMemory(-PointerTraits<T>::kExternalSize);
+            this->ptr = NULL;
+        }
+    }
 
 private:
 
+    /**
+     * Reports the memory kept alive to the isolate, unless it is being
+     * disposed, like the deferred releases
+     */
+    static inline void AdjustExternalMemory(int64_t change) {
+        virt::Instance *instance = virt::Instance::Current();
+
+        if (NULL != instance) {
+            instance->isolate->AdjustAmountOfExternalAllocatedMemory(change);
+        }
+    }
+
     template <class S>
     inline static void New(const v8::FunctionCallbackInfo<v8::Value>& args) {
         v8::Isolate *isolate = v8::Isolate::GetCurrent();
@@ -111,7 +330,7 @@ private:
             args.GetReturnValue().Set(args.This());
         } else {
             v8::Local<v8::Value> argv[] = { args[0] };
-            v8::Local<v8::Function> ctor = v8::Local<v8::Function>::New(isolate, S::constructor);
+            v8::Local<v8::Function> ctor = virt::Instance::Current()->GetConstructor<S>(isolate);
             args.GetReturnValue().Set(ctor->NewInstance(1, argv));
         }
     }
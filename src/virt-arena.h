@@ -0,0 +1,136 @@
+#ifndef __NODE_VIRT_ARENA_H__
+#define __NODE_VIRT_ARENA_H__
+
+// standard c
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// node
+#include <node.h>
+
+namespace virt {
+
+    /**
+     * Bump allocator for the arguments of a single call.
+     *
+     * Memory is handed out from an inline buffer first and from chunks on
+     * the heap once that is exhausted; nothing is freed individually, all
+     * of it goes away with the arena. Embedded into a worker, converting
+     * the arguments of a typical call needs no heap allocation besides the
+     * worker itself.
+     */
+    class Arena {
+    public:
+
+        inline Arena() : chunks(NULL), top(this->inlined), end(this->inlined + sizeof(this->inlined)) {}
+
+        inline ~Arena() {
+            while (NULL != this->chunks) {
+                Chunk *chunk = this->chunks;
+                this->chunks = chunk->next;
+                free(chunk);
+            }
+        }
+
+        /**
+         * Returns <code>size</code> bytes aligned for any type, or NULL if
+         * the memory is exhausted
+         */
+        inline void *Allocate(size_t size) {
+            if (size > SIZE_MAX - kAlignment) {
+                return NULL;
+            }
+
+            size = (size + kAlignment - 1) & ~(kAlignment - 1);
+
+            if (static_cast<size_t>(this->end - this->top) < size && !this->Grow(size)) {
+                return NULL;
+            }
+
+            void *ptr = this->top;
+            this->top += size;
+            return ptr;
+        }
+
+        /**
+         * Returns an array of <code>n</code> zeroed items, or NULL if the
+         * memory is exhausted
+         */
+        template <typename T>
+        inline T *Allocate(size_t n) {
+            if (n > SIZE_MAX / sizeof(T)) {
+                return NULL;
+            }
+
+            T *items = static_cast<T*>(this->Allocate(n * sizeof(T)));
+            if (NULL != items) {
+                memset(items, 0, n * sizeof(T));
+            }
+
+            return items;
+        }
+
+        /**
+         * Encodes the string as NUL terminated UTF-8 straight into the
+         * arena, returns NULL if the memory is exhausted
+         */
+        inline char *Copy(v8::Local<v8::String> str) {
+            int length = str->Utf8Length();
+            char *copy = static_cast<char*>(this->Allocate(length + 1));
+
+            if (NULL == copy) {
+                return NULL;
+            }
+
+            str->WriteUtf8(copy, length + 1);
+            copy[length] = '\0';
+            return copy;
+        }
+
+    private:
+
+        static const size_t kAlignment = 16;
+
+        static const size_t kInlineSize = 1024;
+
+        static const size_t kChunkSize = 8192;
+
+        struct Chunk {
+            Chunk *next;
+            // keeps the data behind the header aligned
+            char padding[kAlignment - sizeof(Chunk*)];
+        };
+
+        Arena(const Arena&);
+
+        Arena& operator=(const Arena&);
+
+        bool Grow(size_t size) {
+            size_t capacity = size > kChunkSize ? size : kChunkSize;
+            Chunk *chunk = static_cast<Chunk*>(malloc(sizeof(Chunk) + capacity));
+
+            if (NULL == chunk) {
+                return false;
+            }
+
+            chunk->next = this->chunks;
+            this->chunks = chunk;
+            this->top = reinterpret_cast<char*>(chunk + 1);
+            this->end = this->top + capacity;
+            return true;
+        }
+
+        Chunk *chunks;
+
+        char *top;
+
+        char *end;
+
+        alignas(kAlignment) char inlined[kInlineSize];
+    };
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_ARENA_H__ */
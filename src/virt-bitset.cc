@@ -0,0 +1,93 @@
+/**
+ * CPU maps for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <string.h>
+
+#include "virt-bitset.h"
+#include "virt-error.h"
+
+// CPU numbers of arrays are rejected from here on rather than allocating
+// a map for them
+static const uint32_t kMaxCPUs = 65536;
+
+namespace virt {
+    namespace bitset {
+
+        v8::Local<v8::Uint8Array> New(v8::Isolate *isolate, const unsigned char *bits, size_t length) {
+            v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, length);
+
+            if (length > 0) {
+                memcpy(buffer->GetContents().Data(), bits, length);
+            }
+
+            return v8::Uint8Array::New(buffer, 0, length);
+        }
+
+        v8::Local<v8::Array> New(v8::Isolate *isolate, const unsigned char *bits, size_t count, size_t length) {
+            v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, count * length);
+            v8::Local<v8::Array> result = v8::Array::New(isolate, count);
+
+            if (count * length > 0) {
+                memcpy(buffer->GetContents().Data(), bits, count * length);
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                result->Set(i, v8::Uint8Array::New(buffer, i * length, length));
+            }
+
+            return result;
+        }
+
+        bool Parse(v8::Isolate *isolate, v8::Local<v8::Value> value, Bits *bits) {
+            bits->clear();
+
+            if (value->IsArrayBufferView()) {
+                v8::Local<v8::ArrayBufferView> view = v8::Local<v8::ArrayBufferView>::Cast(value);
+                bits->resize(view->ByteLength());
+
+                if (!bits->empty()) {
+                    view->CopyContents(&(*bits)[0], bits->size());
+                }
+
+                return true;
+            }
+
+            if (value->IsArrayBuffer()) {
+                v8::ArrayBuffer::Contents contents = v8::Local<v8::ArrayBuffer>::Cast(value)->GetContents();
+                const unsigned char *data = static_cast<const unsigned char*>(contents.Data());
+                bits->assign(data, data + contents.ByteLength());
+                return true;
+            }
+
+            if (value->IsArray()) {
+                v8::Local<v8::Array> cpus = v8::Local<v8::Array>::Cast(value);
+
+                for (uint32_t i = 0; i < cpus->Length(); i++) {
+                    v8::Local<v8::Value> cpu = cpus->Get(i);
+
+                    if (!cpu->IsUint32() || cpu->Uint32Value() >= kMaxCPUs) {
+                        virt::throwTypeError(isolate, "Invalid CPU number");
+                        return false;
+                    }
+
+                    uint32_t n = cpu->Uint32Value();
+                    if (bits->size() <= n / 8) {
+                        bits->resize(n / 8 + 1, 0);
+                    }
+
+                    (*bits)[n / 8] |= 1 << (n % 8);
+                }
+
+                return true;
+            }
+
+            virt::throwTypeError(isolate, "Invalid CPU map");
+            return false;
+        }
+
+    } // namespace bitset
+} // namespace virt
@@ -0,0 +1,42 @@
+#ifndef __NODE_VIRT_BITSET_H__
+#define __NODE_VIRT_BITSET_H__
+
+// standard c++
+#include <vector>
+
+// node
+#include <node.h>
+
+namespace virt {
+    namespace bitset {
+
+        /**
+         * A set of CPUs in the layout of the cpumaps of libvirt, CPU
+         * <code>n</code> is bit <code>n % 8</code> of byte
+         * <code>n / 8</code>
+         */
+        typedef std::vector<unsigned char> Bits;
+
+        /**
+         * Copies the map of <code>length</code> bytes into a new Uint8Array,
+         * the buffer of libvirt stays with the caller
+         */
+        v8::Local<v8::Uint8Array> New(v8::Isolate *isolate, const unsigned char *bits, size_t length);
+
+        /**
+         * Copies <code>count</code> consecutive maps of <code>length</code>
+         * bytes each into a single buffer and returns a Uint8Array view per
+         * map
+         */
+        v8::Local<v8::Array> New(v8::Isolate *isolate, const unsigned char *bits, size_t count, size_t length);
+
+        /**
+         * Reads a map given as typed array, ArrayBuffer or array of CPU
+         * numbers, throws and returns false if the value is none of them
+         */
+        bool Parse(v8::Isolate *isolate, v8::Local<v8::Value> value, Bits *bits);
+
+    } // namespace bitset
+} // namespace virt
+
+#endif /* __NODE_VIRT_BITSET_H__ */
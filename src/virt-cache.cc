@@ -0,0 +1,104 @@
+/**
+ * Query result cache for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// node
+#include <uv.h>
+
+#include "virt-cache.h"
+#include "virt-instance.h"
+
+namespace {
+
+    /**
+     * Freezes the object and the objects it holds, so the callers sharing
+     * a cached result can not change it for each other
+     */
+    static void freeze(v8::Local<v8::Context> context, v8::Local<v8::Value> value) {
+        // the elements of typed arrays can not be frozen
+        if (!value->IsObject() || value->IsArrayBufferView()) {
+            return;
+        }
+
+        v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(value);
+        v8::Local<v8::Array> names;
+
+        if (object->GetOwnPropertyNames(context).ToLocal(&names)) {
+            for (uint32_t i = 0; i < names->Length(); i++) {
+                v8::Local<v8::Value> property;
+
+                if (object->Get(context, names->Get(i)).ToLocal(&property)) {
+                    freeze(context, property);
+                }
+            }
+        }
+
+        object->SetIntegrityLevel(context, v8::IntegrityLevel::kFrozen);
+    }
+
+} // namespace
+
+namespace virt {
+
+    Cache::~Cache() {
+        this->Clear();
+    }
+
+    void Cache::SetTTL(const std::string& query, uint64_t ttl) {
+        this->ttls[query] = ttl;
+    }
+
+    v8::Local<v8::Value> Cache::Get(v8::Isolate *isolate, const std::string& query, const std::string& arg) {
+        if (!this->IsEnabled(query)) {
+            return v8::Local<v8::Value>();
+        }
+
+        std::map<std::string, Entry*>::iterator i = this->entries.find(query + '\0' + arg);
+        if (i == this->entries.end()) {
+            this->misses++;
+            return v8::Local<v8::Value>();
+        }
+
+        // expired entries are dropped rather than kept until the next put
+        if (i->second->expires <= uv_now(Instance::Current()->loop)) {
+            i->second->value.Reset();
+            delete i->second;
+            this->entries.erase(i);
+            this->misses++;
+            return v8::Local<v8::Value>();
+        }
+
+        this->hits++;
+        return v8::Local<v8::Value>::New(isolate, i->second->value);
+    }
+
+    void Cache::Put(v8::Isolate *isolate, const std::string& query, const std::string& arg, v8::Local<v8::Value> value) {
+        std::map<std::string, uint64_t>::iterator ttl = this->ttls.find(query);
+        if (ttl == this->ttls.end() || 0 == ttl->second) {
+            return;
+        }
+
+        std::string key = query + '\0' + arg;
+        Entry *entry = this->entries[key];
+        if (NULL == entry) {
+            entry = this->entries[key] = new Entry();
+        }
+
+        freeze(isolate->GetCurrentContext(), value);
+
+        entry->expires = uv_now(Instance::Current()->loop) + ttl->second;
+        entry->value.Reset(isolate, value);
+    }
+
+    void Cache::Clear() {
+        for (std::map<std::string, Entry*>::iterator i = this->entries.begin(); i != this->entries.end(); ++i) {
+            i->second->value.Reset();
+            delete i->second;
+        }
+
+        this->entries.clear();
+    }
+
+} // namespace virt
@@ -0,0 +1,143 @@
+#ifndef __NODE_VIRT_CACHE_H__
+#define __NODE_VIRT_CACHE_H__
+
+// standard c
+#include <stdint.h>
+
+// standard c++
+#include <map>
+#include <string>
+
+// node
+#include <node.h>
+
+#include "virt-worker.h"
+
+namespace virt {
+
+    /**
+     * Results of slow-changing queries kept for a per-query time to live.
+     *
+     * Only touched on the main thread: lookups happen before a call is
+     * dispatched and results are stored when it completes.
+     */
+    class Cache {
+    public:
+
+        inline Cache() : hits(0), misses(0) {}
+
+        ~Cache();
+
+        /**
+         * Sets the time to live in milliseconds of the query, 0 disables
+         * caching of the query
+         */
+        void SetTTL(const std::string& query, uint64_t ttl);
+
+        /**
+         * Looks up the result of the query with the argument, returns an
+         * empty handle if the query is not cached or the result expired,
+         * which drops it
+         */
+        v8::Local<v8::Value> Get(v8::Isolate *isolate, const std::string& query, const std::string& arg = "");
+
+        /**
+         * Stores the result of the query with the argument, the result is
+         * deeply frozen since every hit returns the same value
+         */
+        void Put(v8::Isolate *isolate, const std::string& query, const std::string& arg, v8::Local<v8::Value> value);
+
+        inline bool IsEnabled(const std::string& query) const {
+            std::map<std::string, uint64_t>::const_iterator i = this->ttls.find(query);
+            return i != this->ttls.end() && i->second > 0;
+        }
+
+        void Clear();
+
+        inline uint64_t GetHits() const { return this->hits; }
+
+        inline uint64_t GetMisses() const { return this->misses; }
+
+        inline size_t GetSize() const { return this->entries.size(); }
+
+    private:
+
+        struct Entry {
+            uint64_t expires;
+            v8::Persistent<v8::Value> value;
+        };
+
+        Cache(const Cache&);
+
+        Cache& operator=(const Cache&);
+
+        std::map<std::string, uint64_t> ttls;
+
+        std::map<std::string, Entry*> entries;
+
+        uint64_t hits;
+
+        uint64_t misses;
+    };
+
+    /**
+     * Completes with a cached result
+     */
+    class CachedWorker : public Worker {
+    public:
+
+        inline CachedWorker(v8::Isolate *isolate, v8::Local<v8::Value> value) {
+            this->value.Reset(isolate, value);
+        }
+
+        virtual ~CachedWorker() {
+            this->value.Reset();
+        }
+
+        virtual void Execute() {}
+
+        virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+            return v8::Local<v8::Value>::New(isolate, this->value);
+        }
+
+    private:
+        v8::Persistent<v8::Value> value;
+    };
+
+    /**
+     * Executes the worker and stores its result into the cache on success
+     */
+    class CachingWorker : public Worker {
+    public:
+
+        inline CachingWorker(Cache *cache, const std::string& query, const std::string& arg, Worker *worker)
+            : cache(cache), query(query), arg(arg), worker(worker) {}
+
+        virtual ~CachingWorker() {
+            delete this->worker;
+        }
+
+        virtual void Execute() {
+            this->worker->Execute();
+
+            if (this->worker->HasError()) {
+                this->SetError(this->worker->GetError());
+            }
+        }
+
+        virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+            v8::Local<v8::Value> value = this->worker->Result(isolate);
+            this->cache->Put(isolate, this->query, this->arg, value);
+            return value;
+        }
+
+    private:
+        Cache *cache;
+        std::string query;
+        std::string arg;
+        Worker *worker;
+    };
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_CACHE_H__ */
@@ -0,0 +1,554 @@
+/**
+ * CPU compatibility matrix for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// standard c++
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// node
+#include <uv.h>
+
+#include "virt-cpu-matrix.h"
+#include "virt-error.h"
+#include "virt-hash.h"
+#include "virt-host.h"
+#include "virt-thread-pool.h"
+#include "virt-worker.h"
+
+/**
+ * Hosts whose CPUs are described alike give the same answers, so every
+ * distinct guest CPU is compared once per distinct host CPU, on any of the
+ * hosts which have it. The answers are kept across calls, keyed by the
+ * hashes of both descriptions, so a changed host CPU is compared afresh.
+ */
+
+namespace {
+
+    // guest and host CPU
+    typedef std::pair<uint64_t, uint64_t> Key;
+
+    // answers kept at most, the memo starts over once full
+    static const size_t kMaxMemo = 65536;
+
+    static const unsigned int kDefaultConcurrency = 16;
+
+    static uv_mutex_t lock;
+
+    static uv_once_t once = UV_ONCE_INIT;
+
+    static std::map<Key, int> memo;
+
+    /**
+     * Drops the whitespace around the document and between elements, which
+     * does not change the description
+     */
+    static std::string normalize(const char *xml, size_t length) {
+        std::string result;
+        result.reserve(length);
+
+        for (size_t i = 0; i < length;) {
+            if (!isspace(static_cast<unsigned char>(xml[i]))) {
+                result += xml[i++];
+                continue;
+            }
+
+            size_t end = i;
+            while (end < length && isspace(static_cast<unsigned char>(xml[end]))) {
+                end++;
+            }
+
+            bool between = !result.empty() && '>' == result[result.size() - 1] && end < length && '<' == xml[end];
+            if (!result.empty() && end < length && !between) {
+                result.append(xml + i, end - i);
+            }
+
+            i = end;
+        }
+
+        return result;
+    }
+
+    /**
+     * Returns the description of the host CPU out of the capabilities, or
+     * all of them if there is none
+     */
+    static std::string getHostCPU(const char *caps) {
+        const char *host = strstr(caps, "<host>");
+        const char *begin = NULL == host ? NULL : strstr(host, "<cpu");
+        const char *end = NULL == begin ? NULL : strstr(begin, "</cpu>");
+
+        if (NULL == end) {
+            return normalize(caps, strlen(caps));
+        }
+
+        return normalize(begin, end + strlen("</cpu>") - begin);
+    }
+
+    static void initialize() {
+        uv_mutex_init(&lock);
+    }
+
+    static std::string getVirtError() {
+        const char *msg = virGetLastErrorMessage();
+        return NULL == msg ? "Unknown error" : msg;
+    }
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+class CompareCPUMatrixWorker : public virt::Worker {
+public:
+    inline CompareCPUMatrixWorker(size_t nhosts, unsigned int flags, bool baseline, unsigned int baselineFlags, unsigned int concurrency)
+        : hosts(nhosts), flags(flags), baseline(baseline), baselineFlags(baselineFlags), concurrency(concurrency),
+          baselineCPU(NULL), compared(0), memoized(0), finished(NULL), instance(NULL) {}
+
+    virtual ~CompareCPUMatrixWorker() {
+        free(this->baselineCPU);
+    }
+
+    /**
+     * Runs a call made without callback, the calling thread waits for the
+     * pool threads
+     */
+    virtual void Execute() {
+        uv_sem_t sem;
+
+        uv_sem_init(&sem, 0);
+        this->finished = &sem;
+        this->Start();
+        uv_sem_wait(&sem);
+        uv_sem_destroy(&sem);
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, this->matrix.size());
+        v8::Local<v8::Array> errors = v8::Array::New(isolate);
+        v8::Local<v8::String> kError = v8::String::NewFromUtf8(isolate, "error");
+
+        if (!this->matrix.empty()) {
+            memcpy(buffer->GetContents().Data(), &this->matrix[0], this->matrix.size());
+        }
+
+        for (size_t j = 0; j < this->hostErrors.size(); j++) {
+            if (!this->hostErrors[j].empty()) {
+                v8::Local<v8::Object> error = v8::Object::New(isolate);
+                error->Set(v8::String::NewFromUtf8(isolate, "host"), v8::Number::New(isolate, j));
+                error->Set(kError, v8::String::NewFromUtf8(isolate, this->hostErrors[j].c_str()));
+                errors->Set(errors->Length(), error);
+            }
+        }
+
+        // one error per guest CPU is enough, it fails the same everywhere
+        std::vector<bool> reported(this->distinctGuests.size(), false);
+
+        for (size_t t = 0; t < this->tasks.size(); t++) {
+            const Task& task = this->tasks[t];
+
+            if (VIR_CPU_COMPARE_ERROR == task.result && !reported[task.guest]) {
+                v8::Local<v8::Object> error = v8::Object::New(isolate);
+                error->Set(v8::String::NewFromUtf8(isolate, "guest"), v8::Number::New(isolate, this->distinctGuests[task.guest]));
+                error->Set(kError, v8::String::NewFromUtf8(isolate, task.error.c_str()));
+                errors->Set(errors->Length(), error);
+                reported[task.guest] = true;
+            }
+        }
+
+        if (this->baseline) {
+            if (NULL != this->baselineCPU) {
+                result->Set(v8::String::NewFromUtf8(isolate, "baseline"), v8::String::NewFromUtf8(isolate, this->baselineCPU));
+            } else {
+                v8::Local<v8::Object> error = v8::Object::New(isolate);
+                error->Set(v8::String::NewFromUtf8(isolate, "baseline"), v8::True(isolate));
+                error->Set(kError, v8::String::NewFromUtf8(isolate, this->baselineError.c_str()));
+                errors->Set(errors->Length(), error);
+                result->Set(v8::String::NewFromUtf8(isolate, "baseline"), v8::Null(isolate));
+            }
+        }
+
+        result->Set(v8::String::NewFromUtf8(isolate, "matrix"), v8::Int8Array::New(buffer, 0, this->matrix.size()));
+        result->Set(v8::String::NewFromUtf8(isolate, "compared"), v8::Number::New(isolate, this->compared));
+        result->Set(v8::String::NewFromUtf8(isolate, "memoized"), v8::Number::New(isolate, this->memoized));
+
+        if (errors->Length() > 0) {
+            result->Set(v8::String::NewFromUtf8(isolate, "errors"), errors);
+        }
+
+        return result;
+    }
+
+    // normalized guest CPUs, filled in by the caller
+    std::vector<std::string> guests;
+
+    // connections set by the caller, NULL for closed ones; dropped with
+    // the worker, on the main thread, so the last reference does not block
+    std::vector<virt::Reference<virConnectPtr> > hosts;
+
+protected:
+
+    /**
+     * Runs a call made with callback on the pool threads, no thread waits
+     * for them and the callback is called once the last phase is done
+     */
+    virtual void Dispatch(virt::Executor *executor) {
+        this->instance = virt::Instance::Current();
+        this->instance->Ref();
+        this->Start();
+    }
+
+private:
+
+    struct Task {
+        // distinct guest CPU and host CPU
+        size_t guest;
+        size_t group;
+        virConnectPtr conn;
+        int result;
+        std::string error;
+    };
+
+    /**
+     * Reads the host CPUs, then compares the guest CPUs with them and
+     * finally builds the matrix, each phase started by the pool thread
+     * which finished the one before
+     */
+    void Start() {
+        this->hostCPUs.resize(this->hosts.size());
+        this->hostErrors.resize(this->hosts.size());
+        virt::threadpool::ForEach(this->hosts.size(), this->concurrency, ReadHost, this, OnRead);
+    }
+
+    static void OnRead(void *data) {
+        CompareCPUMatrixWorker *self = static_cast<CompareCPUMatrixWorker*>(data);
+
+        self->Plan();
+
+        // the baseline runs alongside the comparisons
+        size_t ntasks = self->tasks.size() + (self->baseline && self->groups.size() > 0 ? 1 : 0);
+        virt::threadpool::ForEach(ntasks, self->concurrency, Compare, self, OnCompared);
+    }
+
+    static void OnCompared(void *data) {
+        CompareCPUMatrixWorker *self = static_cast<CompareCPUMatrixWorker*>(data);
+
+        self->Finish();
+
+        if (NULL != self->finished) {
+            uv_sem_post(self->finished);
+            return;
+        }
+
+        // left as is if the isolate is gone, its callback went with it
+        self->instance->Post(OnDone, self);
+    }
+
+    static void OnDone(void *data) {
+        CompareCPUMatrixWorker *self = static_cast<CompareCPUMatrixWorker*>(data);
+
+        self->instance->Unref();
+        self->Complete();
+    }
+
+    /**
+     * Groups the hosts and guests by CPU and queues the comparisons which
+     * are not memoized
+     */
+    void Plan() {
+        size_t nguests = this->guests.size();
+        size_t nhosts = this->hosts.size();
+
+        // the distinct guest CPUs, with the flags as part of their key
+        std::map<std::string, size_t> guestIndex;
+        this->guestOf.resize(nguests);
+
+        for (size_t i = 0; i < nguests; i++) {
+            std::map<std::string, size_t>::iterator it = guestIndex.find(this->guests[i]);
+
+            if (it == guestIndex.end()) {
+                it = guestIndex.insert(std::make_pair(this->guests[i], this->distinctGuests.size())).first;
+                this->distinctGuests.push_back(i);
+                this->guestHashes.push_back(virt::hash::Fnv1a(&this->flags, sizeof(this->flags),
+                        virt::hash::Fnv1a(this->guests[i].data(), this->guests[i].size())));
+            }
+
+            this->guestOf[i] = it->second;
+        }
+
+        // the distinct host CPUs and the hosts which have them
+        std::map<std::string, size_t> groupIndex;
+        this->groupOf.resize(nhosts);
+
+        for (size_t j = 0; j < nhosts; j++) {
+            if (!this->hostErrors[j].empty()) {
+                continue;
+            }
+
+            std::map<std::string, size_t>::iterator it = groupIndex.find(this->hostCPUs[j]);
+
+            if (it == groupIndex.end()) {
+                it = groupIndex.insert(std::make_pair(this->hostCPUs[j], this->groups.size())).first;
+                this->groups.push_back(std::vector<size_t>());
+                this->groupHashes.push_back(virt::hash::Fnv1a(this->hostCPUs[j].data(), this->hostCPUs[j].size()));
+            }
+
+            this->groupOf[j] = it->second;
+            this->groups[it->second].push_back(j);
+        }
+
+        size_t ngroups = this->groups.size();
+        this->answers.assign(this->distinctGuests.size() * ngroups, VIR_CPU_COMPARE_ERROR);
+
+        uv_mutex_lock(&lock);
+
+        for (size_t g = 0; g < this->distinctGuests.size(); g++) {
+            for (size_t h = 0; h < ngroups; h++) {
+                std::map<Key, int>::iterator it = memo.find(Key(this->guestHashes[g], this->groupHashes[h]));
+
+                if (it != memo.end()) {
+                    this->answers[g * ngroups + h] = it->second;
+                    this->memoized++;
+                    continue;
+                }
+
+                // spread the comparisons of a host CPU over its hosts
+                const std::vector<size_t>& group = this->groups[h];
+                Task task = { g, h, this->hosts[group[this->tasks.size() % group.size()]], VIR_CPU_COMPARE_ERROR, "" };
+                this->tasks.push_back(task);
+            }
+        }
+
+        uv_mutex_unlock(&lock);
+    }
+
+    /**
+     * Memoizes the answers and builds the matrix out of them
+     */
+    void Finish() {
+        size_t nguests = this->guests.size();
+        size_t nhosts = this->hosts.size();
+        size_t ngroups = this->groups.size();
+
+        this->compared = this->tasks.size();
+
+        uv_mutex_lock(&lock);
+
+        if (memo.size() + this->tasks.size() > kMaxMemo) {
+            memo.clear();
+        }
+
+        for (size_t t = 0; t < this->tasks.size(); t++) {
+            const Task& task = this->tasks[t];
+            this->answers[task.guest * ngroups + task.group] = task.result;
+
+            if (VIR_CPU_COMPARE_ERROR != task.result) {
+                memo[Key(this->guestHashes[task.guest], this->groupHashes[task.group])] = task.result;
+            }
+        }
+
+        uv_mutex_unlock(&lock);
+
+        this->matrix.resize(nguests * nhosts);
+
+        for (size_t i = 0; i < nguests; i++) {
+            for (size_t j = 0; j < nhosts; j++) {
+                int answer = this->hostErrors[j].empty() ? this->answers[this->guestOf[i] * ngroups + this->groupOf[j]] : VIR_CPU_COMPARE_ERROR;
+                this->matrix[i * nhosts + j] = static_cast<int8_t>(answer);
+            }
+        }
+
+        if (this->baseline && 0 == ngroups) {
+            this->baselineError = "No host to compute the baseline of";
+        }
+    }
+
+    static void ReadHost(void *data, size_t j) {
+        CompareCPUMatrixWorker *self = static_cast<CompareCPUMatrixWorker*>(data);
+
+        if (NULL == self->hosts[j]) {
+            self->hostErrors[j] = "Connection is closed";
+            return;
+        }
+
+        char *caps = virConnectGetCapabilities(self->hosts[j]);
+
+        if (NULL == caps) {
+            self->hostErrors[j] = getVirtError();
+            return;
+        }
+
+        self->hostCPUs[j] = getHostCPU(caps);
+        free(caps);
+    }
+
+    static void Compare(void *data, size_t t) {
+        CompareCPUMatrixWorker *self = static_cast<CompareCPUMatrixWorker*>(data);
+
+        if (t == self->tasks.size()) {
+            self->Baseline();
+            return;
+        }
+
+        Task& task = self->tasks[t];
+        const std::string& xml = self->guests[self->distinctGuests[task.guest]];
+
+        if (VIR_CPU_COMPARE_ERROR == (task.result = virConnectCompareCPU(task.conn, xml.c_str(), self->flags))) {
+            task.error = getVirtError();
+        }
+    }
+
+    void Baseline() {
+        std::vector<const char*> cpus(this->groups.size());
+
+        for (size_t h = 0; h < this->groups.size(); h++) {
+            cpus[h] = this->hostCPUs[this->groups[h][0]].c_str();
+        }
+
+        this->baselineCPU = virConnectBaselineCPU(this->hosts[this->groups[0][0]], &cpus[0], cpus.size(), this->baselineFlags);
+
+        if (NULL == this->baselineCPU) {
+            this->baselineError = getVirtError();
+        }
+    }
+
+    unsigned int flags;
+    bool baseline;
+    unsigned int baselineFlags;
+    unsigned int concurrency;
+
+    std::vector<std::string> hostCPUs;
+    std::vector<std::string> hostErrors;
+
+    // first guest of every distinct guest CPU, and the hashes of both
+    std::vector<size_t> distinctGuests;
+    std::vector<uint64_t> guestHashes;
+
+    // hosts of every distinct host CPU
+    std::vector<std::vector<size_t> > groups;
+    std::vector<uint64_t> groupHashes;
+
+    std::vector<Task> tasks;
+
+    // distinct CPU of every guest and host, and the answers by both
+    std::vector<size_t> guestOf;
+    std::vector<size_t> groupOf;
+    std::vector<int> answers;
+
+    // guests by hosts
+    std::vector<int8_t> matrix;
+
+    char *baselineCPU;
+    std::string baselineError;
+
+    size_t compared;
+    size_t memoized;
+
+    // posted by the last phase of a call made without callback
+    uv_sem_t *finished;
+
+    // the isolate of a call made with callback
+    virt::Instance *instance;
+};
+
+static void __compareCPUMatrix(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Array);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Array);
+
+    v8::Local<v8::Array> cpus = v8::Local<v8::Array>::Cast(args[0]);
+    v8::Local<v8::Array> conns = v8::Local<v8::Array>::Cast(args[1]);
+    unsigned int flags = 0;
+    bool baseline = false;
+    unsigned int baselineFlags = 0;
+    unsigned int concurrency = kDefaultConcurrency;
+
+    if (args.Length() > 2 && args[2]->IsObject() && !args[2]->IsFunction()) {
+        v8::Local<v8::Object> options = v8::Local<v8::Object>::Cast(args[2]);
+        v8::Local<v8::Value> value;
+
+        if ((value = options->Get(v8::String::NewFromUtf8(isolate, "flags")))->IsUint32()) {
+            flags = value->Uint32Value();
+        }
+
+        if ((value = options->Get(v8::String::NewFromUtf8(isolate, "baselineFlags")))->IsUint32()) {
+            baselineFlags = value->Uint32Value();
+        }
+
+        if ((value = options->Get(v8::String::NewFromUtf8(isolate, "concurrency")))->IsUint32() && value->Uint32Value() > 0) {
+            concurrency = value->Uint32Value();
+        }
+
+        baseline = options->Get(v8::String::NewFromUtf8(isolate, "baseline"))->BooleanValue();
+    }
+
+    std::vector<virConnectPtr> ptrs(conns->Length());
+
+    for (uint32_t j = 0; j < conns->Length(); j++) {
+        v8::Local<v8::Value> conn = conns->Get(j);
+
+        virt::host::Connection *native = virt::host::Connection::Cast<virt::host::Connection>(conn);
+        if (NULL == native) {
+            virt::throwTypeError(isolate, "Invalid connection");
+            return;
+        }
+
+        // a closed connection only fails its own column
+        ptrs[j] = **native;
+    }
+
+    CompareCPUMatrixWorker *worker = new CompareCPUMatrixWorker(ptrs.size(), flags, baseline, baselineFlags, concurrency);
+    worker->guests.resize(cpus->Length());
+
+    for (uint32_t i = 0; i < cpus->Length(); i++) {
+        v8::Local<v8::Value> cpu = cpus->Get(i);
+
+        if (!cpu->IsString()) {
+            delete worker;
+            virt::throwTypeError(isolate, "Invalid CPU description");
+            return;
+        }
+
+        v8::String::Utf8Value xml(cpu);
+        worker->guests[i] = normalize(*xml, xml.length());
+    }
+
+    // the worker may outlive the wrappers
+    for (size_t j = 0; j < ptrs.size(); j++) {
+        worker->hosts[j].Reset(ptrs[j]);
+    }
+
+    virt::Worker::Run(args, worker);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace virt {
+    namespace cpumatrix {
+
+        void exports(v8::Handle<v8::Object> exports) {
+            // the memo is shared by all isolates
+            uv_once(&once, initialize);
+
+            VIRT_SET_METHOD(exports, "compareCPUMatrix",                    __compareCPUMatrix);
+        }
+
+    } // namespace cpumatrix
+} // namespace virt
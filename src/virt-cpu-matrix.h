@@ -0,0 +1,20 @@
+#ifndef __NODE_VIRT_CPU_MATRIX_H__
+#define __NODE_VIRT_CPU_MATRIX_H__
+
+// node
+#include <node.h>
+
+namespace virt {
+    namespace cpumatrix {
+
+        /**
+         * Exports <code>compareCPUMatrix</code>, which compares many guest
+         * CPUs against many hosts at once on a bounded set of native
+         * threads, optionally computing the baseline CPU of the hosts
+         */
+        void exports(v8::Handle<v8::Object> exports);
+
+    } // namespace cpumatrix
+} // namespace virt
+
+#endif /* __NODE_VIRT_CPU_MATRIX_H__ */
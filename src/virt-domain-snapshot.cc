@@ -22,10 +22,12 @@ extern "C" {
 namespace virt {
     namespace domainsnapshot {
 
-        v8::Persistent<v8::Function> DomainSnapshot::constructor;
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          DomainSnapshot::Free<DomainSnapshot>);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            DomainSnapshot::Export<DomainSnapshot>(exports, "DomainSnapshot");
+            DomainSnapshot::Export<DomainSnapshot>(exports, "DomainSnapshot", methods);
         }
 
     } // namespace domainsnapshot
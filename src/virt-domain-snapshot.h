@@ -15,8 +15,6 @@ namespace virt {
 
         class DomainSnapshot : public Pointer<virDomainSnapshotPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline DomainSnapshot(virDomainSnapshotPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virDomainSnapshotPtr>;
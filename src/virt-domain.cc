@@ -3,36 +3,1708 @@
 #include <stdlib.h>
 #include <string.h>
 
+// standard c++
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+// node
+#include <uv.h>
+
+#include "virt-arena.h"
+#include "virt-bitset.h"
 #include "virt-domain.h"
+#include "virt-external-string.h"
+#include "virt-host.h"
+#include "virt-ring.h"
+#include "virt-typed-parameter.h"
+#include "virt-worker.h"
+#include "virt-xml.h"
+
+/**
+ * Domain events are not delivered to JS one by one. The libvirt callbacks
+ * only copy the payload into the ring buffer of the listener, and all
+ * pending events of a listener are handed to JS as a single array once per
+ * loop iteration.
+ */
+
+struct DomainEvent {
+    virDomainPtr dom;
+    int eventID;
+    int ints[4];
+    unsigned long long numbers[2];
+    char *strs[4];
+    virTypedParameterPtr params;
+    int nparams;
+};
+
+struct DomainEventListener {
+    // the isolate the callback belongs to
+    virt::Instance *instance;
+    virConnectPtr conn;
+    virDomainPtr dom;
+    int eventID;
+    int callbackID;
+    v8::Persistent<v8::Function> callback;
+    virt::Ring<DomainEvent> *events;
+    // sequence number of the pending event per domain, only used by the
+    // events where the latest one supersedes the previous
+    std::map<std::string, uint64_t> pending;
+    bool scheduled;
+    bool delivering;
+    bool removed;
+    bool released;
+};
+
+static uv_mutex_t lock;
+
+static uv_once_t once = UV_ONCE_INIT;
+
+static std::vector<DomainEventListener*> listeners;
+
+static void onReady(void *data);
+
+/**
+ * Schedules the delivery on the loop of the isolate which registered the
+ * listener, must be called with the lock held
+ */
+static inline void schedule(DomainEventListener *listener) {
+    listener->scheduled = true;
+    listener->instance->Post(onReady, listener);
+}
+
+static inline bool isCoalescable(int eventID) {
+    switch (eventID) {
+    case VIR_DOMAIN_EVENT_ID_RTC_CHANGE:
+    case VIR_DOMAIN_EVENT_ID_BALLOON_CHANGE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static inline char *copyString(const char *s) {
+    return NULL == s ? NULL : strdup(s);
+}
+
+static virTypedParameterPtr copyTypedParams(virTypedParameterPtr params, int nparams) {
+    if (NULL == params || nparams <= 0) {
+        return NULL;
+    }
+
+    virTypedParameterPtr copy = static_cast<virTypedParameterPtr>(calloc(nparams, sizeof(virTypedParameter)));
+
+    // the event is still delivered, without its parameters
+    if (NULL == copy) {
+        return NULL;
+    }
+
+    memcpy(copy, params, nparams * sizeof(virTypedParameter));
+
+    for (int i = 0; i < nparams; i++) {
+        if (VIR_TYPED_PARAM_STRING == copy[i].type) {
+            copy[i].value.s = copyString(params[i].value.s);
+        }
+    }
+
+    return copy;
+}
+
+static void clearEvent(DomainEvent *event) {
+    if (NULL != event->dom) {
+        virDomainFree(event->dom);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        free(event->strs[i]);
+    }
+
+    if (NULL != event->params) {
+        virTypedParamsFree(event->params, event->nparams);
+    }
+
+    memset(event, 0, sizeof(DomainEvent));
+}
+
+static void freeListener(DomainEventListener *listener) {
+    while (!listener->events->IsEmpty()) {
+        DomainEvent event = listener->events->Shift();
+        clearEvent(&event);
+    }
+
+    if (NULL != listener->dom) {
+        virDomainFree(listener->dom);
+    }
+
+    listener->callback.Reset();
+    delete listener->events;
+    delete listener;
+}
+
+/**
+ * Queues the event onto the listener, takes the ownership of the event
+ */
+static void pushEvent(DomainEventListener *listener, DomainEvent *event) {
+    uv_mutex_lock(&lock);
+
+    if (listener->removed) {
+        uv_mutex_unlock(&lock);
+        clearEvent(event);
+        return;
+    }
+
+    if (isCoalescable(event->eventID)) {
+        unsigned char uuid[VIR_UUID_BUFLEN];
+        virDomainGetUUID(event->dom, uuid);
+        std::string key(reinterpret_cast<char*>(uuid), VIR_UUID_BUFLEN);
+        std::map<std::string, uint64_t>::iterator i = listener->pending.find(key);
+
+        if (i != listener->pending.end() && listener->events->Contains(i->second)) {
+            DomainEvent *prev = &listener->events->At(i->second);
+            clearEvent(prev);
+            *prev = *event;
+        } else {
+            listener->pending[key] = listener->events->Push(*event);
+        }
+    } else {
+        listener->events->Push(*event);
+    }
+
+    if (!listener->scheduled) {
+        schedule(listener);
+    }
+
+    uv_mutex_unlock(&lock);
+}
+
+static inline DomainEvent *newEvent(DomainEvent *event, virDomainPtr dom, int eventID) {
+    memset(event, 0, sizeof(DomainEvent));
+    virDomainRef(dom);
+    event->dom = dom;
+    event->eventID = eventID;
+    return event;
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+static void onLifecycle(virConnectPtr conn, virDomainPtr dom, int type, int detail, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_LIFECYCLE);
+    event.ints[0] = type;
+    event.ints[1] = detail;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onGeneric(virConnectPtr conn, virDomainPtr dom, void *opaque) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(opaque);
+    DomainEvent event;
+    newEvent(&event, dom, listener->eventID);
+    pushEvent(listener, &event);
+}
+
+static void onRTCChange(virConnectPtr conn, virDomainPtr dom, long long utcoffset, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_RTC_CHANGE);
+    event.numbers[0] = static_cast<unsigned long long>(utcoffset);
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onWatchdog(virConnectPtr conn, virDomainPtr dom, int action, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_WATCHDOG);
+    event.ints[0] = action;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onIOError(virConnectPtr conn, virDomainPtr dom, const char *srcPath, const char *devAlias, int action, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_IO_ERROR);
+    event.strs[0] = copyString(srcPath);
+    event.strs[1] = copyString(devAlias);
+    event.ints[0] = action;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onGraphics(virConnectPtr conn, virDomainPtr dom, int phase,
+        const virDomainEventGraphicsAddress *local, const virDomainEventGraphicsAddress *remote,
+        const char *authScheme, const virDomainEventGraphicsSubject *subject, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_GRAPHICS);
+    event.ints[0] = phase;
+    event.strs[0] = copyString(authScheme);
+    event.strs[1] = copyString(NULL == local ? NULL : local->node);
+    event.strs[2] = copyString(NULL == remote ? NULL : remote->node);
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onIOErrorReason(virConnectPtr conn, virDomainPtr dom, const char *srcPath, const char *devAlias,
+        int action, const char *reason, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_IO_ERROR_REASON);
+    event.strs[0] = copyString(srcPath);
+    event.strs[1] = copyString(devAlias);
+    event.strs[2] = copyString(reason);
+    event.ints[0] = action;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onBlockJob(virConnectPtr conn, virDomainPtr dom, const char *disk, int type, int status, void *opaque) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(opaque);
+    DomainEvent event;
+    newEvent(&event, dom, listener->eventID);
+    event.strs[0] = copyString(disk);
+    event.ints[0] = type;
+    event.ints[1] = status;
+    pushEvent(listener, &event);
+}
+
+static void onDiskChange(virConnectPtr conn, virDomainPtr dom, const char *oldSrcPath, const char *newSrcPath,
+        const char *devAlias, int reason, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_DISK_CHANGE);
+    event.strs[0] = copyString(oldSrcPath);
+    event.strs[1] = copyString(newSrcPath);
+    event.strs[2] = copyString(devAlias);
+    event.ints[0] = reason;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onTrayChange(virConnectPtr conn, virDomainPtr dom, const char *devAlias, int reason, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_TRAY_CHANGE);
+    event.strs[0] = copyString(devAlias);
+    event.ints[0] = reason;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onPM(virConnectPtr conn, virDomainPtr dom, int reason, void *opaque) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(opaque);
+    DomainEvent event;
+    newEvent(&event, dom, listener->eventID);
+    event.ints[0] = reason;
+    pushEvent(listener, &event);
+}
+
+static void onBalloonChange(virConnectPtr conn, virDomainPtr dom, unsigned long long actual, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_BALLOON_CHANGE);
+    event.numbers[0] = actual;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+
+static void onDevice(virConnectPtr conn, virDomainPtr dom, const char *devAlias, void *opaque) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(opaque);
+    DomainEvent event;
+    newEvent(&event, dom, listener->eventID);
+    event.strs[0] = copyString(devAlias);
+    pushEvent(listener, &event);
+}
+
+#if LIBVIR_CHECK_VERSION(1, 2, 9)
+static void onTypedParams(virConnectPtr conn, virDomainPtr dom, virTypedParameterPtr params, int nparams, void *opaque) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(opaque);
+    DomainEvent event;
+    newEvent(&event, dom, listener->eventID);
+    event.params = copyTypedParams(params, nparams);
+    event.nparams = NULL == event.params ? 0 : nparams;
+    pushEvent(listener, &event);
+}
+#endif
+
+#if LIBVIR_CHECK_VERSION(1, 2, 11)
+static void onAgentLifecycle(virConnectPtr conn, virDomainPtr dom, int state, int reason, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_AGENT_LIFECYCLE);
+    event.ints[0] = state;
+    event.ints[1] = reason;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+#endif
+
+#if LIBVIR_CHECK_VERSION(1, 3, 2)
+static void onMigrationIteration(virConnectPtr conn, virDomainPtr dom, int iteration, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_MIGRATION_ITERATION);
+    event.ints[0] = iteration;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+#endif
+
+#if LIBVIR_CHECK_VERSION(3, 0, 0)
+static void onMetadataChange(virConnectPtr conn, virDomainPtr dom, int type, const char *nsuri, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_METADATA_CHANGE);
+    event.ints[0] = type;
+    event.strs[0] = copyString(nsuri);
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+#endif
+
+#if LIBVIR_CHECK_VERSION(3, 2, 0)
+static void onBlockThreshold(virConnectPtr conn, virDomainPtr dom, const char *dev, const char *path,
+        unsigned long long threshold, unsigned long long excess, void *opaque) {
+    DomainEvent event;
+    newEvent(&event, dom, VIR_DOMAIN_EVENT_ID_BLOCK_THRESHOLD);
+    event.strs[0] = copyString(dev);
+    event.strs[1] = copyString(path);
+    event.numbers[0] = threshold;
+    event.numbers[1] = excess;
+    pushEvent(static_cast<DomainEventListener*>(opaque), &event);
+}
+#endif
+
+static virConnectDomainEventGenericCallback getEventCallback(int eventID) {
+    switch (eventID) {
+    case VIR_DOMAIN_EVENT_ID_LIFECYCLE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onLifecycle);
+    case VIR_DOMAIN_EVENT_ID_REBOOT:
+    case VIR_DOMAIN_EVENT_ID_CONTROL_ERROR:
+        return VIR_DOMAIN_EVENT_CALLBACK(onGeneric);
+    case VIR_DOMAIN_EVENT_ID_RTC_CHANGE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onRTCChange);
+    case VIR_DOMAIN_EVENT_ID_WATCHDOG:
+        return VIR_DOMAIN_EVENT_CALLBACK(onWatchdog);
+    case VIR_DOMAIN_EVENT_ID_IO_ERROR:
+        return VIR_DOMAIN_EVENT_CALLBACK(onIOError);
+    case VIR_DOMAIN_EVENT_ID_GRAPHICS:
+        return VIR_DOMAIN_EVENT_CALLBACK(onGraphics);
+    case VIR_DOMAIN_EVENT_ID_IO_ERROR_REASON:
+        return VIR_DOMAIN_EVENT_CALLBACK(onIOErrorReason);
+    case VIR_DOMAIN_EVENT_ID_BLOCK_JOB:
+    case VIR_DOMAIN_EVENT_ID_BLOCK_JOB_2:
+        return VIR_DOMAIN_EVENT_CALLBACK(onBlockJob);
+    case VIR_DOMAIN_EVENT_ID_DISK_CHANGE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onDiskChange);
+    case VIR_DOMAIN_EVENT_ID_TRAY_CHANGE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onTrayChange);
+    case VIR_DOMAIN_EVENT_ID_PMWAKEUP:
+    case VIR_DOMAIN_EVENT_ID_PMSUSPEND:
+    case VIR_DOMAIN_EVENT_ID_PMSUSPEND_DISK:
+        return VIR_DOMAIN_EVENT_CALLBACK(onPM);
+    case VIR_DOMAIN_EVENT_ID_BALLOON_CHANGE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onBalloonChange);
+    case VIR_DOMAIN_EVENT_ID_DEVICE_REMOVED:
+#if LIBVIR_CHECK_VERSION(1, 2, 15)
+    case VIR_DOMAIN_EVENT_ID_DEVICE_ADDED:
+#endif
+#if LIBVIR_CHECK_VERSION(1, 3, 4)
+    case VIR_DOMAIN_EVENT_ID_DEVICE_REMOVAL_FAILED:
+#endif
+        return VIR_DOMAIN_EVENT_CALLBACK(onDevice);
+#if LIBVIR_CHECK_VERSION(1, 2, 9)
+    case VIR_DOMAIN_EVENT_ID_TUNABLE:
+#endif
+#if LIBVIR_CHECK_VERSION(1, 3, 3)
+    case VIR_DOMAIN_EVENT_ID_JOB_COMPLETED:
+#endif
+#if LIBVIR_CHECK_VERSION(1, 2, 9)
+        return VIR_DOMAIN_EVENT_CALLBACK(onTypedParams);
+#endif
+#if LIBVIR_CHECK_VERSION(1, 2, 11)
+    case VIR_DOMAIN_EVENT_ID_AGENT_LIFECYCLE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onAgentLifecycle);
+#endif
+#if LIBVIR_CHECK_VERSION(1, 3, 2)
+    case VIR_DOMAIN_EVENT_ID_MIGRATION_ITERATION:
+        return VIR_DOMAIN_EVENT_CALLBACK(onMigrationIteration);
+#endif
+#if LIBVIR_CHECK_VERSION(3, 0, 0)
+    case VIR_DOMAIN_EVENT_ID_METADATA_CHANGE:
+        return VIR_DOMAIN_EVENT_CALLBACK(onMetadataChange);
+#endif
+#if LIBVIR_CHECK_VERSION(3, 2, 0)
+    case VIR_DOMAIN_EVENT_ID_BLOCK_THRESHOLD:
+        return VIR_DOMAIN_EVENT_CALLBACK(onBlockThreshold);
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static void onListenerReleased(void *opaque) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(opaque);
+
+    // libvirt may release the listener from any thread, while the callback
+    // can only be disposed on the loop thread
+    uv_mutex_lock(&lock);
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+    listener->released = true;
+    if (!listener->scheduled && !listener->delivering) {
+        schedule(listener);
+    }
+    uv_mutex_unlock(&lock);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline void setString(v8::Isolate *isolate, v8::Local<v8::Object> obj, const char *key, const char *value) {
+    obj->Set(v8::String::NewFromUtf8(isolate, key), NULL == value
+            ? v8::Local<v8::Value>(v8::Null(isolate))
+            : v8::Local<v8::Value>(v8::String::NewFromUtf8(isolate, value)));
+}
+
+static inline void setNumber(v8::Isolate *isolate, v8::Local<v8::Object> obj, const char *key, double value) {
+    obj->Set(v8::String::NewFromUtf8(isolate, key), v8::Number::New(isolate, value));
+}
+
+/**
+ * Converts the event into JS object, the domain reference is handed over
+ * to the wrapper
+ */
+static v8::Local<v8::Object> eventToObject(v8::Isolate *isolate, DomainEvent *event) {
+    v8::Local<v8::Object> obj = v8::Object::New(isolate);
+
+    // the event keeps its reference until it is cleared, the wrapper gets its own
+    virDomainRef(event->dom);
+    obj->Set(v8::String::NewFromUtf8(isolate, "domain"), virt::domain::Domain::NewInstance<virt::domain::Domain>(event->dom));
+    event->dom = NULL;
+    setNumber(isolate, obj, "eventID", event->eventID);
+
+    switch (event->eventID) {
+    case VIR_DOMAIN_EVENT_ID_LIFECYCLE:
+        setNumber(isolate, obj, "event", event->ints[0]);
+        setNumber(isolate, obj, "detail", event->ints[1]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_RTC_CHANGE:
+        setNumber(isolate, obj, "utcoffset", static_cast<long long>(event->numbers[0]));
+        break;
+    case VIR_DOMAIN_EVENT_ID_WATCHDOG:
+        setNumber(isolate, obj, "action", event->ints[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_IO_ERROR:
+        setString(isolate, obj, "srcPath", event->strs[0]);
+        setString(isolate, obj, "devAlias", event->strs[1]);
+        setNumber(isolate, obj, "action", event->ints[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_GRAPHICS:
+        setNumber(isolate, obj, "phase", event->ints[0]);
+        setString(isolate, obj, "authScheme", event->strs[0]);
+        setString(isolate, obj, "local", event->strs[1]);
+        setString(isolate, obj, "remote", event->strs[2]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_IO_ERROR_REASON:
+        setString(isolate, obj, "srcPath", event->strs[0]);
+        setString(isolate, obj, "devAlias", event->strs[1]);
+        setString(isolate, obj, "reason", event->strs[2]);
+        setNumber(isolate, obj, "action", event->ints[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_BLOCK_JOB:
+    case VIR_DOMAIN_EVENT_ID_BLOCK_JOB_2:
+        setString(isolate, obj, "disk", event->strs[0]);
+        setNumber(isolate, obj, "type", event->ints[0]);
+        setNumber(isolate, obj, "status", event->ints[1]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_DISK_CHANGE:
+        setString(isolate, obj, "oldSrcPath", event->strs[0]);
+        setString(isolate, obj, "newSrcPath", event->strs[1]);
+        setString(isolate, obj, "devAlias", event->strs[2]);
+        setNumber(isolate, obj, "reason", event->ints[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_TRAY_CHANGE:
+        setString(isolate, obj, "devAlias", event->strs[0]);
+        setNumber(isolate, obj, "reason", event->ints[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_PMWAKEUP:
+    case VIR_DOMAIN_EVENT_ID_PMSUSPEND:
+    case VIR_DOMAIN_EVENT_ID_PMSUSPEND_DISK:
+        setNumber(isolate, obj, "reason", event->ints[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_BALLOON_CHANGE:
+        setNumber(isolate, obj, "actual", event->numbers[0]);
+        break;
+    case VIR_DOMAIN_EVENT_ID_DEVICE_REMOVED:
+#if LIBVIR_CHECK_VERSION(1, 2, 15)
+    case VIR_DOMAIN_EVENT_ID_DEVICE_ADDED:
+#endif
+#if LIBVIR_CHECK_VERSION(1, 3, 4)
+    case VIR_DOMAIN_EVENT_ID_DEVICE_REMOVAL_FAILED:
+#endif
+        setString(isolate, obj, "devAlias", event->strs[0]);
+        break;
+#if LIBVIR_CHECK_VERSION(1, 2, 9)
+    case VIR_DOMAIN_EVENT_ID_TUNABLE:
+#endif
+#if LIBVIR_CHECK_VERSION(1, 3, 3)
+    case VIR_DOMAIN_EVENT_ID_JOB_COMPLETED:
+#endif
+        obj->Set(v8::String::NewFromUtf8(isolate, "params"), virt::typedparam::ToArray(isolate, event->params, event->nparams));
+        break;
+#if LIBVIR_CHECK_VERSION(1, 2, 11)
+    case VIR_DOMAIN_EVENT_ID_AGENT_LIFECYCLE:
+        setNumber(isolate, obj, "state", event->ints[0]);
+        setNumber(isolate, obj, "reason", event->ints[1]);
+        break;
+#endif
+#if LIBVIR_CHECK_VERSION(1, 3, 2)
+    case VIR_DOMAIN_EVENT_ID_MIGRATION_ITERATION:
+        setNumber(isolate, obj, "iteration", event->ints[0]);
+        break;
+#endif
+#if LIBVIR_CHECK_VERSION(3, 0, 0)
+    case VIR_DOMAIN_EVENT_ID_METADATA_CHANGE:
+        setNumber(isolate, obj, "type", event->ints[0]);
+        setString(isolate, obj, "nsuri", event->strs[0]);
+        break;
+#endif
+#if LIBVIR_CHECK_VERSION(3, 2, 0)
+    case VIR_DOMAIN_EVENT_ID_BLOCK_THRESHOLD:
+        setString(isolate, obj, "dev", event->strs[0]);
+        setString(isolate, obj, "path", event->strs[1]);
+        setNumber(isolate, obj, "threshold", event->numbers[0]);
+        setNumber(isolate, obj, "excess", event->numbers[1]);
+        break;
+#endif
+    }
+
+    return obj;
+}
+
+static void deliver(DomainEventListener *listener) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+    std::vector<DomainEvent> events;
+
+    uv_mutex_lock(&lock);
+    events.reserve(listener->events->Size());
+    while (!listener->events->IsEmpty()) {
+        events.push_back(listener->events->Shift());
+    }
+    listener->pending.clear();
+    uv_mutex_unlock(&lock);
+
+    if (events.empty()) {
+        return;
+    }
+
+    v8::Local<v8::Array> batch = v8::Array::New(isolate, events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        batch->Set(i, eventToObject(isolate, &events[i]));
+        clearEvent(&events[i]);
+    }
+
+    v8::Local<v8::Function> cb = v8::Local<v8::Function>::New(isolate, listener->callback);
+    v8::Local<v8::Value> argv[] = { batch };
+    node::MakeCallback(isolate, isolate->GetCurrentContext()->Global(), cb, 1, argv);
+}
+
+static void onReady(void *data) {
+    DomainEventListener *listener = static_cast<DomainEventListener*>(data);
+
+    uv_mutex_lock(&lock);
+    listener->scheduled = false;
+    listener->delivering = true;
+    bool skip = listener->removed || listener->released;
+    uv_mutex_unlock(&lock);
+
+    if (!skip) {
+        deliver(listener);
+    }
+
+    uv_mutex_lock(&lock);
+    listener->delivering = false;
+    bool release = listener->released && !listener->scheduled;
+    uv_mutex_unlock(&lock);
+
+    if (release) {
+        freeListener(listener);
+    }
+}
+
+/**
+ * Registers the listener, returns the callback id or -1 on error
+ */
+static int registerListener(v8::Isolate *isolate, virConnectPtr conn, virDomainPtr dom, int eventID, v8::Local<v8::Function> callback) {
+    virConnectDomainEventGenericCallback cb = getEventCallback(eventID);
+    if (NULL == cb) {
+        virt::throwError(isolate, "Unsupported event");
+        return -1;
+    }
+
+    DomainEventListener *listener = new DomainEventListener();
+    listener->instance = virt::Instance::Current();
+    listener->conn = conn;
+    listener->dom = dom;
+    listener->eventID = eventID;
+    listener->callback.Reset(isolate, callback);
+    listener->events = new virt::Ring<DomainEvent>();
+    listener->scheduled = false;
+    listener->delivering = false;
+    listener->removed = false;
+    listener->released = false;
+
+    if (NULL != dom) {
+        virDomainRef(dom);
+    }
+
+    listener->callbackID = virConnectDomainEventRegisterAny(conn, dom, eventID, cb, listener, onListenerReleased);
+    if (-1 == listener->callbackID) {
+        virt::throwVirtError(isolate);
+        freeListener(listener);
+        return -1;
+    }
+
+    uv_mutex_lock(&lock);
+    listeners.push_back(listener);
+    uv_mutex_unlock(&lock);
+
+    return listener->callbackID;
+}
+
+/**
+ * Deregisters the first listener matching the callback id (if not -1) or
+ * the callback function (if not empty). The listener stays registered if
+ * libvirt refuses, so that the removal can be retried.
+ */
+static bool deregisterListener(v8::Isolate *isolate, virConnectPtr conn, virDomainPtr dom, int callbackID, v8::Local<v8::Value> callback) {
+    DomainEventListener *listener = NULL;
+
+    uv_mutex_lock(&lock);
+    for (std::vector<DomainEventListener*>::iterator i = listeners.begin(); i != listeners.end(); ++i) {
+        if ((*i)->conn != conn) {
+            continue;
+        }
+
+        if (-1 != callbackID ? (*i)->callbackID == callbackID
+                : ((*i)->dom == dom && (*i)->callback == callback)) {
+            listener = *i;
+            break;
+        }
+    }
+    uv_mutex_unlock(&lock);
+
+    if (NULL == listener) {
+        virt::throwError(isolate, "Listener not found");
+        return false;
+    }
+
+    // the listener is only freed on this thread, so it outlives the call
+    // even if libvirt releases it meanwhile
+    if (0 != virConnectDomainEventDeregisterAny(conn, listener->callbackID)) {
+        virt::throwVirtError(isolate);
+        return false;
+    }
+
+    uv_mutex_lock(&lock);
+    listener->removed = true;
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+    uv_mutex_unlock(&lock);
+
+    return true;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Worker of a call filling the typed parameters of a domain, which is
+ * called twice, first to query the number of parameters
+ */
+class DomainTypedParamsWorker : public virt::Worker {
+public:
+    typedef int (*Function)(virDomainPtr dom, virTypedParameterPtr params, int *nparams, unsigned int flags);
+
+    inline DomainTypedParamsWorker(virDomainPtr dom, Function fn, unsigned int flags)
+        : dom(dom), fn(fn), flags(flags), params(NULL), nparams(0) {}
+
+    virtual ~DomainTypedParamsWorker() {
+        if (NULL != this->params) {
+            virTypedParamsFree(this->params, this->nparams);
+        }
+    }
+
+    virtual void Execute() {
+        if (0 != this->fn(this->dom, NULL, &this->nparams, this->flags)) {
+            this->SetVirtError();
+            return;
+        }
+
+        if (this->nparams <= 0) {
+            return;
+        }
+
+        this->params = static_cast<virTypedParameterPtr>(calloc(this->nparams, sizeof(virTypedParameter)));
+
+        if (NULL == this->params) {
+            this->SetError("Out of memory");
+            return;
+        }
+
+        if (0 != this->fn(this->dom, this->params, &this->nparams, this->flags)) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return virt::typedparam::ToArray(isolate, this->params, this->nparams);
+    }
+
+private:
+    virt::Reference<virDomainPtr> dom;
+    Function fn;
+    unsigned int flags;
+    virTypedParameterPtr params;
+    int nparams;
+};
+
+/**
+ * Same as DomainTypedParamsWorker, but for the parameters of a device
+ */
+class DomainDeviceTypedParamsWorker : public virt::Worker {
+public:
+    typedef int (*Function)(virDomainPtr dom, const char *device, virTypedParameterPtr params, int *nparams, unsigned int flags);
+
+    inline DomainDeviceTypedParamsWorker(virDomainPtr dom, Function fn, const char *device, unsigned int flags)
+        : dom(dom), fn(fn), device(strdup(device)), flags(flags), params(NULL), nparams(0) {}
+
+    virtual ~DomainDeviceTypedParamsWorker() {
+        free(this->device);
+
+        if (NULL != this->params) {
+            virTypedParamsFree(this->params, this->nparams);
+        }
+    }
+
+    virtual void Execute() {
+        if (0 != this->fn(this->dom, this->device, NULL, &this->nparams, this->flags)) {
+            this->SetVirtError();
+            return;
+        }
+
+        if (this->nparams <= 0) {
+            return;
+        }
+
+        this->params = static_cast<virTypedParameterPtr>(calloc(this->nparams, sizeof(virTypedParameter)));
+
+        if (NULL == this->params) {
+            this->SetError("Out of memory");
+            return;
+        }
+
+        if (0 != this->fn(this->dom, this->device, this->params, &this->nparams, this->flags)) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return virt::typedparam::ToArray(isolate, this->params, this->nparams);
+    }
+
+private:
+    virt::Reference<virDomainPtr> dom;
+    Function fn;
+    char *device;
+    unsigned int flags;
+    virTypedParameterPtr params;
+    int nparams;
+};
+
+/**
+ * The number of scheduler parameters comes from virDomainGetSchedulerType
+ */
+static int getSchedulerParameters(virDomainPtr dom, virTypedParameterPtr params, int *nparams, unsigned int flags) {
+    if (NULL != params) {
+        return virDomainGetSchedulerParametersFlags(dom, params, nparams, flags);
+    }
+
+    char *type = virDomainGetSchedulerType(dom, nparams);
+    if (NULL == type) {
+        return -1;
+    }
+
+    free(type);
+    return 0;
+}
+
+static void getDomainTypedParams(const v8::FunctionCallbackInfo<v8::Value>& args, DomainTypedParamsWorker::Function fn) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new DomainTypedParamsWorker(**native, fn, flags), virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+static void getDomainDeviceTypedParams(const v8::FunctionCallbackInfo<v8::Value>& args, DomainDeviceTypedParamsWorker::Function fn) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    v8::String::Utf8Value device(args[0]->ToString());
+    unsigned int flags = args.Length() > 1 && args[1]->IsUint32() ? args[1]->Uint32Value() : 0;
+    virt::Worker::Run(args, new DomainDeviceTypedParamsWorker(**native, fn, *device, flags), virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+static void __virDomainBlockStatsFlags(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainDeviceTypedParams(args, virDomainBlockStatsFlags);
+}
+
+static void __virDomainGetBlkioParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainTypedParams(args, virDomainGetBlkioParameters);
+}
+
+static void __virDomainGetInterfaceParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainDeviceTypedParams(args, virDomainGetInterfaceParameters);
+}
+
+static void __virDomainGetMemoryParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainTypedParams(args, virDomainGetMemoryParameters);
+}
+
+static void __virDomainGetNumaParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainTypedParams(args, virDomainGetNumaParameters);
+}
+
+static void __virDomainGetSchedulerParametersFlags(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainTypedParams(args, getSchedulerParameters);
+}
+
+/**
+ * Worker of the setters of typed parameters, of the domain or of one of its
+ * devices. The parameters, their strings and the device name live in the
+ * arena of the worker.
+ */
+class SetDomainTypedParamsWorker : public virt::Worker {
+public:
+    typedef int (*Function)(virDomainPtr dom, virTypedParameterPtr params, int nparams, unsigned int flags);
+
+    typedef int (*DeviceFunction)(virDomainPtr dom, const char *device, virTypedParameterPtr params, int nparams, unsigned int flags);
+
+    inline SetDomainTypedParamsWorker(virDomainPtr dom, Function fn, unsigned int flags)
+        : params(NULL), nparams(0), device(NULL), dom(dom), fn(fn), deviceFn(NULL), flags(flags) {}
+
+    inline SetDomainTypedParamsWorker(virDomainPtr dom, DeviceFunction fn, unsigned int flags)
+        : params(NULL), nparams(0), device(NULL), dom(dom), fn(NULL), deviceFn(fn), flags(flags) {}
+
+    virtual void Execute() {
+        int rc = NULL != this->deviceFn
+            ? this->deviceFn(this->dom, this->device, this->params, this->nparams, this->flags)
+            : this->fn(this->dom, this->params, this->nparams, this->flags);
+
+        if (0 != rc) {
+            this->SetVirtError();
+        }
+    }
+
+    virt::Arena arena;
+
+    virTypedParameterPtr params;
+
+    int nparams;
+
+    const char *device;
+
+private:
+    virt::Reference<virDomainPtr> dom;
+    Function fn;
+    DeviceFunction deviceFn;
+    unsigned int flags;
+};
+
+static void setDomainTypedParams(const v8::FunctionCallbackInfo<v8::Value>& args, SetDomainTypedParamsWorker::Function fn) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Array);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 1 && args[1]->IsUint32() ? args[1]->Uint32Value() : 0;
+    SetDomainTypedParamsWorker *worker = new SetDomainTypedParamsWorker(**native, fn, flags);
+
+    if (!virt::typedparam::FromArray(isolate, args[0], &worker->arena, &worker->params, &worker->nparams)) {
+        delete worker;
+        return;
+    }
+
+    virt::Worker::Run(args, worker, virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+static void setDomainDeviceTypedParams(const v8::FunctionCallbackInfo<v8::Value>& args, SetDomainTypedParamsWorker::DeviceFunction fn) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Array);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 2 && args[2]->IsUint32() ? args[2]->Uint32Value() : 0;
+    SetDomainTypedParamsWorker *worker = new SetDomainTypedParamsWorker(**native, fn, flags);
+
+    if (!virt::typedparam::FromArray(isolate, args[1], &worker->arena, &worker->params, &worker->nparams)) {
+        delete worker;
+        return;
+    }
+
+    worker->device = worker->arena.Copy(v8::Local<v8::String>::Cast(args[0]));
+
+    if (NULL == worker->device) {
+        delete worker;
+        virt::throwError(isolate, "Out of memory");
+        return;
+    }
+
+    virt::Worker::Run(args, worker, virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+static void __virDomainGetBlockIoTune(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    getDomainDeviceTypedParams(args, virDomainGetBlockIoTune);
+}
+
+static void __virDomainSetBlkioParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    setDomainTypedParams(args, virDomainSetBlkioParameters);
+}
+
+static void __virDomainSetBlockIoTune(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    setDomainDeviceTypedParams(args, virDomainSetBlockIoTune);
+}
+
+static void __virDomainSetInterfaceParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    setDomainDeviceTypedParams(args, virDomainSetInterfaceParameters);
+}
+
+static void __virDomainSetMemoryParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    setDomainTypedParams(args, virDomainSetMemoryParameters);
+}
+
+static void __virDomainSetNumaParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    setDomainTypedParams(args, virDomainSetNumaParameters);
+}
+
+static void __virDomainSetSchedulerParametersFlags(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    setDomainTypedParams(args, virDomainSetSchedulerParametersFlags);
+}
+
+class GetXMLDescWorker : public virt::Worker {
+public:
+    inline GetXMLDescWorker(virDomainPtr dom, unsigned int flags, virt::xml::Extractor *extractor)
+        : dom(dom), flags(flags), xml(NULL), extractor(extractor) {}
+
+    virtual ~GetXMLDescWorker() {
+        free(this->xml);
+        delete this->extractor;
+    }
+
+    virtual void Execute() {
+        if (NULL == (this->xml = virDomainGetXMLDesc(this->dom, this->flags))) {
+            this->SetVirtError();
+            return;
+        }
+
+        if (NULL != this->extractor) {
+            this->extractor->Parse(this->xml);
+            free(this->xml);
+            this->xml = NULL;
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        if (NULL != this->extractor) {
+            return this->extractor->Result(isolate);
+        }
+
+        char *xml = this->xml;
+        this->xml = NULL;
+        return virt::ExternalString::New(isolate, xml);
+    }
+
+private:
+    virt::Reference<virDomainPtr> dom;
+    unsigned int flags;
+    char *xml;
+    virt::xml::Extractor *extractor;
+};
+
+static void __virDomainGetXMLDesc(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::xml::Extractor *extractor = NULL;
+
+    if (args.Length() > 1 && args[1]->IsArray()) {
+        if (NULL == (extractor = virt::xml::Extractor::New(isolate, args[1]))) {
+            return;
+        }
+    }
+
+    virt::Worker::Run(args, new GetXMLDescWorker(**native, flags, extractor), virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+/**
+ * Returns the number of CPUs of the host of the domain, i.e. the number of
+ * bits of its CPU maps
+ */
+static inline int getHostCPUs(virDomainPtr dom) {
+    return virNodeGetCPUMap(virDomainGetConnect(dom), NULL, NULL, 0);
+}
+
+/**
+ * Worker of virDomainGetVcpuPinInfo, the maps of all vCPUs are views of a
+ * single buffer
+ */
+class GetVcpuPinInfoWorker : public virt::Worker {
+public:
+    inline GetVcpuPinInfoWorker(virDomainPtr dom, unsigned int flags) : dom(dom), flags(flags), count(0), length(0) {}
+
+    virtual void Execute() {
+        int ncpus = getHostCPUs(this->dom);
+        int nvcpus = ncpus < 0 ? -1 : virDomainGetVcpusFlags(this->dom, this->flags | VIR_DOMAIN_VCPU_MAXIMUM);
+
+        if (nvcpus < 0) {
+            this->SetVirtError();
+            return;
+        }
+
+        this->length = VIR_CPU_MAPLEN(ncpus);
+        this->maps.resize(static_cast<size_t>(nvcpus) * this->length);
+
+        if (this->maps.empty()) {
+            return;
+        }
+
+        int n = virDomainGetVcpuPinInfo(this->dom, nvcpus, &this->maps[0], this->length, this->flags);
+        if (n < 0) {
+            this->SetVirtError();
+            return;
+        }
+
+        this->count = n;
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return virt::bitset::New(isolate, this->maps.empty() ? NULL : &this->maps[0], this->count, this->length);
+    }
+
+private:
+    virt::Reference<virDomainPtr> dom;
+    unsigned int flags;
+    virt::bitset::Bits maps;
+    size_t count;
+    int length;
+};
+
+static void __virDomainGetVcpuPinInfo(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new GetVcpuPinInfoWorker(**native, flags), virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+class GetEmulatorPinInfoWorker : public virt::Worker {
+public:
+    inline GetEmulatorPinInfoWorker(virDomainPtr dom, unsigned int flags) : dom(dom), flags(flags), pinned(0) {}
+
+    virtual void Execute() {
+        int ncpus = getHostCPUs(this->dom);
+
+        if (ncpus < 0) {
+            this->SetVirtError();
+            return;
+        }
+
+        this->map.resize(VIR_CPU_MAPLEN(ncpus));
+
+        if (-1 == (this->pinned = virDomainGetEmulatorPinInfo(this->dom, &this->map[0], this->map.size(), this->flags))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        if (0 == this->pinned) {
+            return v8::Null(isolate);
+        }
+
+        return virt::bitset::New(isolate, &this->map[0], this->map.size());
+    }
+
+private:
+    virt::Reference<virDomainPtr> dom;
+    unsigned int flags;
+    virt::bitset::Bits map;
+    int pinned;
+};
+
+static void __virDomainGetEmulatorPinInfo(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new GetEmulatorPinInfoWorker(**native, flags), virt::host::GetExecutor(virDomainGetConnect(**native)));
+}
+
+/**
+ * Worker applying a pinning plan, all vCPU and emulator pinnings of all
+ * domains are done in a single trip to the executor. A failing pinning
+ * does not stop the others, the failures are reported along with the
+ * number of applied pinnings.
+ */
+class ApplyCPUPinningWorker : public virt::Worker {
+public:
+
+    struct Pin {
+        // index of the entry of the plan
+        uint32_t index;
+        // referenced by the worker
+        virDomainPtr dom;
+        // the vCPU, -1 for the emulator threads
+        int vcpu;
+        virt::bitset::Bits map;
+    };
+
+    /**
+     * Takes over the pinnings, the domains are referenced until the worker
+     * is deleted
+     */
+    inline ApplyCPUPinningWorker(std::vector<Pin>& pins, unsigned int flags)
+        : doms(pins.size()), flags(flags), applied(0) {
+        this->pins.swap(pins);
+
+        for (size_t i = 0; i < this->pins.size(); i++) {
+            this->doms[i].Reset(this->pins[i].dom);
+        }
+    }
+
+    virtual void Execute() {
+        for (size_t i = 0; i < this->pins.size(); i++) {
+            Pin& pin = this->pins[i];
+            unsigned char *map = pin.map.empty() ? NULL : &pin.map[0];
+            int rc = pin.vcpu < 0
+                ? virDomainPinEmulator(pin.dom, map, pin.map.size(), this->flags)
+                : virDomainPinVcpuFlags(pin.dom, pin.vcpu, map, pin.map.size(), this->flags);
+
+            if (0 == rc) {
+                this->applied++;
+                continue;
+            }
+
+            const char *msg = virGetLastErrorMessage();
+            this->failures.push_back(std::make_pair(i, std::string(NULL == msg ? "Unknown error" : msg)));
+            virResetLastError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        v8::Local<v8::Array> failed = v8::Array::New(isolate, this->failures.size());
+        v8::Local<v8::String> kIndex = v8::String::NewFromUtf8(isolate, "index");
+        v8::Local<v8::String> kVcpu = v8::String::NewFromUtf8(isolate, "vcpu");
+        v8::Local<v8::String> kEmulator = v8::String::NewFromUtf8(isolate, "emulator");
+        v8::Local<v8::String> kError = v8::String::NewFromUtf8(isolate, "error");
+
+        for (size_t i = 0; i < this->failures.size(); i++) {
+            Pin& pin = this->pins[this->failures[i].first];
+            v8::Local<v8::Object> failure = v8::Object::New(isolate);
+
+            failure->Set(kIndex, v8::Integer::NewFromUnsigned(isolate, pin.index));
+            if (pin.vcpu < 0) {
+                failure->Set(kEmulator, v8::True(isolate));
+            } else {
+                failure->Set(kVcpu, v8::Integer::New(isolate, pin.vcpu));
+            }
+            failure->Set(kError, v8::String::NewFromUtf8(isolate, this->failures[i].second.c_str()));
+            failed->Set(i, failure);
+        }
+
+        result->Set(v8::String::NewFromUtf8(isolate, "applied"), v8::Integer::NewFromUnsigned(isolate, this->applied));
+        result->Set(v8::String::NewFromUtf8(isolate, "failed"), failed);
+        return result;
+    }
+
+private:
+    std::vector<Pin> pins;
+    // the domains of the pinnings, by pinning
+    std::vector<virt::Reference<virDomainPtr> > doms;
+    unsigned int flags;
+    uint32_t applied;
+    std::vector<std::pair<size_t, std::string> > failures;
+};
+
+/**
+ * Reads the CPU map of the pinning unless the value is null or undefined,
+ * throws and returns false if it is invalid
+ */
+static bool addPin(v8::Isolate *isolate, std::vector<ApplyCPUPinningWorker::Pin>& pins,
+        uint32_t index, virDomainPtr dom, int vcpu, v8::Local<v8::Value> value) {
+    if (value->IsNull() || value->IsUndefined()) {
+        return true;
+    }
+
+    pins.push_back(ApplyCPUPinningWorker::Pin());
+    ApplyCPUPinningWorker::Pin& pin = pins.back();
+    pin.index = index;
+    pin.dom = dom;
+    pin.vcpu = vcpu;
+
+    return virt::bitset::Parse(isolate, value, &pin.map);
+}
+
+static void __virConnectApplyCPUPinning(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Array);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    v8::Local<v8::Array> plan = v8::Local<v8::Array>::Cast(args[0]);
+    unsigned int flags = args.Length() > 1 && args[1]->IsUint32() ? args[1]->Uint32Value() : 0;
+    v8::Local<v8::String> kDomain = v8::String::NewFromUtf8(isolate, "domain");
+    v8::Local<v8::String> kVcpus = v8::String::NewFromUtf8(isolate, "vcpus");
+    v8::Local<v8::String> kEmulator = v8::String::NewFromUtf8(isolate, "emulator");
+    std::vector<ApplyCPUPinningWorker::Pin> pins;
+
+    for (uint32_t i = 0; i < plan->Length(); i++) {
+        v8::Local<v8::Value> value = plan->Get(i);
+
+        if (!value->IsObject()) {
+            virt::throwTypeError(isolate, "Invalid pinning plan");
+            return;
+        }
+
+        v8::Local<v8::Object> entry = v8::Local<v8::Object>::Cast(value);
+        v8::Local<v8::Value> domain = entry->Get(kDomain);
+
+        // the domains must belong to this connection, whose executor runs
+        // the pinning
+        virt::domain::Domain *dom = virt::domain::Domain::Cast<virt::domain::Domain>(domain);
+        if (NULL == dom || dom->IsNull() || virDomainGetConnect(**dom) != **native) {
+            virt::throwTypeError(isolate, "Invalid domain");
+            return;
+        }
+
+        v8::Local<v8::Value> vcpus = entry->Get(kVcpus);
+
+        if (vcpus->IsArray()) {
+            v8::Local<v8::Array> maps = v8::Local<v8::Array>::Cast(vcpus);
+
+            for (uint32_t j = 0; j < maps->Length(); j++) {
+                if (!addPin(isolate, pins, i, **dom, j, maps->Get(j))) {
+                    return;
+                }
+            }
+        } else if (!vcpus->IsNull() && !vcpus->IsUndefined()) {
+            virt::throwTypeError(isolate, "Invalid pinning plan");
+            return;
+        }
+
+        if (!addPin(isolate, pins, i, **dom, -1, entry->Get(kEmulator))) {
+            return;
+        }
+    }
+
+    virt::Worker::Run(args, new ApplyCPUPinningWorker(pins, flags), native->GetExecutor());
+}
+
+/**
+ * Worker of virConnectGetAllDomainStats, the numeric stats are laid out as
+ * one column per field in a single buffer, fields a domain does not report
+ * are NaN
+ */
+class GetAllDomainStatsWorker : public virt::Worker {
+public:
+    inline GetAllDomainStatsWorker(virConnectPtr conn, unsigned int stats, unsigned int flags)
+        : conn(conn), stats(stats), flags(flags), values(NULL) {}
+
+    virtual ~GetAllDomainStatsWorker() {
+        free(this->values);
+    }
+
+    virtual void Execute() {
+        virDomainStatsRecordPtr *records = NULL;
+        int n = virConnectGetAllDomainStats(this->conn, this->stats, &records, this->flags);
+
+        if (n < 0) {
+            this->SetVirtError();
+            return;
+        }
+
+        std::map<std::string, size_t> columns;
+
+        for (int i = 0; i < n; i++) {
+            const char *name = virDomainGetName(records[i]->dom);
+            this->domains.push_back(NULL == name ? "" : name);
+
+            for (int j = 0; j < records[i]->nparams; j++) {
+                virTypedParameterPtr param = records[i]->params + j;
+                if (VIR_TYPED_PARAM_STRING != param->type && columns.find(param->field) == columns.end()) {
+                    columns[param->field] = this->fields.size();
+                    this->fields.push_back(param->field);
+                }
+            }
+        }
+
+        size_t count = static_cast<size_t>(n) * this->fields.size();
+        if (count > 0) {
+            this->values = static_cast<double*>(malloc(count * sizeof(double)));
+
+            if (NULL == this->values) {
+                virDomainStatsRecordListFree(records);
+                this->SetError("Out of memory");
+                return;
+            }
+
+            std::fill(this->values, this->values + count, std::numeric_limits<double>::quiet_NaN());
+        }
+
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < records[i]->nparams; j++) {
+                virTypedParameterPtr param = records[i]->params + j;
+                if (VIR_TYPED_PARAM_STRING == param->type) {
+                    continue;
+                }
+
+                double *value = this->values + columns[param->field] * n + i;
+
+                switch (param->type) {
+                case VIR_TYPED_PARAM_INT:
+                    *value = param->value.i;
+                    break;
+                case VIR_TYPED_PARAM_UINT:
+                    *value = param->value.ui;
+                    break;
+                case VIR_TYPED_PARAM_LLONG:
+                    *value = param->value.l;
+                    break;
+                case VIR_TYPED_PARAM_ULLONG:
+                    *value = param->value.ul;
+                    break;
+                case VIR_TYPED_PARAM_DOUBLE:
+                    *value = param->value.d;
+                    break;
+                case VIR_TYPED_PARAM_BOOLEAN:
+                    *value = param->value.b ? 1 : 0;
+                    break;
+                }
+            }
+        }
+
+        virDomainStatsRecordListFree(records);
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        size_t n = this->domains.size();
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        v8::Local<v8::Array> domains = v8::Array::New(isolate, n);
+        v8::Local<v8::Object> stats = v8::Object::New(isolate);
+        v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, n * this->fields.size() * sizeof(double));
+
+        if (NULL != this->values) {
+            memcpy(buffer->GetContents().Data(), this->values, buffer->ByteLength());
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            domains->Set(i, v8::String::NewFromUtf8(isolate, this->domains[i].c_str()));
+        }
+
+        for (size_t i = 0; i < this->fields.size(); i++) {
+            stats->Set(v8::String::NewFromUtf8(isolate, this->fields[i].c_str()),
+                    v8::Float64Array::New(buffer, i * n * sizeof(double), n));
+        }
+
+        result->Set(v8::String::NewFromUtf8(isolate, "domains"), domains);
+        result->Set(v8::String::NewFromUtf8(isolate, "stats"), stats);
+        return result;
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned int stats;
+    unsigned int flags;
+    std::vector<std::string> domains;
+    std::vector<std::string> fields;
+    double *values;
+};
+
+static void __virConnectGetAllDomainStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int stats = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    unsigned int flags = args.Length() > 1 && args[1]->IsUint32() ? args[1]->Uint32Value() : 0;
+    virt::Worker::Run(args, new GetAllDomainStatsWorker(**native, stats, flags), native->GetExecutor());
+}
+
+/**
+ * The filters virConnectGetAllDomainStats shares with virConnectListAllDomains
+ */
+#define LIST_DOMAINS_STATS_FILTERS                                         \
+    (VIR_CONNECT_LIST_DOMAINS_ACTIVE | VIR_CONNECT_LIST_DOMAINS_INACTIVE | \
+     VIR_CONNECT_LIST_DOMAINS_PERSISTENT | VIR_CONNECT_LIST_DOMAINS_TRANSIENT | \
+     VIR_CONNECT_LIST_DOMAINS_RUNNING | VIR_CONNECT_LIST_DOMAINS_PAUSED |  \
+     VIR_CONNECT_LIST_DOMAINS_SHUTOFF | VIR_CONNECT_LIST_DOMAINS_OTHER)
+
+/**
+ * Worker of virConnectListAllDomains, the name, UUID, state and id of every
+ * domain are collected in the same call. The state comes from a single
+ * virConnectGetAllDomainStats request if the filters allow it, instead of
+ * one virDomainGetState request per domain.
+ */
+class ListAllDomainsWorker : public virt::Worker {
+public:
+    inline ListAllDomainsWorker(virConnectPtr conn, unsigned int flags) : conn(conn), flags(flags) {}
+
+    virtual ~ListAllDomainsWorker() {
+        for (size_t i = 0; i < this->entries.size(); i++) {
+            if (NULL != this->entries[i].dom) {
+                virDomainFree(this->entries[i].dom);
+            }
+        }
+    }
+
+    virtual void Execute() {
+        if (0 == (this->flags & ~LIST_DOMAINS_STATS_FILTERS) && this->ListByStats()) {
+            return;
+        }
+
+        virDomainPtr *doms = NULL;
+        int n = virConnectListAllDomains(this->conn, &doms, this->flags);
+
+        if (n < 0) {
+            this->SetVirtError();
+            return;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int state = -1;
+            int reason;
+
+            virDomainGetState(doms[i], &state, &reason, 0);
+            this->Add(doms[i], state);
+        }
+
+        free(doms);
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Array> result = v8::Array::New(isolate, this->entries.size());
+        v8::Local<v8::String> kDomain = v8::String::NewFromUtf8(isolate, "domain");
+        v8::Local<v8::String> kName = v8::String::NewFromUtf8(isolate, "name");
+        v8::Local<v8::String> kUUID = v8::String::NewFromUtf8(isolate, "uuid");
+        v8::Local<v8::String> kState = v8::String::NewFromUtf8(isolate, "state");
+        v8::Local<v8::String> kId = v8::String::NewFromUtf8(isolate, "id");
+
+        for (size_t i = 0; i < this->entries.size(); i++) {
+            Entry& entry = this->entries[i];
+            v8::Local<v8::Object> obj = v8::Object::New(isolate);
+
+            // the wrapper takes over the reference
+            obj->Set(kDomain, virt::domain::Domain::NewInstance<virt::domain::Domain>(entry.dom));
+            entry.dom = NULL;
+
+            obj->Set(kName, v8::String::NewFromUtf8(isolate, entry.name.c_str()));
+            obj->Set(kUUID, v8::String::NewFromUtf8(isolate, entry.uuid));
+            obj->Set(kState, v8::Integer::New(isolate, entry.state));
+            obj->Set(kId, v8::Integer::New(isolate, entry.id));
+            result->Set(i, obj);
+        }
+
+        return result;
+    }
+
+private:
+
+    struct Entry {
+        virDomainPtr dom;
+        std::string name;
+        char uuid[VIR_UUID_STRING_BUFLEN];
+        int state;
+        int id;
+    };
+
+    /**
+     * Takes over the reference of the domain
+     */
+    void Add(virDomainPtr dom, int state) {
+        const char *name = virDomainGetName(dom);
+        unsigned int id = virDomainGetID(dom);
+
+        this->entries.push_back(Entry());
+        Entry& entry = this->entries.back();
+        entry.dom = dom;
+        entry.name = NULL == name ? "" : name;
+        entry.state = state;
+        entry.id = static_cast<unsigned int>(-1) == id ? -1 : static_cast<int>(id);
+
+        if (0 != virDomainGetUUIDString(dom, entry.uuid)) {
+            entry.uuid[0] = '\0';
+        }
+    }
+
+    bool ListByStats() {
+        virDomainStatsRecordPtr *records = NULL;
+        int n = virConnectGetAllDomainStats(this->conn, VIR_DOMAIN_STATS_STATE, &records, this->flags);
+
+        if (n < 0) {
+            // older daemons, fall back to listing the domains
+            virResetLastError();
+            return false;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int state = -1;
+
+            for (int j = 0; j < records[i]->nparams; j++) {
+                virTypedParameterPtr param = records[i]->params + j;
+                if (VIR_TYPED_PARAM_INT == param->type && 0 == strcmp(param->field, "state.state")) {
+                    state = param->value.i;
+                    break;
+                }
+            }
+
+            virDomainRef(records[i]->dom);
+            this->Add(records[i]->dom, state);
+        }
+
+        virDomainStatsRecordListFree(records);
+        return true;
+    }
+
+    virt::Reference<virConnectPtr> conn;
+    unsigned int flags;
+    std::vector<Entry> entries;
+};
+
+static void __virConnectListAllDomains(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new ListAllDomainsWorker(**native, flags), native->GetExecutor());
+}
+
 static void __virConnectDomainEventRegister(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
-    CHK_ARGUMENT_TYPE(isolate, args[1], Function);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Function);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
     CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
-    // FIXME
+
+    int callbackID = registerListener(isolate, virDomainGetConnect(**native), **native,
+            VIR_DOMAIN_EVENT_ID_LIFECYCLE, v8::Local<v8::Function>::Cast(args[0]));
+    if (-1 != callbackID) {
+        args.GetReturnValue().Set(v8::Number::New(isolate, callbackID));
+    }
 }
 
 static void __virConnectDomainEventDeregister(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
-    // FIXME
-    virt::throwError(isolate, "Unimplemented");
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    if (args[0]->IsInt32()) {
+        deregisterListener(isolate, virDomainGetConnect(**native), **native, args[0]->Int32Value(), v8::Local<v8::Value>());
+    } else if (args[0]->IsFunction()) {
+        deregisterListener(isolate, virDomainGetConnect(**native), **native, -1, args[0]);
+    } else {
+        virt::throwTypeError(isolate, "Invalid arguments");
+    }
+}
+
+static void __virDomainEventDeregisterAny(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::domain::Domain *native = node::ObjectWrap::Unwrap<virt::domain::Domain>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    deregisterListener(isolate, virDomainGetConnect(**native), **native, args[0]->Int32Value(), v8::Local<v8::Value>());
+}
+
+static void __virConnectDomainEventRegisterAny(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Function);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    virDomainPtr dom = NULL;
+    if (args.Length() > 2 && !args[2]->IsUndefined() && !args[2]->IsNull()) {
+        virt::domain::Domain *domain = virt::domain::Domain::Cast<virt::domain::Domain>(args[2]);
+
+        if (NULL == domain) {
+            virt::throwTypeError(isolate, "Invalid domain");
+            return;
+        }
+
+        CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, domain);
+        dom = **domain;
+    }
+
+    int callbackID = registerListener(isolate, **native, dom, args[0]->Int32Value(), v8::Local<v8::Function>::Cast(args[1]));
+    if (-1 != callbackID) {
+        args.GetReturnValue().Set(v8::Number::New(isolate, callbackID));
+    }
 }
 
 static void __virConnectDomainEventDeregisterAny(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
-    // FIXME
-    virt::throwError(isolate, "Unimplemented");
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    deregisterListener(isolate, **native, NULL, args[0]->Int32Value(), v8::Local<v8::Value>());
 }
 
 #ifdef __cplusplus
@@ -42,14 +1714,70 @@ static void __virConnectDomainEventDeregisterAny(const v8::FunctionCallbackInfo<
 namespace virt {
     namespace domain {
 
-        v8::Persistent<v8::Function> Domain::constructor;
+        void prototype(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "addDomainEventListener",        __virConnectDomainEventRegisterAny);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "applyCPUPinning",               __virConnectApplyCPUPinning);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "removeDomainEventListener",     __virConnectDomainEventDeregisterAny);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getAllDomainStats",             __virConnectGetAllDomainStats);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "listAllDomains",                __virConnectListAllDomains);
+        }
+
+        void RemoveListeners(virConnectPtr conn) {
+            std::vector<int> callbackIDs;
+
+            // only the ids are kept, the listeners may be freed on the loop
+            // thread as soon as they are deregistered
+            uv_mutex_lock(&lock);
+            for (std::vector<DomainEventListener*>::iterator i = listeners.begin(); i != listeners.end();) {
+                if ((*i)->conn == conn) {
+                    (*i)->removed = true;
+                    callbackIDs.push_back((*i)->callbackID);
+                    i = listeners.erase(i);
+                } else {
+                    ++i;
+                }
+            }
+            uv_mutex_unlock(&lock);
+
+            for (size_t i = 0; i < callbackIDs.size(); i++) {
+                virConnectDomainEventDeregisterAny(conn, callbackIDs[i]);
+            }
+
+            virResetLastError();
+        }
+
+        static void initialize() {
+            uv_mutex_init(&lock);
+        }
+
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          Domain::Free<Domain>);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "addEventListener",              __virConnectDomainEventRegister);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "removeEventListener",           __virConnectDomainEventDeregister);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "removeEventListenerAny",        __virDomainEventDeregisterAny);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getBlockStatsParameters",       __virDomainBlockStatsFlags);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getBlkioParameters",            __virDomainGetBlkioParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getBlockIoTune",                __virDomainGetBlockIoTune);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getEmulatorPinInfo",            __virDomainGetEmulatorPinInfo);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getInterfaceParameters",        __virDomainGetInterfaceParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getMemoryParameters",           __virDomainGetMemoryParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNumaParameters",             __virDomainGetNumaParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getSchedulerParameters",        __virDomainGetSchedulerParametersFlags);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getVcpuPinInfo",                __virDomainGetVcpuPinInfo);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getXMLDesc",                    __virDomainGetXMLDesc);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setBlkioParameters",            __virDomainSetBlkioParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setBlockIoTune",                __virDomainSetBlockIoTune);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setInterfaceParameters",        __virDomainSetInterfaceParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setMemoryParameters",           __virDomainSetMemoryParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setNumaParameters",             __virDomainSetNumaParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setSchedulerParameters",        __virDomainSetSchedulerParametersFlags);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            Domain::Export<Domain>(exports, "Domain");
+            // the listeners of all isolates share the lock
+            uv_once(&once, initialize);
 
-            NODE_SET_METHOD(exports, "virConnectDomainEventRegister",       __virConnectDomainEventRegister);
-            NODE_SET_METHOD(exports, "virConnectDomainEventDeregister",     __virConnectDomainEventDeregister);
-            NODE_SET_METHOD(exports, "virConnectDomainEventDeregisterAny",  __virConnectDomainEventDeregisterAny);
+            Domain::Export<Domain>(exports, "Domain", methods);
         }
 
     } // namespace domain
@@ -13,10 +13,19 @@ namespace virt {
 
         void exports(v8::Handle<v8::Object> exports);
 
+        /**
+         * Installs the domain related methods onto the Connection prototype
+         */
+        void prototype(v8::Local<v8::FunctionTemplate> tpl);
+
+        /**
+         * Deregisters every domain event listener of the connection, may
+         * block on the hypervisor
+         */
+        void RemoveListeners(virConnectPtr conn);
+
         class Domain : public Pointer<virDomainPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline Domain(virDomainPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virDomainPtr>;
@@ -1,6 +1,6 @@
 /**
  * libvirt-event for node js
- * 
+ *
  * @author Johnson Lee <g.johnsonlee@gmail.com>
  */
 
@@ -9,23 +9,421 @@
 #include <stdlib.h>
 #include <string.h>
 
+// standard c++
+#include <map>
+#include <vector>
+
+// node
+#include <uv.h>
+
 // libvirt
 #include <libvirt/libvirt.h>
 
 #include "virt-event.h"
+#include "virt-instance.h"
+
+/**
+ * libvirt may add, update or remove handles and timeouts from any thread
+ * which is using a connection (e.g. the thread pool workers), while libuv
+ * handles can only be touched on the loop thread. So every watch keeps its
+ * desired state under the lock, and the loop thread applies it either
+ * immediately or on the next wake-up of the async handle.
+ */
+
+struct Watch {
+    int id;
+    int fd;
+    int events;
+    bool removed;
+    bool started;
+    virEventHandleCallback cb;
+    void *opaque;
+    virFreeCallback ff;
+    uv_poll_t poll;
+};
+
+struct Timer {
+    int id;
+    int timeout;
+    bool removed;
+    bool started;
+    virEventTimeoutCallback cb;
+    void *opaque;
+    virFreeCallback ff;
+    uv_timer_t timer;
+};
+
+static uv_mutex_t lock;
+
+static uv_thread_t loopThread;
+
+// the default loop, i.e. the loop of the main thread
+static uv_loop_t *loop;
+
+static uv_async_t async;
+
+static int nextWatch = 1;
+
+static int nextTimer = 1;
+
+static std::map<int, Watch*> watches;
+
+static std::map<int, Timer*> timers;
+
+// ids rather than pointers, a watch may be gone before the async fires
+static std::vector<int> dirtyWatches;
+
+static std::vector<int> dirtyTimers;
+
+// removed before they ever reached the loop, released on the next wake-up
+static std::vector<Watch*> deadWatches;
+
+static std::vector<Timer*> deadTimers;
+
+static inline bool isLoopThread() {
+    if (NULL == loop) {
+        return false;
+    }
+
+    uv_thread_t self = uv_thread_self();
+    return 0 != uv_thread_equal(&self, &loopThread);
+}
+
+static inline int toUvEvents(int events) {
+    int uvEvents = 0;
+
+    if (events & VIR_EVENT_HANDLE_READABLE) {
+        uvEvents |= UV_READABLE;
+    }
+
+    if (events & VIR_EVENT_HANDLE_WRITABLE) {
+        uvEvents |= UV_WRITABLE;
+    }
+
+    return uvEvents;
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+static void freeWatch(Watch *watch) {
+    if (NULL != watch->ff) {
+        watch->ff(watch->opaque);
+    }
+
+    delete watch;
+}
+
+static void onWatchClosed(uv_handle_t *handle) {
+    freeWatch(static_cast<Watch*>(handle->data));
+}
+
+static void onPoll(uv_poll_t *handle, int status, int uvEvents) {
+    Watch *watch = static_cast<Watch*>(handle->data);
+    int events = 0;
+
+    if (status < 0) {
+        events = VIR_EVENT_HANDLE_ERROR;
+    } else {
+        if (uvEvents & UV_READABLE) {
+            events |= VIR_EVENT_HANDLE_READABLE;
+        }
+
+        if (uvEvents & UV_WRITABLE) {
+            events |= VIR_EVENT_HANDLE_WRITABLE;
+        }
+    }
+
+    uv_mutex_lock(&lock);
+    bool removed = watch->removed;
+    uv_mutex_unlock(&lock);
+
+    if (!removed) {
+        watch->cb(watch->id, watch->fd, events, watch->opaque);
+    }
+}
+
+/**
+ * Applies the desired state of the watch, must be called on the loop thread
+ * with the lock held
+ */
+static void syncWatch(Watch *watch) {
+    if (watch->removed) {
+        watches.erase(watch->id);
+
+        if (watch->started) {
+            uv_close(reinterpret_cast<uv_handle_t*>(&watch->poll), onWatchClosed);
+        } else {
+            deadWatches.push_back(watch);
+            uv_async_send(&async);
+        }
+        return;
+    }
+
+    if (!watch->started) {
+        uv_poll_init(loop, &watch->poll, watch->fd);
+        uv_unref(reinterpret_cast<uv_handle_t*>(&watch->poll));
+        watch->poll.data = watch;
+        watch->started = true;
+    }
+
+    int uvEvents = toUvEvents(watch->events);
+    if (0 == uvEvents) {
+        uv_poll_stop(&watch->poll);
+    } else {
+        uv_poll_start(&watch->poll, uvEvents, onPoll);
+    }
+}
+
+static void freeTimer(Timer *timer) {
+    if (NULL != timer->ff) {
+        timer->ff(timer->opaque);
+    }
+
+    delete timer;
+}
+
+static void onTimerClosed(uv_handle_t *handle) {
+    freeTimer(static_cast<Timer*>(handle->data));
+}
+
+static void onTimer(uv_timer_t *handle) {
+    Timer *timer = static_cast<Timer*>(handle->data);
+
+    uv_mutex_lock(&lock);
+    bool removed = timer->removed;
+    int timeout = timer->timeout;
+    uv_mutex_unlock(&lock);
+
+    if (removed) {
+        return;
+    }
+
+    // a zero timeout fires on every iteration until it is changed
+    if (0 == timeout) {
+        uv_timer_start(&timer->timer, onTimer, 0, 0);
+    }
+
+    timer->cb(timer->id, timer->opaque);
+}
+
+/**
+ * Applies the desired state of the timer, must be called on the loop thread
+ * with the lock held
+ */
+static void syncTimer(Timer *timer) {
+    if (timer->removed) {
+        timers.erase(timer->id);
+
+        if (timer->started) {
+            uv_timer_stop(&timer->timer);
+            uv_close(reinterpret_cast<uv_handle_t*>(&timer->timer), onTimerClosed);
+        } else {
+            deadTimers.push_back(timer);
+            uv_async_send(&async);
+        }
+        return;
+    }
+
+    if (!timer->started) {
+        uv_timer_init(loop, &timer->timer);
+        uv_unref(reinterpret_cast<uv_handle_t*>(&timer->timer));
+        timer->timer.data = timer;
+        timer->started = true;
+    }
+
+    if (timer->timeout < 0) {
+        uv_timer_stop(&timer->timer);
+    } else {
+        uv_timer_start(&timer->timer, onTimer, timer->timeout, timer->timeout);
+    }
+}
+
+static void onAsync(uv_async_t *handle) {
+    uv_mutex_lock(&lock);
+
+    for (size_t i = 0; i < dirtyWatches.size(); i++) {
+        std::map<int, Watch*>::iterator watch = watches.find(dirtyWatches[i]);
+        if (watch != watches.end()) {
+            syncWatch(watch->second);
+        }
+    }
+
+    for (size_t i = 0; i < dirtyTimers.size(); i++) {
+        std::map<int, Timer*>::iterator timer = timers.find(dirtyTimers[i]);
+        if (timer != timers.end()) {
+            syncTimer(timer->second);
+        }
+    }
+
+    dirtyWatches.clear();
+    dirtyTimers.clear();
+
+    std::vector<Watch*> watchesToFree;
+    std::vector<Timer*> timersToFree;
+    watchesToFree.swap(deadWatches);
+    timersToFree.swap(deadTimers);
+
+    uv_mutex_unlock(&lock);
+
+    // the free callbacks may call back into libvirt, so without the lock
+    for (size_t i = 0; i < watchesToFree.size(); i++) {
+        freeWatch(watchesToFree[i]);
+    }
+
+    for (size_t i = 0; i < timersToFree.size(); i++) {
+        freeTimer(timersToFree[i]);
+    }
+}
+
+static void scheduleWatch(Watch *watch) {
+    if (isLoopThread()) {
+        syncWatch(watch);
+    } else {
+        dirtyWatches.push_back(watch->id);
+        uv_async_send(&async);
+    }
+}
+
+static void scheduleTimer(Timer *timer) {
+    if (isLoopThread()) {
+        syncTimer(timer);
+    } else {
+        dirtyTimers.push_back(timer->id);
+        uv_async_send(&async);
+    }
+}
+
+static int addHandle(int fd, int events, virEventHandleCallback cb, void *opaque, virFreeCallback ff) {
+    Watch *watch = new Watch();
+    watch->fd = fd;
+    watch->events = events;
+    watch->removed = false;
+    watch->started = false;
+    watch->cb = cb;
+    watch->opaque = opaque;
+    watch->ff = ff;
+
+    uv_mutex_lock(&lock);
+    watch->id = nextWatch++;
+    watches[watch->id] = watch;
+    scheduleWatch(watch);
+    uv_mutex_unlock(&lock);
+
+    return watch->id;
+}
+
+static void updateHandle(int id, int events) {
+    uv_mutex_lock(&lock);
+
+    std::map<int, Watch*>::iterator i = watches.find(id);
+    if (i != watches.end() && !i->second->removed) {
+        i->second->events = events;
+        scheduleWatch(i->second);
+    }
+
+    uv_mutex_unlock(&lock);
+}
+
+static int removeHandle(int id) {
+    int result = -1;
+
+    uv_mutex_lock(&lock);
+
+    std::map<int, Watch*>::iterator i = watches.find(id);
+    if (i != watches.end() && !i->second->removed) {
+        i->second->removed = true;
+        scheduleWatch(i->second);
+        result = 0;
+    }
+
+    uv_mutex_unlock(&lock);
+
+    return result;
+}
+
+static int addTimeout(int timeout, virEventTimeoutCallback cb, void *opaque, virFreeCallback ff) {
+    Timer *timer = new Timer();
+    timer->timeout = timeout;
+    timer->removed = false;
+    timer->started = false;
+    timer->cb = cb;
+    timer->opaque = opaque;
+    timer->ff = ff;
+
+    uv_mutex_lock(&lock);
+    timer->id = nextTimer++;
+    timers[timer->id] = timer;
+    scheduleTimer(timer);
+    uv_mutex_unlock(&lock);
+
+    return timer->id;
+}
+
+static void updateTimeout(int id, int timeout) {
+    uv_mutex_lock(&lock);
+
+    std::map<int, Timer*>::iterator i = timers.find(id);
+    if (i != timers.end() && !i->second->removed) {
+        i->second->timeout = timeout;
+        scheduleTimer(i->second);
+    }
+
+    uv_mutex_unlock(&lock);
+}
+
+static int removeTimeout(int id) {
+    int result = -1;
+
+    uv_mutex_lock(&lock);
+
+    std::map<int, Timer*>::iterator i = timers.find(id);
+    if (i != timers.end() && !i->second->removed) {
+        i->second->removed = true;
+        scheduleTimer(i->second);
+        result = 0;
+    }
+
+    uv_mutex_unlock(&lock);
+
+    return result;
+}
+
 #ifdef __cplusplus
 }
 #endif
 
+/**
+ * libvirt takes a single event loop implementation per process, it runs on
+ * the default loop and is registered once the main thread loads the addon
+ */
+static void registerImpl() {
+    uv_mutex_init(&lock);
+    loopThread = uv_thread_self();
+    loop = uv_default_loop();
+
+    uv_async_init(loop, &async, onAsync);
+    uv_unref(reinterpret_cast<uv_handle_t*>(&async));
+
+    virEventRegisterImpl(addHandle, updateHandle, removeHandle, addTimeout, updateTimeout, removeTimeout);
+}
+
 namespace virt {
     namespace event {
 
+        static uv_once_t once = UV_ONCE_INIT;
+
+        bool IsLoopThread() {
+            return isLoopThread();
+        }
+
         void exports(v8::Handle<v8::Object> exports) {
+            // a worker thread must not touch the handles of the main loop,
+            // the main thread registers the loop whenever it loads the addon
+            if (uv_default_loop() == virt::Instance::Current()->loop) {
+                uv_once(&once, registerImpl);
+            }
         }
 
     } // namespace event
@@ -8,6 +8,13 @@ namespace virt {
 
         void exports(v8::Handle<v8::Object> exports);
 
+        /**
+         * Whether the calling thread runs the libvirt event loop, i.e. is
+         * the main thread and has loaded the addon. libvirt invokes the
+         * stream and domain event callbacks on this thread.
+         */
+        bool IsLoopThread();
+
     } // namespace event
 } // namespace virt
 
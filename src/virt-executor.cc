@@ -0,0 +1,119 @@
+/**
+ * Per-connection executor for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+#include "virt-executor.h"
+#include "virt-worker.h"
+
+namespace virt {
+
+    Executor *Executor::New() {
+        Executor *executor = new Executor();
+
+        uv_async_init(Instance::Current()->loop, &executor->async, OnAsync);
+        uv_unref(reinterpret_cast<uv_handle_t*>(&executor->async));
+        uv_thread_create(&executor->thread, Loop, executor);
+
+        return executor;
+    }
+
+    Executor::Executor() : pending(NULL), completed(NULL), stopping(false), stopped(false), inflight(0) {
+        uv_sem_init(&this->sem, 0);
+        this->async.data = this;
+    }
+
+    Executor::~Executor() {
+        uv_sem_destroy(&this->sem);
+    }
+
+    void Executor::Submit(Worker *worker) {
+        // keep the loop alive while there are calls in flight
+        if (0 == this->inflight++) {
+            uv_ref(reinterpret_cast<uv_handle_t*>(&this->async));
+        }
+
+        Push(this->pending, worker);
+        uv_sem_post(&this->sem);
+    }
+
+    void Executor::Stop() {
+        this->stopping.store(true, std::memory_order_release);
+        uv_sem_post(&this->sem);
+    }
+
+    void Executor::Push(std::atomic<Worker*>& list, Worker *worker) {
+        Worker *head = list.load(std::memory_order_relaxed);
+
+        do {
+            worker->next = head;
+        } while (!list.compare_exchange_weak(head, worker, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    Worker *Executor::Take(std::atomic<Worker*>& list) {
+        Worker *head = list.exchange(NULL, std::memory_order_acquire);
+        Worker *fifo = NULL;
+
+        while (NULL != head) {
+            Worker *next = head->next;
+            head->next = fifo;
+            fifo = head;
+            head = next;
+        }
+
+        return fifo;
+    }
+
+    void Executor::Loop(void *arg) {
+        Executor *self = static_cast<Executor*>(arg);
+
+        for (;;) {
+            uv_sem_wait(&self->sem);
+
+            for (Worker *worker = Take(self->pending); NULL != worker;) {
+                Worker *next = worker->next;
+                worker->Process();
+                Push(self->completed, worker);
+                uv_async_send(&self->async);
+                worker = next;
+            }
+
+            if (self->stopping.load(std::memory_order_acquire)
+                    && NULL == self->pending.load(std::memory_order_acquire)) {
+                break;
+            }
+        }
+
+        self->stopped.store(true, std::memory_order_release);
+        uv_async_send(&self->async);
+    }
+
+    void Executor::OnAsync(uv_async_t *handle) {
+        Executor *self = static_cast<Executor*>(handle->data);
+
+        // checked first, every completion pushed before stopping is visible
+        bool stopped = self->stopped.load(std::memory_order_acquire);
+
+        for (Worker *worker = Take(self->completed); NULL != worker;) {
+            Worker *next = worker->next;
+
+            if (0 == --self->inflight) {
+                uv_unref(reinterpret_cast<uv_handle_t*>(&self->async));
+            }
+
+            worker->Complete();
+            worker = next;
+        }
+
+        if (stopped) {
+            uv_thread_join(&self->thread);
+            uv_close(reinterpret_cast<uv_handle_t*>(&self->async), OnClose);
+        }
+    }
+
+    void Executor::OnClose(uv_handle_t *handle) {
+        delete static_cast<Executor*>(handle->data);
+    }
+
+} // namespace virt
@@ -0,0 +1,81 @@
+#ifndef __NODE_VIRT_EXECUTOR_H__
+#define __NODE_VIRT_EXECUTOR_H__
+
+// standard c++
+#include <atomic>
+
+// node
+#include <uv.h>
+
+namespace virt {
+
+    class Worker;
+
+    /**
+     * A dedicated native thread which executes workers strictly in
+     * submission order.
+     *
+     * libvirt serializes the RPC calls of a connection anyway, so giving
+     * each connection its own thread keeps the calls pipelined without
+     * parking blocked workers in the shared libuv thread pool.
+     *
+     * Submission and completion both go through lock-free multi-producer
+     * stacks which the consumer takes as a whole and reverses to restore
+     * FIFO order.
+     */
+    class Executor {
+    public:
+
+        /**
+         * Creates an executor and starts its thread
+         */
+        static Executor *New();
+
+        /**
+         * Queues a worker, must be called on the main thread
+         */
+        void Submit(Worker *worker);
+
+        /**
+         * Stops the thread once the queued workers have been executed, the
+         * executor releases itself afterwards and must not be used again
+         */
+        void Stop();
+
+    private:
+
+        Executor();
+
+        ~Executor();
+
+        static void Push(std::atomic<Worker*>& list, Worker *worker);
+
+        static Worker *Take(std::atomic<Worker*>& list);
+
+        static void Loop(void *arg);
+
+        static void OnAsync(uv_async_t *handle);
+
+        static void OnClose(uv_handle_t *handle);
+
+        uv_thread_t thread;
+
+        uv_sem_t sem;
+
+        uv_async_t async;
+
+        std::atomic<Worker*> pending;
+
+        std::atomic<Worker*> completed;
+
+        std::atomic<bool> stopping;
+
+        std::atomic<bool> stopped;
+
+        // only accessed on the main thread
+        unsigned int inflight;
+    };
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_EXECUTOR_H__ */
@@ -0,0 +1,61 @@
+#ifndef __NODE_VIRT_EXTERNAL_STRING_H__
+#define __NODE_VIRT_EXTERNAL_STRING_H__
+
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+// node
+#include <node.h>
+
+namespace virt {
+
+    /**
+     * A malloc'd ASCII buffer exposed to V8 without copying, the buffer is
+     * released once the string has been collected.
+     */
+    class ExternalString : public v8::String::ExternalOneByteStringResource {
+    public:
+
+        /**
+         * Creates a JS string of the buffer and takes the ownership of it.
+         * Pure ASCII buffers become external strings, anything else is
+         * decoded as UTF-8 and freed immediately.
+         */
+        static v8::Local<v8::String> New(v8::Isolate *isolate, char *str) {
+            size_t length = 0;
+            bool ascii = true;
+
+            for (const unsigned char *p = reinterpret_cast<unsigned char*>(str); *p; p++, length++) {
+                ascii = ascii && *p < 0x80;
+            }
+
+            if (ascii && length > 0) {
+                return v8::String::NewExternal(isolate, new ExternalString(str, length));
+            }
+
+            v8::Local<v8::String> result = v8::String::NewFromUtf8(isolate, str);
+            free(str);
+            return result;
+        }
+
+        virtual ~ExternalString() {
+            free(this->str);
+        }
+
+        virtual const char *data() const { return this->str; }
+
+        virtual size_t length() const { return this->len; }
+
+    private:
+
+        inline ExternalString(char *str, size_t length) : str(str), len(length) {}
+
+        char *str;
+
+        size_t len;
+    };
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_EXTERNAL_STRING_H__ */
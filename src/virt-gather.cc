@@ -0,0 +1,538 @@
+/**
+ * Scatter/gather of host queries for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// standard c++
+#include <string>
+#include <vector>
+
+// node
+#include <uv.h>
+
+#include "virt-gather.h"
+#include "virt-host.h"
+#include "virt-thread-pool.h"
+#include "virt-worker.h"
+
+/**
+ * Every connection of a gather is a slot which runs all queries in a row on
+ * one of the threads of virt-thread-pool, so a slow host only holds up its
+ * own slot. A slot which runs longer than the timeout is given up: the
+ * gather reports it as timed out, the pool replaces the thread stuck in it
+ * and the slot is released once its blocked call returns.
+ */
+
+namespace {
+
+    class Gather;
+
+    struct Event;
+
+    static void onEvent(void *data);
+
+    static uv_mutex_t lock;
+
+    static uv_once_t once = UV_ONCE_INIT;
+
+    class Slot : public virt::threadpool::Job {
+    public:
+
+        virtual ~Slot() {
+            for (size_t i = 0; i < this->workers.size(); i++) {
+                delete this->workers[i];
+            }
+        }
+
+        virtual void Run() {
+            uv_mutex_lock(&lock);
+            this->started = uv_hrtime();
+            uv_mutex_unlock(&lock);
+
+            this->Notify(false);
+
+            for (size_t i = 0; i < this->workers.size(); i++) {
+                this->workers[i]->Process();
+            }
+
+            uv_mutex_lock(&lock);
+            this->finished = uv_hrtime();
+            uv_mutex_unlock(&lock);
+        }
+
+        virtual void Done() {
+            this->Notify(true);
+        }
+
+        /**
+         * Drops the reference of the slot, which may be the last one of a
+         * connection closed in the meantime, so not on the loop thread
+         */
+        void Release() {
+            uv_work_t *request = new uv_work_t();
+            request->data = this;
+
+            uv_queue_work(this->instance->loop, request, [](uv_work_t *request) {
+                Slot *slot = static_cast<Slot*>(request->data);
+                if (NULL != slot->conn) {
+                    virConnectClose(slot->conn);
+                }
+            }, [](uv_work_t *request, int status) {
+                delete static_cast<Slot*>(request->data);
+                delete request;
+            });
+        }
+
+        // the isolate which started the gather
+        virt::Instance *instance;
+        Gather *gather;
+        size_t index;
+        virConnectPtr conn;
+        std::vector<virt::Worker*> workers;
+        // set by the pool thread under the lock
+        uint64_t started;
+        uint64_t finished;
+
+    private:
+
+        /**
+         * Hands the progress of the slot to the isolate of the gather, a
+         * slot finishing after the isolate is gone is released right here
+         */
+        void Notify(bool finished);
+    };
+
+    struct Event {
+        Slot *slot;
+        bool finished;
+    };
+
+    struct Query {
+        const virt::host::Query *query;
+        int args[2];
+    };
+
+    void Slot::Notify(bool finished) {
+        Event *event = new Event();
+        event->slot = this;
+        event->finished = finished;
+
+        if (!this->instance->Post(onEvent, event)) {
+            delete event;
+
+            if (finished) {
+                if (NULL != this->conn) {
+                    virConnectClose(this->conn);
+                }
+                delete this;
+            }
+        }
+    }
+
+    class Gather {
+    public:
+
+        inline Gather(v8::Isolate *isolate, v8::Local<v8::Function> callback, uint64_t timeout)
+            : timeout(timeout), remaining(0) {
+            this->sample.binding = NULL;
+            this->instance = virt::Instance::Current();
+            this->callback.Reset(isolate, callback);
+            uv_timer_init(this->instance->loop, &this->timer);
+            this->timer.data = this;
+        }
+
+        void Add(Slot *slot) {
+            slot->gather = this;
+            slot->index = this->slots.size();
+            this->slots.push_back(slot);
+            this->timedOut.push_back(false);
+
+            if (NULL != slot->conn) {
+                this->remaining++;
+            }
+        }
+
+        void Start() {
+            // the loop waits for the slots
+            this->instance->Ref();
+
+            // nothing to wait for, still answered on a later tick like
+            // every other callback
+            if (0 == this->remaining) {
+                uv_timer_start(&this->timer, OnTimer, 0, 0);
+                return;
+            }
+
+            for (size_t i = 0; i < this->slots.size(); i++) {
+                if (NULL != this->slots[i]->conn) {
+                    virt::threadpool::Submit(this->slots[i]);
+                }
+            }
+        }
+
+        void OnStarted(Slot *slot) {
+            this->Arm();
+        }
+
+        void OnFinished(Slot *slot) {
+            if (0 == --this->remaining) {
+                this->Complete();
+            } else {
+                this->Arm();
+            }
+        }
+
+    private:
+
+        /**
+         * Schedules the timer for the earliest deadline of the running slots
+         */
+        void Arm() {
+            if (0 == this->timeout) {
+                return;
+            }
+
+            uint64_t now = uv_hrtime();
+            uint64_t due = 0;
+
+            uv_mutex_lock(&lock);
+            for (size_t i = 0; i < this->slots.size(); i++) {
+                Slot *slot = this->slots[i];
+                if (NULL != slot && 0 != slot->started && 0 == slot->finished && !this->timedOut[i]) {
+                    uint64_t deadline = slot->started + this->timeout;
+                    if (0 == due || deadline < due) {
+                        due = deadline;
+                    }
+                }
+            }
+            uv_mutex_unlock(&lock);
+
+            if (0 == due) {
+                uv_timer_stop(&this->timer);
+            } else {
+                uv_timer_start(&this->timer, OnTimer, due > now ? (due - now + 999999) / 1000000 : 0, 0);
+            }
+        }
+
+        static void OnTimer(uv_timer_t *handle) {
+            Gather *self = static_cast<Gather*>(handle->data);
+            uint64_t now = uv_hrtime();
+            std::vector<size_t> expired;
+
+            uv_mutex_lock(&lock);
+            for (size_t i = 0; i < self->slots.size(); i++) {
+                Slot *slot = self->slots[i];
+                if (NULL != slot && 0 != slot->started && 0 == slot->finished
+                        && !self->timedOut[i] && now >= slot->started + self->timeout
+                        && virt::threadpool::Abandon(slot)) {
+                    // the slot is released once it finishes
+                    slot->gather = NULL;
+                    self->slots[i] = NULL;
+                    expired.push_back(i);
+                }
+            }
+            uv_mutex_unlock(&lock);
+
+            for (size_t i = 0; i < expired.size(); i++) {
+                self->timedOut[expired[i]] = true;
+                self->remaining--;
+            }
+
+            if (0 == self->remaining) {
+                self->Complete();
+            } else {
+                self->Arm();
+            }
+        }
+
+        static void OnClose(uv_handle_t *handle) {
+            delete static_cast<Gather*>(handle->data);
+        }
+
+        v8::Local<v8::Object> SlotResult(v8::Isolate *isolate, size_t i) {
+            v8::Local<v8::Object> result = v8::Object::New(isolate);
+            Slot *slot = this->slots[i];
+
+            if (this->timedOut[i]) {
+                result->Set(v8::String::NewFromUtf8(isolate, "error"), v8::String::NewFromUtf8(isolate, "Timed out"));
+                result->Set(v8::String::NewFromUtf8(isolate, "elapsed"), v8::Number::New(isolate, this->timeout / 1e6));
+                return result;
+            }
+
+            if (NULL == slot->conn) {
+                result->Set(v8::String::NewFromUtf8(isolate, "error"), v8::String::NewFromUtf8(isolate, "Connection is closed"));
+                result->Set(v8::String::NewFromUtf8(isolate, "elapsed"), v8::Number::New(isolate, 0));
+                return result;
+            }
+
+            v8::Local<v8::Object> errors = v8::Object::New(isolate);
+            bool failed = false;
+
+            for (size_t j = 0; j < slot->workers.size(); j++) {
+                virt::Worker *worker = slot->workers[j];
+                v8::Local<v8::String> name = v8::String::NewFromUtf8(isolate, this->names[j].c_str());
+
+                if (worker->HasError()) {
+                    errors->Set(name, v8::String::NewFromUtf8(isolate, worker->GetError()));
+                    failed = true;
+                } else {
+                    result->Set(name, worker->Result(isolate));
+                }
+            }
+
+            if (failed) {
+                result->Set(v8::String::NewFromUtf8(isolate, "errors"), errors);
+            }
+
+            result->Set(v8::String::NewFromUtf8(isolate, "elapsed"), v8::Number::New(isolate, (slot->finished - slot->started) / 1e6));
+            return result;
+        }
+
+        void Complete() {
+            v8::Isolate *isolate = v8::Isolate::GetCurrent();
+            v8::HandleScope scope(isolate);
+            v8::Local<v8::Array> results = v8::Array::New(isolate, this->slots.size());
+            uint64_t started = uv_hrtime();
+
+            for (size_t i = 0; i < this->slots.size(); i++) {
+                results->Set(i, this->SlotResult(isolate, i));
+
+                if (NULL != this->slots[i]) {
+                    this->slots[i]->Release();
+                }
+            }
+
+            if (NULL != this->sample.binding) {
+                virt::stats::Complete(&this->sample, uv_hrtime() - started, false);
+            }
+
+            v8::Local<v8::Function> cb = v8::Local<v8::Function>::New(isolate, this->callback);
+            v8::Local<v8::Value> argv[] = { v8::Null(isolate), results };
+
+            this->callback.Reset();
+            uv_timer_stop(&this->timer);
+            uv_close(reinterpret_cast<uv_handle_t*>(&this->timer), OnClose);
+
+            this->instance->Unref();
+
+            node::MakeCallback(isolate, isolate->GetCurrentContext()->Global(), cb, 2, argv);
+        }
+
+    public:
+
+        // result keys of the queries
+        std::vector<std::string> names;
+
+        // timing of the whole gather while the instrumentation is enabled
+        virt::stats::Sample sample;
+
+    private:
+
+        v8::Persistent<v8::Function> callback;
+
+        // in nanoseconds, 0 for none
+        uint64_t timeout;
+
+        std::vector<Slot*> slots;
+
+        std::vector<bool> timedOut;
+
+        size_t remaining;
+
+        uv_timer_t timer;
+
+        virt::Instance *instance;
+    };
+
+    static void onEvent(void *data) {
+        Event *event = static_cast<Event*>(data);
+        Slot *slot = event->slot;
+        bool finished = event->finished;
+
+        delete event;
+
+        // given up slots have been answered already
+        if (NULL == slot->gather) {
+            if (finished) {
+                slot->Release();
+            }
+            return;
+        }
+
+        if (finished) {
+            slot->gather->OnFinished(slot);
+        } else {
+            slot->gather->OnStarted(slot);
+        }
+    }
+
+    static void initialize() {
+        uv_mutex_init(&lock);
+    }
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Parses a query given as method name or as array of the method name and
+ * its integer arguments
+ */
+static bool parseQuery(v8::Local<v8::Value> value, Query *query, std::string *name) {
+    v8::Local<v8::Value> method = value;
+    v8::Local<v8::Array> array;
+
+    if (value->IsArray()) {
+        array = v8::Local<v8::Array>::Cast(value);
+        method = array->Get(0);
+    }
+
+    if (!method->IsString()) {
+        return false;
+    }
+
+    v8::String::Utf8Value utf8(method);
+    if (NULL == (query->query = virt::host::FindQuery(*utf8))) {
+        return false;
+    }
+
+    *name = *utf8;
+
+    for (int i = 0; i < query->query->nargs; i++) {
+        query->args[i] = query->query->defaults[i];
+
+        if (!array.IsEmpty() && array->Length() > static_cast<uint32_t>(i + 1)) {
+            v8::Local<v8::Value> arg = array->Get(i + 1);
+            if (!arg->IsInt32()) {
+                return false;
+            }
+
+            query->args[i] = arg->Int32Value();
+        }
+    }
+
+    return true;
+}
+
+static void __gather(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Array);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Array);
+    CHK_ARGUMENT_TYPE(isolate, args[args.Length() - 1], Function);
+
+    v8::Local<v8::Array> conns = v8::Local<v8::Array>::Cast(args[0]);
+    v8::Local<v8::Array> specs = v8::Local<v8::Array>::Cast(args[1]);
+    std::vector<Query> queries(specs->Length());
+    std::vector<std::string> names(specs->Length());
+    uint64_t timeout = 0;
+
+    for (uint32_t i = 0; i < specs->Length(); i++) {
+        if (!parseQuery(specs->Get(i), &queries[i], &names[i])) {
+            virt::throwTypeError(isolate, "Invalid query");
+            return;
+        }
+    }
+
+    if (args.Length() > 3 && args[2]->IsObject()) {
+        v8::Local<v8::Value> value = v8::Local<v8::Object>::Cast(args[2])->Get(v8::String::NewFromUtf8(isolate, "timeout"));
+
+        if (value->IsNumber() && value->NumberValue() > 0) {
+            timeout = static_cast<uint64_t>(value->NumberValue() * 1e6);
+        }
+    }
+
+    std::vector<virConnectPtr> ptrs(conns->Length());
+
+    for (uint32_t i = 0; i < conns->Length(); i++) {
+        v8::Local<v8::Value> conn = conns->Get(i);
+
+        virt::host::Connection *native = virt::host::Connection::Cast<virt::host::Connection>(conn);
+        if (NULL == native) {
+            virt::throwTypeError(isolate, "Invalid connection");
+            return;
+        }
+
+        // a closed connection only fails its own slot
+        ptrs[i] = **native;
+    }
+
+    Gather *gather = new Gather(isolate, v8::Local<v8::Function>::Cast(args[args.Length() - 1]), timeout);
+    gather->names = names;
+    virt::stats::Defer(&gather->sample);
+
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        Slot *slot = new Slot();
+        slot->instance = virt::Instance::Current();
+        slot->conn = ptrs[i];
+        slot->started = 0;
+        slot->finished = 0;
+
+        if (NULL == slot->conn) {
+            gather->Add(slot);
+            continue;
+        }
+
+        // the slot may outlive the wrapper when it is given up
+        virConnectRef(slot->conn);
+
+        for (size_t j = 0; j < queries.size(); j++) {
+            virt::Worker *worker = queries[j].query->create(slot->conn, queries[j].args);
+
+            // the libvirt time of the queries is accounted to the gather
+            if (NULL != virt::stats::Current()) {
+                worker->sample.binding = virt::stats::Current()->binding;
+            }
+
+            slot->workers.push_back(worker);
+        }
+
+        gather->Add(slot);
+    }
+
+    gather->Start();
+}
+
+static void __setGatherConcurrency(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Uint32);
+
+    unsigned int n = args[0]->Uint32Value();
+    if (0 == n) {
+        virt::throwTypeError(isolate, "Invalid arguments");
+        return;
+    }
+
+    virt::threadpool::SetLimit(n);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace virt {
+    namespace gather {
+
+        void exports(v8::Handle<v8::Object> exports) {
+            // the lock is shared by all isolates
+            uv_once(&once, initialize);
+
+            VIRT_SET_METHOD(exports, "gather",                              __gather);
+            VIRT_SET_METHOD(exports, "setGatherConcurrency",                __setGatherConcurrency);
+        }
+
+    } // namespace gather
+} // namespace virt
@@ -0,0 +1,20 @@
+#ifndef __NODE_VIRT_GATHER_H__
+#define __NODE_VIRT_GATHER_H__
+
+// node
+#include <node.h>
+
+namespace virt {
+    namespace gather {
+
+        /**
+         * Exports <code>gather</code>, which runs host queries against many
+         * connections at once on a bounded pool of native threads, and
+         * <code>setGatherConcurrency</code>
+         */
+        void exports(v8::Handle<v8::Object> exports);
+
+    } // namespace gather
+} // namespace virt
+
+#endif /* __NODE_VIRT_GATHER_H__ */
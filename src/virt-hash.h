@@ -0,0 +1,44 @@
+#ifndef __NODE_VIRT_HASH_H__
+#define __NODE_VIRT_HASH_H__
+
+// standard c
+#include <stddef.h>
+#include <stdint.h>
+
+namespace virt {
+    namespace hash {
+
+        static const uint64_t kOffsetBasis = 14695981039346656037ULL;
+
+        static const uint64_t kPrime = 1099511628211ULL;
+
+        /**
+         * FNV-1a of <code>length</code> bytes, continuing from
+         * <code>h</code>. Not collision resistant, but good enough to tell
+         * whether a description changed.
+         */
+        inline uint64_t Fnv1a(const void *data, size_t length, uint64_t h = kOffsetBasis) {
+            const unsigned char *p = static_cast<const unsigned char*>(data);
+
+            for (size_t i = 0; i < length; i++) {
+                h = (h ^ p[i]) * kPrime;
+            }
+
+            return h;
+        }
+
+        /**
+         * FNV-1a of a NUL terminated string, continuing from <code>h</code>
+         */
+        inline uint64_t Fnv1a(const char *str, uint64_t h = kOffsetBasis) {
+            for (const unsigned char *p = reinterpret_cast<const unsigned char*>(str); *p; p++) {
+                h = (h ^ *p) * kPrime;
+            }
+
+            return h;
+        }
+
+    } // namespace hash
+} // namespace virt
+
+#endif /* __NODE_VIRT_HASH_H__ */
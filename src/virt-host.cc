@@ -9,379 +9,650 @@
 #include <stdlib.h>
 #include <string.h>
 
+// standard c++
+#include <map>
+#include <string>
+
+#include "virt-arena.h"
+#include "virt-bitset.h"
+#include "virt-domain.h"
+#include "virt-external-string.h"
 #include "virt-host.h"
+#include "virt-pool.h"
+#include "virt-storage.h"
+#include "virt-stream.h"
+#include "virt-typed-parameter.h"
+#include "virt-worker.h"
+#include "virt-xml.h"
+
+int PointerTraits<virConnectPtr>::Release(virConnectPtr conn) {
+    virt::pool::Release(conn);
+    return virConnectClose(conn);
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Runs the worker unless the query has a cached result, the result is
+ * cached on success if caching is enabled for the query
+ */
+static void runCached(const v8::FunctionCallbackInfo<v8::Value>& args, virt::host::Connection *native,
+        const char *query, const std::string& arg, virt::Worker *worker) {
+    v8::Isolate *isolate = args.GetIsolate();
+    virt::Cache *cache = native->GetCache();
+
+    if (NULL == cache || !cache->IsEnabled(query)) {
+        virt::Worker::Run(args, worker, native->GetExecutor());
+        return;
+    }
+
+    // a dropped connection will be reopened to a host which may differ
+    if (1 != virConnectIsAlive(**native)) {
+        cache->Clear();
+    }
+
+    v8::Local<v8::Value> value = cache->Get(isolate, query, arg);
+    if (!value.IsEmpty()) {
+        delete worker;
+        virt::Worker::Run(args, new virt::CachedWorker(isolate, value));
+        return;
+    }
+
+    virt::Worker::Run(args, new virt::CachingWorker(cache, query, arg, worker), native->GetExecutor());
+}
+
+/**
+ * Worker of a call returning a string which should be freed by caller, an
+ * XML document is reduced to the selected values if an extractor is given
+ */
+class ConnectStringWorker : public virt::Worker {
+public:
+    typedef char *(*Function)(virConnectPtr conn);
+
+    inline ConnectStringWorker(virConnectPtr conn, Function fn, virt::xml::Extractor *extractor = NULL)
+        : conn(conn), fn(fn), str(NULL), extractor(extractor) {}
+
+    virtual ~ConnectStringWorker() {
+        free(this->str);
+        delete this->extractor;
+    }
+
+    virtual void Execute() {
+        if (NULL == (this->str = this->fn(this->conn))) {
+            this->SetVirtError();
+            return;
+        }
+
+        if (NULL != this->extractor) {
+            this->extractor->Parse(this->str);
+            free(this->str);
+            this->str = NULL;
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        if (NULL != this->extractor) {
+            return this->extractor->Result(isolate);
+        }
+
+        char *str = this->str;
+        this->str = NULL;
+        return virt::ExternalString::New(isolate, str);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    Function fn;
+    char *str;
+    virt::xml::Extractor *extractor;
+};
+
+/**
+ * Worker of a call returning 1 for true, 0 for false and -1 on error
+ */
+class ConnectBooleanWorker : public virt::Worker {
+public:
+    typedef int (*Function)(virConnectPtr conn);
+
+    inline ConnectBooleanWorker(virConnectPtr conn, Function fn) : conn(conn), fn(fn), result(0) {}
+
+    virtual void Execute() {
+        if (-1 == (this->result = this->fn(this->conn))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Boolean::New(isolate, this->result != 0);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    Function fn;
+    int result;
+};
+
+/**
+ * Worker of a call retrieving a version number
+ */
+class ConnectVersionWorker : public virt::Worker {
+public:
+    typedef int (*Function)(virConnectPtr conn, unsigned long *ver);
+
+    inline ConnectVersionWorker(virConnectPtr conn, Function fn) : conn(conn), fn(fn), ver(0) {}
+
+    virtual void Execute() {
+        if (-1 == this->fn(this->conn, &this->ver)) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Number::New(isolate, this->ver);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    Function fn;
+    unsigned long ver;
+};
+
+/**
+ * The CPU descriptions live in the arena of the worker
+ */
+class BaselineCPUWorker : public virt::Worker {
+public:
+    inline BaselineCPUWorker(virConnectPtr conn, unsigned int ncpus, unsigned int flags)
+        : conn(conn), ncpus(ncpus), flags(flags), cpu(NULL) {
+        this->xmlCPUs = this->arena.Allocate<const char*>(ncpus);
+    }
+
+    virtual ~BaselineCPUWorker() {
+        free(this->cpu);
+    }
+
+    virtual void Execute() {
+        this->cpu = virConnectBaselineCPU(this->conn, this->xmlCPUs, this->ncpus, this->flags);
+        if (NULL == this->cpu) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        char *cpu = this->cpu;
+        this->cpu = NULL;
+        return virt::ExternalString::New(isolate, cpu);
+    }
+
+    virt::Arena arena;
+
+    const char **xmlCPUs;
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned int ncpus;
+    unsigned int flags;
+    char *cpu;
+};
+
 static void __virConnectBaselineCPU(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
-    // check arg1
-    CHK_ARGUMENT_TYPE(isolate, args[1], Array);
-    v8::Local<v8::Array> cpus = v8::Local<v8::Array>::Cast(args[1]);
-    for (unsigned int i = 0, n = (*cpus)->Length(); i < n; i++) {
-        v8::Local<v8::Value> item = cpus->Get(i);
-        CHK_ARGUMENT_TYPE(isolate, item, String);
-    }
-    // check arg2
-    CHK_ARGUMENT_TYPE(isolate, args[2], Uint32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Array);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Uint32);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    v8::Local<v8::Array> cpus = v8::Local<v8::Array>::Cast(args[0]);
+    unsigned int ncpus = cpus->Length();
+    BaselineCPUWorker *worker = new BaselineCPUWorker(**native, ncpus, args[1]->Uint32Value());
 
-    unsigned int ncpus = (*cpus)->Length();
-    unsigned int flags = args[2]->Uint32Value();
-    char **xmlCPU = new char*[ncpus];
+    if (NULL == worker->xmlCPUs) {
+        delete worker;
+        virt::throwError(isolate, "Out of memory");
+        return;
+    }
 
     for (unsigned int i = 0; i < ncpus; i++) {
-        v8::String::Utf8Value xml(cpus->Get(i)->ToString());
-        xmlCPU[i] = strdup(*xml);
+        v8::Local<v8::Value> item = cpus->Get(i);
+
+        if (!item->IsString()) {
+            delete worker;
+            virt::throwTypeError(isolate, "Invalid arguments");
+            return;
+        }
+
+        worker->xmlCPUs[i] = worker->arena.Copy(v8::Local<v8::String>::Cast(item));
+
+        if (NULL == worker->xmlCPUs[i]) {
+            delete worker;
+            virt::throwError(isolate, "Out of memory");
+            return;
+        }
     }
 
-    char *cpu = virConnectBaselineCPU(**native, const_cast<const char**>(xmlCPU), ncpus, flags);
+    virt::Worker::Run(args, worker, native->GetExecutor());
+}
 
-    for (unsigned int i = 0; i < ncpus; i++) {
-        free(xmlCPU[i]);
+/**
+ * Takes over the reference of the wrapper, which is null from the start so
+ * that neither another close nor any other call reaches the connection
+ */
+class CloseWorker : public virt::Worker {
+public:
+    inline CloseWorker(virt::host::Connection *native) : conn(**native), mirror(native->GetMirror()), inventory(native->GetInventory()), result(0) {
+        native->SetMirror(NULL);
+        native->SetInventory(NULL);
+        native->SetNull();
     }
-    delete xmlCPU;
 
-    if (NULL == cpu) {
-        virt::throwVirtError(isolate);
-        return;
+    virtual void Execute() {
+        // the registered events would keep the connection open
+        if (NULL != this->mirror) {
+            this->mirror->Stop();
+        }
+
+        if (NULL != this->inventory) {
+            this->inventory->Stop();
+        }
+
+        // unreachable once the wrapper is null
+        virt::domain::RemoveListeners(this->conn);
+
+        virt::pool::Release(this->conn);
+        this->result = virConnectClose(this->conn);
     }
 
-    args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, cpu));
-    free(cpu);
-}
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Number::New(isolate, this->result);
+    }
+
+private:
+    virConnectPtr conn;
+    virt::mirror::Mirror *mirror;
+    virt::inventory::Tracker *inventory;
+    int result;
+};
 
 static void __virConnectClose(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int result = virConnectClose(**native);
-    if (-1 != result) {
-        native->SetNull();
-    }
+    // queued behind the calls made so far, the thread stops after the close
+    virt::Executor *executor = native->GetExecutor();
+    virt::Worker::Run(args, new CloseWorker(native), executor);
+    native->SetDedicatedThread(false);
 
-    args.GetReturnValue().Set(v8::Number::New(isolate, result));
+    if (NULL != native->GetCache()) {
+        native->GetCache()->Clear();
+    }
 }
 
+class CompareCPUWorker : public virt::Worker {
+public:
+    inline CompareCPUWorker(virConnectPtr conn, const char *xml, unsigned int flags)
+        : conn(conn), xml(strdup(xml)), flags(flags), result(VIR_CPU_COMPARE_ERROR) {}
+
+    virtual ~CompareCPUWorker() {
+        free(this->xml);
+    }
+
+    virtual void Execute() {
+        if (VIR_CPU_COMPARE_ERROR == (this->result = virConnectCompareCPU(this->conn, this->xml, this->flags))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Number::New(isolate, this->result);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    char *xml;
+    unsigned int flags;
+    int result;
+};
+
 static void __virConnectCompareCPU(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
-    CHK_ARGUMENT_TYPE(isolate, args[1], String);
-    CHK_ARGUMENT_TYPE(isolate, args[2], Uint32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Uint32);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    v8::String::Utf8Value xml(args[1]->ToString());
-    unsigned int flags = args[2]->Uint32Value();
-    int result = virConnectCompareCPU(**native, *xml, flags);
-    if (VIR_CPU_COMPARE_ERROR == result) {
-        virt::throwVirtError(isolate);
-        return;
-    }
-
-    args.GetReturnValue().Set(v8::Number::New(isolate, result));
+    v8::String::Utf8Value xml(args[0]->ToString());
+    unsigned int flags = args[1]->Uint32Value();
+    virt::Worker::Run(args, new CompareCPUWorker(**native, *xml, flags), native->GetExecutor());
 }
 
 static void __virConnectGetCapabilities(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    char *xml = virConnectGetCapabilities(**native);
-    if (NULL == xml) {
-        virt::throwVirtError(isolate);
+    // the selected values are not cached, only the whole document
+    if (args.Length() > 0 && args[0]->IsArray()) {
+        virt::xml::Extractor *extractor = virt::xml::Extractor::New(isolate, args[0]);
+        if (NULL != extractor) {
+            virt::Worker::Run(args, new ConnectStringWorker(**native, virConnectGetCapabilities, extractor), native->GetExecutor());
+        }
         return;
     }
 
-    args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, xml));
-    free(xml);
+    runCached(args, native, "capabilities", "", new ConnectStringWorker(**native, virConnectGetCapabilities));
 }
 
 static void __virConnectGetHostname(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
-
-    char *hostname = virConnectGetHostname(**native);
-    if (NULL == hostname) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, hostname));
-    free(hostname);
+    runCached(args, native, "hostname", "", new ConnectStringWorker(**native, virConnectGetHostname));
 }
 
 static void __virConnectGetLibVersion(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    unsigned long ver = 0;
-    if (-1 == virConnectGetLibVersion(**native, &ver)) {
-        virt::throwVirtError(isolate);
-        return;
+    runCached(args, native, "libVersion", "", new ConnectVersionWorker(**native, virConnectGetLibVersion));
+}
+
+class GetMaxVcpusWorker : public virt::Worker {
+public:
+    inline GetMaxVcpusWorker(virConnectPtr conn, const char *type) : conn(conn), type(strdup(type)), max(0) {}
+
+    virtual ~GetMaxVcpusWorker() {
+        free(this->type);
     }
 
-    args.GetReturnValue().Set(v8::Number::New(isolate, ver));
-}
+    virtual void Execute() {
+        if (-1 == (this->max = virConnectGetMaxVcpus(this->conn, this->type))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Number::New(isolate, this->max);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    char *type;
+    int max;
+};
 
 static void __virConnectGetMaxVcpus(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
-    CHK_ARGUMENT_TYPE(isolate, args[1], String);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    v8::String::Utf8Value type(args[1]->ToString());
-    int max = virConnectGetMaxVcpus(**native, *type);
-    if (-1 == max) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    v8::String::Utf8Value type(args[0]->ToString());
+    runCached(args, native, "maxVcpus", *type, new GetMaxVcpusWorker(**native, *type));
+}
 
-    args.GetReturnValue().Set(v8::Number::New(isolate, max));
+static char *getSysinfo(virConnectPtr conn) {
+    return virConnectGetSysinfo(conn, 0);
 }
 
 static void __virConnectGetSysinfo(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    char *xml = virConnectGetSysinfo(**native, 0);
-    if (NULL == xml) {
-        virt::throwVirtError(isolate);
+    // the selected values are not cached, only the whole document
+    if (args.Length() > 0 && args[0]->IsArray()) {
+        virt::xml::Extractor *extractor = virt::xml::Extractor::New(isolate, args[0]);
+        if (NULL != extractor) {
+            virt::Worker::Run(args, new ConnectStringWorker(**native, getSysinfo, extractor), native->GetExecutor());
+        }
         return;
     }
 
-    args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, xml));
-    free(xml);
+    runCached(args, native, "sysinfo", "", new ConnectStringWorker(**native, getSysinfo));
 }
 
+class GetTypeWorker : public virt::Worker {
+public:
+    inline GetTypeWorker(virConnectPtr conn) : conn(conn), type(NULL) {}
+
+    virtual void Execute() {
+        if (NULL == (this->type = virConnectGetType(this->conn))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::String::NewFromUtf8(isolate, this->type);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    const char *type;
+};
+
 static void __virConnectGetType(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
-
-    const char *type = virConnectGetType(**native);
-    if (NULL == type) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, type));
+    virt::Worker::Run(args, new GetTypeWorker(**native), native->GetExecutor());
 }
 
 static void __virConnectGetURI(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    const char *uri = virConnectGetURI(**native);
-    if (NULL == uri) {
-        virt::throwVirtError(isolate);
-        return;
-    }
-
-    args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, uri));
+    virt::Worker::Run(args, new ConnectStringWorker(**native, virConnectGetURI), native->GetExecutor());
 }
 
 static void __virConnectGetVersion(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
-
-    unsigned long ver;
-    if (-1 == virConnectGetVersion(**native, &ver)) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    args.GetReturnValue().Set(v8::Number::New(isolate, ver));
+    virt::Worker::Run(args, new ConnectVersionWorker(**native, virConnectGetVersion), native->GetExecutor());
 }
 
 static void __virConnectIsAlive(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int alive = virConnectIsAlive(**native);
-    if (-1 == alive) {
-        virt::throwVirtError(isolate);
-        return;
-    }
-
-    args.GetReturnValue().Set(v8::Boolean::New(isolate, alive != 0));
+    virt::Worker::Run(args, new ConnectBooleanWorker(**native, virConnectIsAlive), native->GetExecutor());
 }
 
 static void __virConnectIsEncrypted(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
-
-    int encrypted = virConnectIsEncrypted(**native);
-    if (-1 == encrypted) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    args.GetReturnValue().Set(v8::Boolean::New(isolate, encrypted != 0));
+    virt::Worker::Run(args, new ConnectBooleanWorker(**native, virConnectIsEncrypted), native->GetExecutor());
 }
 
 static void __virConnectIsSecure(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int secure = virConnectIsSecure(**native);
-    if (-1 == secure) {
-        virt::throwVirtError(isolate);
-        return;
+    virt::Worker::Run(args, new ConnectBooleanWorker(**native, virConnectIsSecure), native->GetExecutor());
+}
+
+class OpenWorker : public virt::Worker {
+public:
+    inline OpenWorker(const char *name, bool readOnly)
+        : name(NULL == name ? NULL : strdup(name)), readOnly(readOnly), conn(NULL) {}
+
+    virtual ~OpenWorker() {
+        free(this->name);
     }
 
-    args.GetReturnValue().Set(v8::Boolean::New(isolate, secure != 0));
-}
+    virtual void Execute() {
+        if (this->readOnly) {
+            this->conn = virConnectOpenReadOnly(this->name);
+        } else {
+            this->conn = virConnectOpen(this->name);
+        }
+
+        if (NULL == this->conn) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return virt::host::Connection::NewInstance<virt::host::Connection>(this->conn);
+    }
+
+private:
+    char *name;
+    bool readOnly;
+    virConnectPtr conn;
+};
 
 static void __virConnectOpen(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
-    virConnectPtr conn = NULL;
 
-    if (0 == args.Length() || args[0]->IsUndefined() || args[0]->IsNull()) {
-        conn = virConnectOpen(NULL);
+    if (0 == args.Length() || args[0]->IsUndefined() || args[0]->IsNull() || args[0]->IsFunction()) {
+        virt::Worker::Run(args, new OpenWorker(NULL, false));
     } else if (!args[0]->IsString()) {
         virt::throwTypeError(isolate, "Invalid argument");
-        return;
     } else {
         v8::String::Utf8Value name(args[0]->ToString());
-        conn = virConnectOpen(*name);
-    }
-
-    if (NULL == conn) {
-        virt::throwVirtError(isolate);
-    } else {
-        virt::host::Connection::NewInstance<virt::host::Connection>(conn, args);
+        virt::Worker::Run(args, new OpenWorker(*name, false));
     }
 }
 
 static void __virConnectOpenReadOnly(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
-    virConnectPtr conn = NULL;
 
-    if (0 == args.Length() || args[0]->IsUndefined() || args[0]->IsNull()) {
-        conn = virConnectOpen(NULL);
+    if (0 == args.Length() || args[0]->IsUndefined() || args[0]->IsNull() || args[0]->IsFunction()) {
+        virt::Worker::Run(args, new OpenWorker(NULL, true));
     } else if (!args[0]->IsString()) {
         virt::throwTypeError(isolate, "Invalid argument");
-        return;
     } else {
         v8::String::Utf8Value name(args[0]->ToString());
-        conn = virConnectOpenReadOnly(*name);
+        virt::Worker::Run(args, new OpenWorker(*name, true));
     }
+}
 
-    if (NULL == conn) {
-        virt::throwVirtError(isolate);
-    } else {
-        virt::host::Connection::NewInstance<virt::host::Connection>(conn, args);
+class RefWorker : public virt::Worker {
+public:
+    inline RefWorker(virConnectPtr conn) : conn(conn), result(0) {}
+
+    virtual void Execute() {
+        if (-1 == (this->result = virConnectRef(this->conn))) {
+            this->SetVirtError();
+        }
     }
-}
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Boolean::New(isolate, 0 == this->result);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    int result;
+};
 
 static void __virConnectRef(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int result = virConnectRef(**native);
-    if (-1 == result) {
-        virt::throwVirtError(isolate);
-        return;
+    virt::Worker::Run(args, new RefWorker(**native), native->GetExecutor());
+}
+
+class SetKeepAliveWorker : public virt::Worker {
+public:
+    inline SetKeepAliveWorker(virConnectPtr conn, int interval, unsigned int count)
+        : conn(conn), interval(interval), count(count), result(0) {}
+
+    virtual void Execute() {
+        if (-1 == (this->result = virConnectSetKeepAlive(this->conn, this->interval, this->count))) {
+            this->SetVirtError();
+        }
     }
 
-    args.GetReturnValue().Set(v8::Boolean::New(isolate, 0 == result));
-}
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Boolean::New(isolate, 0 == this->result);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    int interval;
+    unsigned int count;
+    int result;
+};
 
 static void __virConnectSetKeepAlive(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
-    CHK_ARGUMENT_TYPE(isolate, args[1], Int32);
-    CHK_ARGUMENT_TYPE(isolate, args[2], Uint32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Uint32);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
-
-    int interval = args[1]->Int32Value();
-    unsigned int count = args[2]->Uint32Value();
-    int result = virConnectSetKeepAlive(**native, interval, count);
-    if (-1 == result) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    args.GetReturnValue().Set(v8::Boolean::New(isolate, 0 == result));
+    int interval = args[0]->Int32Value();
+    unsigned int count = args[1]->Uint32Value();
+    virt::Worker::Run(args, new SetKeepAliveWorker(**native, interval, count), native->GetExecutor());
 }
 
 static void __virGetVersion(const v8::FunctionCallbackInfo<v8::Value>& args) {
@@ -397,420 +668,592 @@ static void __virGetVersion(const v8::FunctionCallbackInfo<v8::Value>& args) {
     args.GetReturnValue().Set(v8::Number::New(isolate, libVer));
 }
 
+class GetCPUMapWorker : public virt::Worker {
+public:
+    inline GetCPUMapWorker(virConnectPtr conn) : conn(conn), cpumap(NULL), ncpu(0) {}
+
+    virtual ~GetCPUMapWorker() {
+        free(this->cpumap);
+    }
+
+    virtual void Execute() {
+        if (-1 == (this->ncpu = virNodeGetCPUMap(this->conn, &this->cpumap, NULL, 0))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        // a bit per CPU, copied since the map is freed with the worker
+        return virt::bitset::New(isolate, this->cpumap, VIR_CPU_MAPLEN(this->ncpu));
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned char *cpumap;
+    int ncpu;
+};
+
 static void __virNodeGetCPUMap(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    unsigned char *cpumap = NULL;
-    int ncpu = virNodeGetCPUMap(**native, &cpumap, NULL, 0);
-    if (-1 == ncpu) {
-        virt::throwVirtError(isolate);
-        return;
+    virt::Worker::Run(args, new GetCPUMapWorker(**native), native->GetExecutor());
+}
+
+class GetCPUStatsWorker : public virt::Worker {
+public:
+    inline GetCPUStatsWorker(virConnectPtr conn, int cpuNum) : conn(conn), cpuNum(cpuNum), params(NULL), nparams(0) {}
+
+    virtual ~GetCPUStatsWorker() {
+        free(this->params);
     }
 
-    args.GetReturnValue().Set(v8::ArrayBuffer::New(isolate, cpumap, ncpu));
+    virtual void Execute() {
+        if (0 != virNodeGetCPUStats(this->conn, this->cpuNum, NULL, &this->nparams, 0)) {
+            this->SetVirtError();
+            return;
+        }
+
+        if (this->nparams <= 0) {
+            return;
+        }
 
-    if (NULL != cpumap) {
-        free(cpumap);
+        this->params = static_cast<virNodeCPUStatsPtr>(calloc(this->nparams, sizeof(virNodeCPUStats)));
+
+        if (0 != virNodeGetCPUStats(this->conn, this->cpuNum, this->params, &this->nparams, 0)) {
+            this->SetVirtError();
+        }
     }
-}
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+
+        for (int i = 0; i < this->nparams; i++) {
+            virNodeCPUStatsPtr param = this->params + i;
+            result->Set(virt::typedparam::Key(isolate, param->field), v8::Number::New(isolate, param->value));
+        }
+
+        return result;
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    int cpuNum;
+    virNodeCPUStatsPtr params;
+    int nparams;
+};
 
 static void __virNodeGetCPUStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
-    CHK_ARGUMENT_TYPE(isolate, args[1], Int32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int nparams = 0;
-    int cpuNum = args[1]->Int32Value();
+    int cpuNum = args[0]->Int32Value();
+    virt::Worker::Run(args, new GetCPUStatsWorker(**native, cpuNum), native->GetExecutor());
+}
 
-    if (0 != virNodeGetCPUStats(**native, cpuNum, NULL, &nparams, 0)) {
-        virt::throwVirtError(isolate);
-        return;
+class GetCellsFreeMemoryWorker : public virt::Worker {
+public:
+    inline GetCellsFreeMemoryWorker(virConnectPtr conn, int start, int max)
+        : conn(conn), start(start), max(max), mems(NULL), n(0) {}
+
+    virtual ~GetCellsFreeMemoryWorker() {
+        free(this->mems);
     }
 
-    if (nparams <= 0) {
-        args.GetReturnValue().Set(v8::Object::New(isolate));
-        return;
+    virtual void Execute() {
+        this->mems = static_cast<unsigned long long*>(calloc(this->max - this->start + 1, sizeof(unsigned long long)));
+
+        if (-1 == (this->n = virNodeGetCellsFreeMemory(this->conn, this->mems, this->start, this->max))) {
+            this->SetVirtError();
+        }
     }
 
-    virNodeCPUStatsPtr params = static_cast<virNodeCPUStatsPtr>(calloc(nparams, sizeof(virNodeCPUStats)));
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Array> result = v8::Array::New(isolate, this->n);
 
-    if (0 != virNodeGetCPUStats(**native, cpuNum, params, &nparams, 0)) {
-        virt::throwVirtError(isolate);
-    } else {
-        v8::Local<v8::Object> result = v8::Object::New(isolate);
-        for (int i = 0; i < nparams; i++) {
-            virNodeCPUStatsPtr param = params + i;
-            result->Set(v8::String::NewFromUtf8(isolate, param->field), v8::Number::New(isolate, param->value));
+        for (int i = 0; i < this->n; i++) {
+            result->Set(i, v8::Number::New(isolate, this->mems[i]));
         }
-        args.GetReturnValue().Set(result);
+
+        return result;
     }
 
-    free(params);
-}
+private:
+    virt::Reference<virConnectPtr> conn;
+    int start;
+    int max;
+    unsigned long long *mems;
+    int n;
+};
 
 static void __virNodeGetCellsFreeMemory(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
     CHK_ARGUMENT_TYPE(isolate, args[1], Int32);
-    CHK_ARGUMENT_TYPE(isolate, args[2], Int32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    int start = args[0]->Int32Value();
+    int max = args[1]->Int32Value();
+    virt::Worker::Run(args, new GetCellsFreeMemoryWorker(**native, start, max), native->GetExecutor());
+}
 
-    int start = args[1]->Int32Value();
-    int max = args[2]->Int32Value();
-    unsigned long long *mems = static_cast<unsigned long long*>(calloc(max - start + 1, sizeof(unsigned long long)));
-    int n = virNodeGetCellsFreeMemory(**native, mems, start, max);
+class GetFreeMemoryWorker : public virt::Worker {
+public:
+    inline GetFreeMemoryWorker(virConnectPtr conn) : conn(conn), mem(0) {}
 
-    if (-1 == n) {
-        virt::throwVirtError(isolate);
-    } else {
-        v8::Local<v8::Array> result = v8::Array::New(isolate, n);
-        for (int i = 0; i < n; i++) {
-            result->Set(i, v8::Number::New(isolate, mems[i]));
+    virtual void Execute() {
+        if ((this->mem = virNodeGetFreeMemory(this->conn)) <= 0) {
+            this->SetVirtError();
         }
-        args.GetReturnValue().Set(result);
     }
 
-    free(mems);
-}
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Number::New(isolate, this->mem);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned long long mem;
+};
 
 static void __virNodeGetFreeMemory(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    unsigned long long mem = virNodeGetFreeMemory(**native);
-    if (mem <= 0) {
-        virt::throwVirtError(isolate);
-        return;
+    virt::Worker::Run(args, new GetFreeMemoryWorker(**native), native->GetExecutor());
+}
+
+class GetInfoWorker : public virt::Worker {
+public:
+    inline GetInfoWorker(virConnectPtr conn) : conn(conn) {
+        memset(&this->info, 0, sizeof(this->info));
     }
 
-    args.GetReturnValue().Set(v8::Number::New(isolate, mem));
-}
+    virtual void Execute() {
+        if (0 != virNodeGetInfo(this->conn, &this->info)) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        result->Set(virt::typedparam::Key(isolate, "model"), v8::String::NewFromUtf8(isolate, this->info.model));
+        result->Set(virt::typedparam::Key(isolate, "memory"), v8::Number::New(isolate, this->info.memory));
+        result->Set(virt::typedparam::Key(isolate, "cpus"), v8::Number::New(isolate, this->info.cpus));
+        result->Set(virt::typedparam::Key(isolate, "mhz"), v8::Number::New(isolate, this->info.mhz));
+        result->Set(virt::typedparam::Key(isolate, "nodes"), v8::Number::New(isolate, this->info.nodes));
+        result->Set(virt::typedparam::Key(isolate, "sockets"), v8::Number::New(isolate, this->info.sockets));
+        result->Set(virt::typedparam::Key(isolate, "cores"), v8::Number::New(isolate, this->info.cores));
+        result->Set(virt::typedparam::Key(isolate, "threads"), v8::Number::New(isolate, this->info.threads));
+        return result;
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    virNodeInfo info;
+};
 
 static void __virNodeGetInfo(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    virNodeInfo info;
-    memset(&info, 0, sizeof(info));
-    if (0 != virNodeGetInfo(**native, &info)) {
-        virt::throwVirtError(isolate);
-        return;
+    runCached(args, native, "nodeInfo", "", new GetInfoWorker(**native));
+}
+
+class GetMemoryParametersWorker : public virt::Worker {
+public:
+    inline GetMemoryParametersWorker(virConnectPtr conn) : conn(conn), params(NULL), nparams(0) {}
+
+    virtual ~GetMemoryParametersWorker() {
+        if (NULL != this->params) {
+            virTypedParamsFree(this->params, this->nparams);
+        }
     }
 
-    v8::Local<v8::Object> result = v8::Object::New(isolate);
-    result->Set(v8::String::NewFromUtf8(isolate, "model"), v8::String::NewFromUtf8(isolate, info.model));
-    result->Set(v8::String::NewFromUtf8(isolate, "memory"), v8::Number::New(isolate, info.memory));
-    result->Set(v8::String::NewFromUtf8(isolate, "cpus"), v8::Number::New(isolate, info.cpus));
-    result->Set(v8::String::NewFromUtf8(isolate, "mhz"), v8::Number::New(isolate, info.mhz));
-    result->Set(v8::String::NewFromUtf8(isolate, "nodes"), v8::Number::New(isolate, info.nodes));
-    result->Set(v8::String::NewFromUtf8(isolate, "sockets"), v8::Number::New(isolate, info.sockets));
-    result->Set(v8::String::NewFromUtf8(isolate, "cores"), v8::Number::New(isolate, info.cores));
-    result->Set(v8::String::NewFromUtf8(isolate, "threads"), v8::Number::New(isolate, info.threads));
-    args.GetReturnValue().Set(result);
-}
+    virtual void Execute() {
+        if (0 != virNodeGetMemoryParameters(this->conn, NULL, &this->nparams, 0)) {
+            this->SetVirtError();
+            return;
+        }
+
+        if (this->nparams <= 0) {
+            return;
+        }
+
+        this->params = static_cast<virTypedParameterPtr>(calloc(this->nparams, sizeof(virTypedParameter)));
+
+        if (0 != virNodeGetMemoryParameters(this->conn, this->params, &this->nparams, 0)) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        if (this->nparams <= 0) {
+            return v8::Object::New(isolate);
+        }
+
+        return virt::typedparam::ToArray(isolate, this->params, this->nparams);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    virTypedParameterPtr params;
+    int nparams;
+};
 
 static void __virNodeGetMemoryParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int nparams = 0;
-    if (0 != virNodeGetMemoryParameters(**native, NULL, &nparams, 0)) {
-        virt::throwVirtError(isolate);
-        return;
-    }
+    virt::Worker::Run(args, new GetMemoryParametersWorker(**native), native->GetExecutor());
+}
 
-    if (nparams <= 0) {
-        args.GetReturnValue().Set(v8::Object::New(isolate));
-        return;
+class GetMemoryStatsWorker : public virt::Worker {
+public:
+    inline GetMemoryStatsWorker(virConnectPtr conn, int cellNum) : conn(conn), cellNum(cellNum), params(NULL), nparams(0) {}
+
+    virtual ~GetMemoryStatsWorker() {
+        free(this->params);
     }
 
-    virTypedParameterPtr params = static_cast<virTypedParameterPtr>(calloc(nparams, sizeof(virTypedParameter)));
+    virtual void Execute() {
+        if (0 != virNodeGetMemoryStats(this->conn, this->cellNum, NULL, &this->nparams, 0)) {
+            this->SetVirtError();
+            return;
+        }
 
-    if (0 != virNodeGetMemoryParameters(**native, params, &nparams, 0)) {
-        virt::throwVirtError(isolate);
-    } else {
-        v8::Local<v8::Array> result = v8::Array::New(isolate, nparams);
-
-        for (int i = 0; i < nparams; i++) {
-            virTypedParameterPtr param = params + i;
-            v8::Local<v8::Object> item = v8::Object::New(isolate);
-
-            item->Set(v8::String::NewFromUtf8(isolate, "type"), v8::Number::New(isolate, param->type));
-            item->Set(v8::String::NewFromUtf8(isolate, "field"), v8::String::NewFromUtf8(isolate, param->field));
-
-            switch (param->type) {
-            case VIR_TYPED_PARAM_INT:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::Number::New(isolate, param->value.i));
-                break;
-            case VIR_TYPED_PARAM_UINT:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::Number::New(isolate, param->value.ui));
-                break;
-            case VIR_TYPED_PARAM_LLONG:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::Number::New(isolate, param->value.l));
-                break;
-            case VIR_TYPED_PARAM_ULLONG:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::Number::New(isolate, param->value.ul));
-                break;
-            case VIR_TYPED_PARAM_DOUBLE:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::Number::New(isolate, param->value.d));
-                break;
-            case VIR_TYPED_PARAM_BOOLEAN:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::Boolean::New(isolate, 0 != param->value.b));
-                break;
-            case VIR_TYPED_PARAM_STRING:
-                item->Set(v8::String::NewFromUtf8(isolate, "value"), v8::String::NewFromUtf8(isolate, param->value.s));
-                break;
-            }
+        if (this->nparams <= 0) {
+            return;
+        }
+
+        this->params = static_cast<virNodeMemoryStatsPtr>(calloc(this->nparams, sizeof(virNodeMemoryStats)));
+
+        if (0 != virNodeGetMemoryStats(this->conn, this->cellNum, this->params, &this->nparams, 0)) {
+            this->SetVirtError();
+        }
+    }
 
-            result->Set(i, item);
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+
+        for (int i = 0; i < this->nparams; i++)  {
+            virNodeMemoryStatsPtr param = this->params + i;
+            result->Set(virt::typedparam::Key(isolate, param->field), v8::Number::New(isolate, param->value));
         }
 
-        args.GetReturnValue().Set(result);
+        return result;
     }
 
-    free(params);
-}
+private:
+    virt::Reference<virConnectPtr> conn;
+    int cellNum;
+    virNodeMemoryStatsPtr params;
+    int nparams;
+};
 
 static void __virNodeGetMemoryStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
-    CHK_ARGUMENT_TYPE(isolate, args[1], Int32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    int cellNum = args[1]->Int32Value();    
-    int nparams = 0;
+    int cellNum = args[0]->Int32Value();
+    virt::Worker::Run(args, new GetMemoryStatsWorker(**native, cellNum), native->GetExecutor());
+}
 
-    if (0 != virNodeGetMemoryStats(**native, cellNum, NULL, &nparams, 0)) {
-        virt::throwVirtError(isolate);
-        return;
+class GetSecurityModelWorker : public virt::Worker {
+public:
+    inline GetSecurityModelWorker(virConnectPtr conn) : conn(conn) {
+        memset(&this->secmodel, 0, sizeof(virSecurityModel));
     }
 
-    if (nparams <= 0) {
-        args.GetReturnValue().Set(v8::Object::New(isolate));
-        return;
+    virtual void Execute() {
+        if (0 != virNodeGetSecurityModel(this->conn, &this->secmodel)) {
+            this->SetVirtError();
+        }
     }
 
-    virNodeMemoryStatsPtr params = static_cast<virNodeMemoryStatsPtr>(calloc(nparams, sizeof(virNodeMemoryStats)));
-
-    if (0 != virNodeGetMemoryStats(**native, cellNum, params, &nparams, 0)) {
-        virt::throwVirtError(isolate);
-    } else {
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
         v8::Local<v8::Object> result = v8::Object::New(isolate);
+        result->Set(virt::typedparam::Key(isolate, "model"), v8::String::NewFromUtf8(isolate, this->secmodel.model));
+        result->Set(virt::typedparam::Key(isolate, "doi"), v8::String::NewFromUtf8(isolate, this->secmodel.doi));
+        return result;
+    }
 
-        for (int i = 0; i < nparams; i++)  {
-            virNodeMemoryStatsPtr param = params + i;
-            result->Set(v8::String::NewFromUtf8(isolate, param->field), v8::Number::New(isolate, param->value));
-        }
+private:
+    virt::Reference<virConnectPtr> conn;
+    virSecurityModel secmodel;
+};
 
-        args.GetReturnValue().Set(result);
-    }
+static void __virNodeGetSecurityModel(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    free(params);
+    runCached(args, native, "securityModel", "", new GetSecurityModelWorker(**native));
 }
 
-static void __virNodeGetSecurityModel(const v8::FunctionCallbackInfo<v8::Value>& args) {
+/**
+ * The parameters and their strings live in the arena of the worker
+ */
+class SetMemoryParametersWorker : public virt::Worker {
+public:
+    inline SetMemoryParametersWorker(virConnectPtr conn, unsigned int flags)
+        : params(NULL), nparams(0), conn(conn), flags(flags) {}
+
+    virtual void Execute() {
+        if (0 != virNodeSetMemoryParameters(this->conn, this->params, this->nparams, this->flags)) {
+            this->SetVirtError();
+        }
+    }
+
+    virt::Arena arena;
+
+    virTypedParameterPtr params;
+
+    int nparams;
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned int flags;
+};
+
+static void __virNodeSetMemoryParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
     CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Array);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-    virSecurityModel secmodel;
-    memset(&secmodel, 0, sizeof(virSecurityModel));
-    if (0 != virNodeGetSecurityModel(**native, &secmodel)) {
-        virt::throwVirtError(isolate);
+    unsigned int flags = args.Length() > 1 && args[1]->IsUint32() ? args[1]->Uint32Value() : 0;
+    SetMemoryParametersWorker *worker = new SetMemoryParametersWorker(**native, flags);
+
+    if (!virt::typedparam::FromArray(isolate, args[0], &worker->arena, &worker->params, &worker->nparams)) {
+        delete worker;
         return;
     }
 
-    v8::Local<v8::Object> result = v8::Object::New(isolate);
-    result->Set(v8::String::NewFromUtf8(isolate, "model"), v8::String::NewFromUtf8(isolate, secmodel.model));
-    result->Set(v8::String::NewFromUtf8(isolate, "doi"), v8::String::NewFromUtf8(isolate, secmodel.doi));
-    args.GetReturnValue().Set(result);
+    virt::Worker::Run(args, worker, native->GetExecutor());
 }
 
-static void __virNodeSetMemoryParameters(const v8::FunctionCallbackInfo<v8::Value>& args) {
+class SuspendForDurationWorker : public virt::Worker {
+public:
+    inline SuspendForDurationWorker(virConnectPtr conn, unsigned int target, unsigned long long duration)
+        : conn(conn), target(target), duration(duration) {}
+
+    virtual void Execute() {
+        if (0 != virNodeSuspendForDuration(this->conn, this->target, this->duration, 0)) {
+            this->SetVirtError();
+        }
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned int target;
+    unsigned long long duration;
+};
+
+static void __virNodeSuspendForDuration(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
     CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
-    CHK_ARGUMENT_TYPE(isolate, args[1], Array);
-    v8::Local<v8::Array> arg1 = v8::Local<v8::Array>::Cast(args[1]);
-    v8::Local<v8::String> propField = v8::String::NewFromUtf8(isolate, "field");
-    v8::Local<v8::String> propType = v8::String::NewFromUtf8(isolate, "type");
-    v8::Local<v8::String> propValue = v8::String::NewFromUtf8(isolate, "value");
-    int nparams = arg1->Length();
-    for (int i = 0; i < nparams; i++) {
-        v8::Local<v8::Value> item = arg1->Get(i);
-        CHK_ARGUMENT_TYPE(isolate, item, Object);
-        v8::Local<v8::Object> obj = v8::Local<v8::Object>::Cast(item);
-
-        if (!obj->Has(propField)) {
-            virt::throwTypeError(isolate, "Property `field` not found");
-            return;
-        }
+    CHK_ARGUMENT_TYPE(isolate, args[0], Uint32);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Uint32);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
 
-        if (!obj->Get(propField)->IsString()) {
-            virt::throwTypeError(isolate, "Property `field` was supposed to be string");
-            return;
+    unsigned int target = args[0]->Uint32Value();
+    unsigned long long duration = args[1]->IntegerValue();
+    virt::Worker::Run(args, new SuspendForDurationWorker(**native, target, duration), native->GetExecutor());
+}
+
+class ListInterfacesWorker : public virt::Worker {
+public:
+    inline ListInterfacesWorker(virConnectPtr conn) : conn(conn), names(NULL), niface(0) {}
+
+    virtual ~ListInterfacesWorker() {
+        for (int i = 0; i < this->niface; i++) {
+            free(this->names[i]);
         }
 
-        if (!obj->Has(propType)) {
-            virt::throwTypeError(isolate, "Property `type` not found");
+        free(this->names);
+    }
+
+    virtual void Execute() {
+        int max = virConnectNumOfInterfaces(this->conn);
+        if (-1 == max) {
+            this->SetVirtError();
             return;
         }
 
-        if (!obj->Get(propType)->IsInt32()) {
-            virt::throwTypeError(isolate, "Property `type` was supposed to be integer");
-            return;
+        this->names = static_cast<char**>(calloc(max, sizeof(char*)));
+
+        if (-1 == (this->niface = virConnectListInterfaces(this->conn, this->names, max))) {
+            this->niface = 0;
+            this->SetVirtError();
         }
+    }
 
-        if (!obj->Has(propValue)) {
-            virt::throwTypeError(isolate, "Property `value` not found");
-            return;
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Array> result = v8::Array::New(isolate, this->niface);
+
+        for (int i = 0; i < this->niface; i++) {
+            result->Set(i, v8::String::NewFromUtf8(isolate, this->names[i]));
         }
+
+        return result;
     }
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    char **names;
+    int niface;
+};
+
+static void __setDedicatedThread(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Boolean);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
     CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
 
-    virTypedParameterPtr params = static_cast<virTypedParameterPtr>(calloc(nparams, sizeof(virTypedParameter)));
-
-    for (int i = 0; i < nparams; i++) {
-        v8::Local<v8::Object> item = v8::Local<v8::Object>::Cast(arg1->Get(i));
-        virTypedParameterPtr param = params + i;
-
-        // field
-        v8::String::Utf8Value field(item->Get(propField)->ToString());
-        memcpy(param->field, *field, VIR_TYPED_PARAM_FIELD_LENGTH * sizeof(char));
-
-        // type
-        param->type = item->Get(propType)->Int32Value();
-
-        // value
-        switch (param->type) {
-        case VIR_TYPED_PARAM_INT:
-            param->value.i = item->Get(propValue)->Int32Value();
-            break;
-        case VIR_TYPED_PARAM_UINT:
-            param->value.ui = item->Get(propValue)->Uint32Value();
-            break;
-        case VIR_TYPED_PARAM_LLONG:
-            param->value.l = item->Get(propValue)->IntegerValue();
-            break;
-        case VIR_TYPED_PARAM_ULLONG:
-            param->value.ul = item->Get(propValue)->IntegerValue() & 0xffffffffffffffffL;
-            break;
-        case VIR_TYPED_PARAM_DOUBLE:
-            param->value.d = item->Get(propValue)->NumberValue();
-            break;
-        case VIR_TYPED_PARAM_BOOLEAN:
-            param->value.b = item->Get(propValue)->BooleanValue() ? 1 : 0;
-            break;
-        case VIR_TYPED_PARAM_STRING: {
-                v8::String::Utf8Value value(item->Get(propValue)->ToString());
-                param->value.s = strdup(*value);
-            }
-            break;
+    native->SetDedicatedThread(args[0]->BooleanValue());
+}
+
+static void __setCacheTTL(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    static const char *queries[] = {
+        "capabilities", "hostname", "libVersion", "maxVcpus", "nodeInfo", "securityModel", "sysinfo"
+    };
+    static const size_t nqueries = sizeof(queries) / sizeof(queries[0]);
+
+    if (args[0]->IsNumber()) {
+        double ttl = args[0]->NumberValue();
+        if (!(ttl >= 0)) {
+            virt::throwTypeError(isolate, "Invalid arguments");
+            return;
         }
-    }
 
-    if (0 != virNodeSetMemoryParameters(**native, params, nparams, 0)) {
-        virt::throwVirtError(isolate);
+        virt::Cache *cache = native->GetOrCreateCache();
+        for (size_t i = 0; i < nqueries; i++) {
+            cache->SetTTL(queries[i], static_cast<uint64_t>(ttl));
+        }
+        return;
     }
 
-    for (int i = 0; i < nparams; i++) {
-        virTypedParameterPtr param = params + i;
+    CHK_ARGUMENT_TYPE(isolate, args[0], Object);
+    v8::Local<v8::Object> ttls = v8::Local<v8::Object>::Cast(args[0]);
 
-        if (VIR_TYPED_PARAM_STRING == param->type && NULL != param->value.s) {
-            free(param->value.s);
+    for (size_t i = 0; i < nqueries; i++) {
+        v8::Local<v8::Value> ttl = ttls->Get(v8::String::NewFromUtf8(isolate, queries[i]));
+        if (ttl->IsUndefined()) {
+            continue;
+        }
+
+        if (!ttl->IsNumber() || !(ttl->NumberValue() >= 0)) {
+            virt::throwTypeError(isolate, "Invalid arguments");
+            return;
         }
-    }
 
-    free(params);
+        native->GetOrCreateCache()->SetTTL(queries[i], static_cast<uint64_t>(ttl->NumberValue()));
+    }
 }
 
-static void __virNodeSuspendForDuration(const v8::FunctionCallbackInfo<v8::Value>& args) {
+static void __getCacheStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 3);
-    CHK_ARGUMENT_TYPE(isolate, args[1], Uint32);
-    CHK_ARGUMENT_TYPE(isolate, args[2], Uint32);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
 
-    unsigned int target = args[1]->Uint32Value();
-    unsigned long long duration = args[2]->IntegerValue();
-    if (0 != virNodeSuspendForDuration(**native, target, duration, 0)) {
-        virt::throwVirtError(isolate);
+    if (NULL == native) {
+        virt::throwError(isolate, "Invalid arguments");
+        return;
     }
+
+    virt::Cache *cache = native->GetCache();
+    v8::Local<v8::Object> result = v8::Object::New(isolate);
+    result->Set(virt::typedparam::Key(isolate, "hits"), v8::Number::New(isolate, NULL == cache ? 0 : cache->GetHits()));
+    result->Set(virt::typedparam::Key(isolate, "misses"), v8::Number::New(isolate, NULL == cache ? 0 : cache->GetMisses()));
+    result->Set(virt::typedparam::Key(isolate, "size"), v8::Number::New(isolate, NULL == cache ? 0 : cache->GetSize()));
+    args.GetReturnValue().Set(result);
 }
 
-static void __virConnectListInterfaces(const v8::FunctionCallbackInfo<v8::Value>& args) {
+static void __clearCache(const v8::FunctionCallbackInfo<v8::Value>& args) {
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     v8::HandleScope scope(isolate);
 
-    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
-    v8::Local<v8::Object> holder = v8::Local<v8::Object>::Cast(args[0]);
+    v8::Local<v8::Object> holder = args.Holder();
     virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
-    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
 
-    int max = virConnectNumOfDefinedInterfaces(**native);
-    if (-1 == max) {
-        virt::throwVirtError(isolate);
+    if (NULL == native) {
+        virt::throwError(isolate, "Invalid arguments");
         return;
     }
 
-    char **names = static_cast<char**>(calloc(max, sizeof(void*)));
-    int niface = virConnectListInterfaces(**native, names, max);
-    if (-1 == niface) {
-        virt::throwVirtError(isolate);
-        return;
+    if (NULL != native->GetCache()) {
+        native->GetCache()->Clear();
     }
+}
 
-    v8::Local<v8::Array> result = v8::Array::New(isolate, niface);
-    for (int i = 0; i < niface; i++) {
-        result->Set(i, v8::String::NewFromUtf8(isolate, names[i]));
-    }
+static void __virConnectListInterfaces(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
 
-    args.GetReturnValue().Set(result);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::Worker::Run(args, new ListInterfacesWorker(**native), native->GetExecutor());
 }
 
 
@@ -821,48 +1264,126 @@ static void __virConnectListInterfaces(const v8::FunctionCallbackInfo<v8::Value>
 namespace virt {
     namespace host {
 
-        v8::Persistent<v8::Function> Connection::constructor;
+        // the dedicated executors of the connections of this isolate
+        static thread_local std::map<virConnectPtr, virt::Executor*> executors;
 
-        void exports(v8::Handle<v8::Object> exports) {
-            v8::Isolate *isolate = v8::Isolate::GetCurrent();
+        virt::Executor *GetExecutor(virConnectPtr conn) {
+            std::map<virConnectPtr, virt::Executor*>::iterator i = executors.find(conn);
+            return (i == executors.end()) ? NULL : i->second;
+        }
+
+        void Connection::SetDedicatedThread(bool enabled) {
+            if (enabled && NULL == this->executor) {
+                this->executor = virt::Executor::New();
+                executors[**this] = this->executor;
+            } else if (!enabled && NULL != this->executor) {
+                // the wrapper may already be null, look the executor up
+                for (std::map<virConnectPtr, virt::Executor*>::iterator i = executors.begin(); i != executors.end(); ++i) {
+                    if (i->second == this->executor) {
+                        executors.erase(i);
+                        break;
+                    }
+                }
+
+                this->executor->Stop();
+                this->executor = NULL;
+            }
+        }
+
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "baselineCPU",                   __virConnectBaselineCPU);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "close",                         __virConnectClose);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "compareCPU",                    __virConnectCompareCPU);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getCapabilities",               __virConnectGetCapabilities);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getHostname",                   __virConnectGetHostname);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getLibVersion",                 __virConnectGetLibVersion);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getMaxVcpus",                   __virConnectGetMaxVcpus);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getSysinfo",                    __virConnectGetSysinfo);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getType",                       __virConnectGetType);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getURI",                        __virConnectGetURI);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getVersion",                    __virConnectGetVersion);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "isAlive",                       __virConnectIsAlive);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "isEncrypted",                   __virConnectIsEncrypted);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "isSecure",                      __virConnectIsSecure);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "listInterfaces",                __virConnectListInterfaces);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "ref",                           __virConnectRef);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setKeepAlive",                  __virConnectSetKeepAlive);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeCPUMap",                 __virNodeGetCPUMap);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeCPUStats",               __virNodeGetCPUStats);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeCellsFreeMemory",        __virNodeGetCellsFreeMemory);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeFreeMemory",             __virNodeGetFreeMemory);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeInfo",                   __virNodeGetInfo);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeMemoryParameters",       __virNodeGetMemoryParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeMemoryStats",            __virNodeGetMemoryStats);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getNodeSecurityModel",          __virNodeGetSecurityModel);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setNodeMemoryParameters",       __virNodeSetMemoryParameters);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "suspendNodeForDuration",        __virNodeSuspendForDuration);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setDedicatedThread",            __setDedicatedThread);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "setCacheTTL",                   __setCacheTTL);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getCacheStats",                 __getCacheStats);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "clearCache",                    __clearCache);
+
+            virt::domain::prototype(tpl);
+            virt::inventory::prototype(tpl);
+            virt::mirror::prototype(tpl);
+            virt::storage::prototype(tpl);
+            virt::stream::prototype(tpl);
+        }
+
+        static virt::Worker *newHostnameQuery(virConnectPtr conn, const int *args) {
+            return new ConnectStringWorker(conn, virConnectGetHostname);
+        }
+
+        static virt::Worker *newLibVersionQuery(virConnectPtr conn, const int *args) {
+            return new ConnectVersionWorker(conn, virConnectGetLibVersion);
+        }
+
+        static virt::Worker *newNodeCPUStatsQuery(virConnectPtr conn, const int *args) {
+            return new GetCPUStatsWorker(conn, args[0]);
+        }
+
+        static virt::Worker *newNodeCellsFreeMemoryQuery(virConnectPtr conn, const int *args) {
+            return new GetCellsFreeMemoryWorker(conn, args[0], args[1]);
+        }
+
+        static virt::Worker *newNodeFreeMemoryQuery(virConnectPtr conn, const int *args) {
+            return new GetFreeMemoryWorker(conn);
+        }
 
-            if (0 != virInitialize()) {
-                virt::throwVirtError(isolate);
-                return;
+        static virt::Worker *newNodeInfoQuery(virConnectPtr conn, const int *args) {
+            return new GetInfoWorker(conn);
+        }
+
+        static virt::Worker *newNodeMemoryStatsQuery(virConnectPtr conn, const int *args) {
+            return new GetMemoryStatsWorker(conn, args[0]);
+        }
+
+        static const Query queries[] = {
+            { "getHostname",            0, { 0, 0 },                                  newHostnameQuery },
+            { "getLibVersion",          0, { 0, 0 },                                  newLibVersionQuery },
+            { "getNodeCPUStats",        1, { VIR_NODE_CPU_STATS_ALL_CPUS, 0 },        newNodeCPUStatsQuery },
+            { "getNodeCellsFreeMemory", 2, { 0, 64 },                                 newNodeCellsFreeMemoryQuery },
+            { "getNodeFreeMemory",      0, { 0, 0 },                                  newNodeFreeMemoryQuery },
+            { "getNodeInfo",            0, { 0, 0 },                                  newNodeInfoQuery },
+            { "getNodeMemoryStats",     1, { VIR_NODE_MEMORY_STATS_ALL_CELLS, 0 },    newNodeMemoryStatsQuery },
+        };
+
+        const Query *FindQuery(const char *name) {
+            for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+                if (0 == strcmp(name, queries[i].name)) {
+                    return queries + i;
+                }
             }
 
-            Connection::Export<Connection>(exports, "Connection");
-
-            NODE_SET_METHOD(exports, "virConnectBaselineCPU",               __virConnectBaselineCPU);
-            NODE_SET_METHOD(exports, "virConnectClose",                     __virConnectClose);
-            NODE_SET_METHOD(exports, "virConnectCompareCPU",                __virConnectCompareCPU);
-            NODE_SET_METHOD(exports, "virConnectGetCapabilities",           __virConnectGetCapabilities);
-            NODE_SET_METHOD(exports, "virConnectGetHostname",               __virConnectGetHostname);
-            NODE_SET_METHOD(exports, "virConnectGetLibVersion",             __virConnectGetLibVersion);
-            NODE_SET_METHOD(exports, "virConnectGetMaxVcpus",               __virConnectGetMaxVcpus);
-            NODE_SET_METHOD(exports, "virConnectGetSysinfo",                __virConnectGetSysinfo);
-            NODE_SET_METHOD(exports, "virConnectGetType",                   __virConnectGetType);
-            NODE_SET_METHOD(exports, "virConnectGetURI",                    __virConnectGetURI);
-            NODE_SET_METHOD(exports, "virConnectGetVersion",                __virConnectGetVersion);
-            NODE_SET_METHOD(exports, "virConnectIsAlive",                   __virConnectIsAlive);
-            NODE_SET_METHOD(exports, "virConnectIsEncrypted",               __virConnectIsEncrypted);
-            NODE_SET_METHOD(exports, "virConnectIsSecure",                  __virConnectIsSecure);
-            NODE_SET_METHOD(exports, "virConnectListInterfaces",            __virConnectListInterfaces);
-            NODE_SET_METHOD(exports, "virConnectOpen",                      __virConnectOpen);
-            NODE_SET_METHOD(exports, "virConnectOpenReadOnly",              __virConnectOpenReadOnly);
-            NODE_SET_METHOD(exports, "virConnectRef",                       __virConnectRef);
-            NODE_SET_METHOD(exports, "virConnectSetKeepAlive",              __virConnectSetKeepAlive);
-            NODE_SET_METHOD(exports, "virGetVersion",                       __virGetVersion);
-            NODE_SET_METHOD(exports, "virNodeGetCPUMap",                    __virNodeGetCPUMap);
-            NODE_SET_METHOD(exports, "virNodeGetCPUStats",                  __virNodeGetCPUStats);
-            NODE_SET_METHOD(exports, "virNodeGetCellsFreeMemory",           __virNodeGetCellsFreeMemory);
-            NODE_SET_METHOD(exports, "virNodeGetFreeMemory",                __virNodeGetFreeMemory);
-            NODE_SET_METHOD(exports, "virNodeGetInfo",                      __virNodeGetInfo);
-            NODE_SET_METHOD(exports, "virNodeGetMemoryParameters",          __virNodeGetMemoryParameters);
-            NODE_SET_METHOD(exports, "virNodeGetMemoryStats",               __virNodeGetMemoryStats);
-            NODE_SET_METHOD(exports, "virNodeGetSecurityModel",             __virNodeGetSecurityModel);
-            NODE_SET_METHOD(exports, "virNodeSetMemoryParameters",          __virNodeSetMemoryParameters);
-            NODE_SET_METHOD(exports, "virNodeSuspendForDuration",           __virNodeSuspendForDuration);
+            return NULL;
+        }
+
+        void exports(v8::Handle<v8::Object> exports) {
+            Connection::Export<Connection>(exports, "Connection", methods);
+
+            VIRT_SET_METHOD(exports, "virConnectOpen",                      __virConnectOpen);
+            VIRT_SET_METHOD(exports, "virConnectOpenReadOnly",              __virConnectOpenReadOnly);
+            VIRT_SET_METHOD(exports, "virGetVersion",                       __virGetVersion);
         }
 
     } // namespace host
@@ -5,19 +5,128 @@
 #include <libvirt/libvirt.h>
 
 #include "pointer.h"
+#include "virt-cache.h"
+#include "virt-executor.h"
+#include "virt-inventory.h"
+#include "virt-mirror.h"
+
+/**
+ * Closing the last reference of a connection talks to the daemon, and the
+ * connection leaves the pool first, see virt-host.cc
+ */
+template <>
+struct PointerTraits<virConnectPtr> {
+    static inline int Ref(virConnectPtr ptr) { return virConnectRef(ptr); }
+    static inline int Unref(virConnectPtr ptr) { return virConnectClose(ptr); }
+    static int Release(virConnectPtr ptr);
+    static const bool kBlocking = true;
+    static const int64_t kExternalSize = 64 * 1024;
+};
 
 template class Pointer<virConnectPtr>;
 
 namespace virt {
+
+    class Worker;
+
     namespace host {
 
         void exports(v8::Handle<v8::Object> exports);
 
+        /**
+         * A host query which can be run against many connections, see
+         * virt::gather
+         */
+        struct Query {
+            // name of the Connection method which performs the same call
+            const char *name;
+            // number of integer arguments and their default values
+            int nargs;
+            int defaults[2];
+            virt::Worker *(*create)(virConnectPtr conn, const int *args);
+        };
+
+        /**
+         * Returns the query of the method name, or NULL if the method can
+         * not be gathered
+         */
+        const Query *FindQuery(const char *name);
+
+        /**
+         * Returns the dedicated executor of a connection of the calling
+         * isolate, or NULL if its calls go to the shared thread pool, so
+         * that the calls on the domains of the connection run on the same
+         * thread as the calls on the connection
+         */
+        virt::Executor *GetExecutor(virConnectPtr conn);
+
         class Connection : public Pointer<virConnectPtr> {
+        public:
+            /**
+             * Returns the dedicated executor, or NULL if the calls of this
+             * connection go to the shared thread pool
+             */
+            inline virt::Executor *GetExecutor() const { return this->executor; }
+
+            void SetDedicatedThread(bool enabled);
+
+            /**
+             * Returns the result cache, or NULL if caching has never been
+             * enabled on this connection
+             */
+            inline virt::Cache *GetCache() const { return this->cache; }
+
+            /**
+             * Returns the result cache, creates it on first use
+             */
+            inline virt::Cache *GetOrCreateCache() {
+                if (NULL == this->cache) {
+                    this->cache = new virt::Cache();
+                }
+
+                return this->cache;
+            }
+
+            /**
+             * Returns the mirror of the domain states, or NULL if they are
+             * not mirrored
+             */
+            inline virt::mirror::Mirror *GetMirror() const { return this->mirror; }
+
+            inline void SetMirror(virt::mirror::Mirror *mirror) { this->mirror = mirror; }
+
+            /**
+             * Returns the inventory tracker, or NULL if no inventory has
+             * been diffed yet
+             */
+            inline virt::inventory::Tracker *GetInventory() const { return this->inventory; }
+
+            inline void SetInventory(virt::inventory::Tracker *inventory) { this->inventory = inventory; }
+
+            virtual ~Connection() {
+                this->SetDedicatedThread(false);
+                delete this->cache;
+
+                // the registered events keep the connection open
+                if (NULL != this->mirror) {
+                    this->mirror->Stop();
+                }
+
+                if (NULL != this->inventory) {
+                    this->inventory->Stop();
+                }
+            }
+
         private:
-            static v8::Persistent<v8::Function> constructor;
+            inline Connection(virConnectPtr ptr) : Pointer(ptr), executor(NULL), cache(NULL), mirror(NULL), inventory(NULL) {}
+
+            virt::Executor *executor;
+
+            virt::Cache *cache;
+
+            virt::mirror::Mirror *mirror;
 
-            inline Connection(virConnectPtr ptr) : Pointer(ptr) {}
+            virt::inventory::Tracker *inventory;
 
             friend class Pointer<virConnectPtr>;
         };
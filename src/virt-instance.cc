@@ -0,0 +1,113 @@
+/**
+ * Per isolate state for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+#include "virt-instance.h"
+
+namespace virt {
+
+    thread_local Instance *Instance::current = NULL;
+
+    Instance::Instance(v8::Isolate *isolate)
+        : isolate(isolate), loop(node::GetCurrentEventLoop(isolate)), disposed(false), refs(0) {
+        uv_mutex_init(&this->lock);
+        uv_async_init(this->loop, &this->async, OnAsync);
+        uv_unref(reinterpret_cast<uv_handle_t*>(&this->async));
+        this->async.data = this;
+    }
+
+    Instance *Instance::New(v8::Isolate *isolate) {
+        if (NULL == current) {
+            current = new Instance(isolate);
+            node::AddEnvironmentCleanupHook(isolate, Dispose, current);
+        }
+
+        return current;
+    }
+
+    bool Instance::Post(Task task, void *data) {
+        uv_mutex_lock(&this->lock);
+
+        if (this->disposed) {
+            uv_mutex_unlock(&this->lock);
+            return false;
+        }
+
+        this->tasks.push_back(std::make_pair(task, data));
+
+        // sent under the lock so the handle can not be closed meanwhile
+        uv_async_send(&this->async);
+        uv_mutex_unlock(&this->lock);
+
+        return true;
+    }
+
+    void Instance::Ref() {
+        if (0 == this->refs++) {
+            uv_ref(reinterpret_cast<uv_handle_t*>(&this->async));
+        }
+    }
+
+    void Instance::Unref() {
+        if (0 == --this->refs) {
+            uv_unref(reinterpret_cast<uv_handle_t*>(&this->async));
+        }
+    }
+
+    void Instance::OnAsync(uv_async_t *handle) {
+        Instance *self = static_cast<Instance*>(handle->data);
+        std::vector<std::pair<Task, void*> > tasks;
+
+        uv_mutex_lock(&self->lock);
+        tasks.swap(self->tasks);
+        uv_mutex_unlock(&self->lock);
+
+        for (size_t i = 0; i < tasks.size(); i++) {
+            tasks[i].first(tasks[i].second);
+        }
+    }
+
+    /**
+     * Runs when the environment of the isolate is torn down. The instance
+     * itself is kept, other threads may still post to it.
+     */
+    void Instance::Dispose(void *arg) {
+        Instance *self = static_cast<Instance*>(arg);
+
+        uv_mutex_lock(&self->lock);
+        self->disposed = true;
+        self->tasks.clear();
+        uv_close(reinterpret_cast<uv_handle_t*>(&self->async), NULL);
+        uv_mutex_unlock(&self->lock);
+
+        for (std::map<const void*, v8::Persistent<v8::Function>*>::iterator i = self->constructors.begin(); i != self->constructors.end(); ++i) {
+            i->second->Reset();
+            delete i->second;
+        }
+
+        for (std::map<const void*, v8::Persistent<v8::FunctionTemplate>*>::iterator i = self->templates.begin(); i != self->templates.end(); ++i) {
+            i->second->Reset();
+            delete i->second;
+        }
+
+        for (std::map<std::string, v8::Persistent<v8::String>*>::iterator i = self->keys.begin(); i != self->keys.end(); ++i) {
+            i->second->Reset();
+            delete i->second;
+        }
+
+        self->constructors.clear();
+        self->templates.clear();
+        self->keys.clear();
+        self->keyType.Reset();
+        self->keyField.Reset();
+        self->keyValue.Reset();
+        self->paramTemplate.Reset();
+
+        if (current == self) {
+            current = NULL;
+        }
+    }
+
+} // namespace virt
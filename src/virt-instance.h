@@ -0,0 +1,141 @@
+#ifndef __NODE_VIRT_INSTANCE_H__
+#define __NODE_VIRT_INSTANCE_H__
+
+// standard c++
+#include <map>
+#include <string>
+#include <vector>
+
+// node
+#include <node.h>
+#include <uv.h>
+
+namespace virt {
+
+    /**
+     * The state of the addon which belongs to one isolate, i.e. to the main
+     * thread or to one of the worker threads loading the addon.
+     *
+     * Every isolate runs on its own thread, so the instance of the calling
+     * thread is the instance of the current isolate.
+     */
+    class Instance {
+    public:
+
+        typedef void (*Task)(void *data);
+
+        /**
+         * Returns the instance of the calling thread, NULL if the addon has
+         * not been loaded on this thread or the isolate is being disposed
+         */
+        static inline Instance *Current() { return current; }
+
+        /**
+         * Returns the instance of the isolate, creating it on the first load
+         */
+        static Instance *New(v8::Isolate *isolate);
+
+        /**
+         * Runs the task on the loop thread of the instance, may be called
+         * from any thread. Returns false if the isolate has been disposed,
+         * the task is not run then and its data is left to the caller.
+         */
+        bool Post(Task task, void *data);
+
+        /**
+         * Keeps the loop alive until the matching {@link Unref()}, e.g.
+         * while a call completed by a posted task is in flight
+         */
+        void Ref();
+
+        void Unref();
+
+        template <class S>
+        inline void SetConstructor(v8::Isolate *isolate, v8::Local<v8::Function> ctor) {
+            v8::Persistent<v8::Function> *&slot = this->constructors[Key<S>()];
+
+            if (NULL == slot) {
+                slot = new v8::Persistent<v8::Function>();
+            }
+
+            slot->Reset(isolate, ctor);
+        }
+
+        template <class S>
+        inline v8::Local<v8::Function> GetConstructor(v8::Isolate *isolate) {
+            return v8::Local<v8::Function>::New(isolate, *this->constructors[Key<S>()]);
+        }
+
+        template <class S>
+        inline void SetTemplate(v8::Isolate *isolate, v8::Local<v8::FunctionTemplate> tpl) {
+            v8::Persistent<v8::FunctionTemplate> *&slot = this->templates[Key<S>()];
+
+            if (NULL == slot) {
+                slot = new v8::Persistent<v8::FunctionTemplate>();
+            }
+
+            slot->Reset(isolate, tpl);
+        }
+
+        /**
+         * Whether the value is a wrapper of the class, rather than of any
+         * other class or no wrapper at all
+         */
+        template <class S>
+        inline bool HasInstance(v8::Isolate *isolate, v8::Local<v8::Value> value) {
+            std::map<const void*, v8::Persistent<v8::FunctionTemplate>*>::iterator i = this->templates.find(Key<S>());
+            return i != this->templates.end() && v8::Local<v8::FunctionTemplate>::New(isolate, *i->second)->HasInstance(value);
+        }
+
+        v8::Isolate *isolate;
+
+        uv_loop_t *loop;
+
+        // templates and keys of virt-typed-parameter.cc
+        v8::Persistent<v8::String> keyType;
+
+        v8::Persistent<v8::String> keyField;
+
+        v8::Persistent<v8::String> keyValue;
+
+        v8::Persistent<v8::ObjectTemplate> paramTemplate;
+
+        std::map<std::string, v8::Persistent<v8::String>*> keys;
+
+    private:
+
+        Instance(v8::Isolate *isolate);
+
+        /**
+         * The address of the variable identifies the class
+         */
+        template <class S>
+        static inline const void *Key() {
+            static const char key = 0;
+            return &key;
+        }
+
+        static void Dispose(void *arg);
+
+        static void OnAsync(uv_async_t *handle);
+
+        static thread_local Instance *current;
+
+        uv_mutex_t lock;
+
+        uv_async_t async;
+
+        std::vector<std::pair<Task, void*> > tasks;
+
+        bool disposed;
+
+        unsigned int refs;
+
+        std::map<const void*, v8::Persistent<v8::Function>*> constructors;
+
+        std::map<const void*, v8::Persistent<v8::FunctionTemplate>*> templates;
+    };
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_INSTANCE_H__ */
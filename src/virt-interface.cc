@@ -9,12 +9,53 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "virt-external-string.h"
+#include "virt-host.h"
 #include "virt-interface.h"
+#include "virt-worker.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+class GetXMLDescWorker : public virt::Worker {
+public:
+    inline GetXMLDescWorker(virInterfacePtr iface, unsigned int flags) : iface(iface), flags(flags), xml(NULL) {}
+
+    virtual ~GetXMLDescWorker() {
+        free(this->xml);
+    }
+
+    virtual void Execute() {
+        if (NULL == (this->xml = virInterfaceGetXMLDesc(this->iface, this->flags))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        char *xml = this->xml;
+        this->xml = NULL;
+        return virt::ExternalString::New(isolate, xml);
+    }
+
+private:
+    virt::Reference<virInterfacePtr> iface;
+    unsigned int flags;
+    char *xml;
+};
+
+static void __virInterfaceGetXMLDesc(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::interface::Interface *native = node::ObjectWrap::Unwrap<virt::interface::Interface>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new GetXMLDescWorker(**native, flags), virt::host::GetExecutor(virInterfaceGetConnect(**native)));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,10 +63,13 @@ extern "C" {
 namespace virt {
     namespace interface {
 
-        v8::Persistent<v8::Function> Interface::constructor;
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          Interface::Free<Interface>);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getXMLDesc",                    __virInterfaceGetXMLDesc);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            Interface::Export<Interface>(exports, "Interface");
+            Interface::Export<Interface>(exports, "Interface", methods);
         }
 
     } // namespace interface
@@ -15,8 +15,6 @@ namespace virt {
 
         class Interface : public Pointer<virInterfacePtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline Interface(virInterfacePtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virInterfacePtr>;
@@ -0,0 +1,637 @@
+/**
+ * Incremental inventory of the objects of a connection for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+#include "virt-error.h"
+#include "virt-hash.h"
+#include "virt-host.h"
+#include "virt-inventory.h"
+#include "virt-worker.h"
+
+// past this many dirty objects of a kind, listing all of them is cheaper
+#define MAX_DIRTY 1024
+
+static const char *kindNames[] = { "domain", "interface", "network", "storagePool" };
+
+#define UUID_KEY(type, uuid)                                                          \
+    static inline std::string getKey(type obj) {                                      \
+        char buf[VIR_UUID_STRING_BUFLEN];                                             \
+        return 0 == uuid(obj, buf) ? buf : "";                                        \
+    }
+
+UUID_KEY(virDomainPtr,      virDomainGetUUIDString)
+UUID_KEY(virNetworkPtr,     virNetworkGetUUIDString)
+UUID_KEY(virStoragePoolPtr, virStoragePoolGetUUIDString)
+
+#undef UUID_KEY
+
+/**
+ * Interfaces have no UUID, they are keyed by name
+ */
+static inline std::string getKey(virInterfacePtr iface) {
+    const char *name = virInterfaceGetName(iface);
+    return NULL == name ? "" : name;
+}
+
+/**
+ * How the objects of a kind are listed, looked up and described
+ */
+template <typename T>
+struct InventoryTraits;
+
+#define INVENTORY_TRAITS(type, kind, list, lookup, name, xml, release, notFound)     \
+    template <>                                                                       \
+    struct InventoryTraits<type> {                                                    \
+        static const virt::inventory::Kind kKind = (kind);                            \
+        static const int kNotFound = (notFound);                                      \
+        static inline int List(virConnectPtr conn, type **items) {                    \
+            return list(conn, items, 0);                                              \
+        }                                                                             \
+        static inline type Lookup(virConnectPtr conn, const char *key) {              \
+            return lookup(conn, key);                                                 \
+        }                                                                             \
+        static inline std::string Key(type obj) { return getKey(obj); }               \
+        static inline const char *Name(type obj) { return name(obj); }               \
+        static inline char *XML(type obj) { return xml(obj, 0); }                     \
+        static inline int Release(type obj) { return release(obj); }                  \
+    };
+
+INVENTORY_TRAITS(virDomainPtr,      virt::inventory::DOMAIN,       virConnectListAllDomains,      virDomainLookupByUUIDString,
+                 virDomainGetName,      virDomainGetXMLDesc,      virDomainFree,      VIR_ERR_NO_DOMAIN)
+INVENTORY_TRAITS(virInterfacePtr,   virt::inventory::INTERFACE,    virConnectListAllInterfaces,   virInterfaceLookupByName,
+                 virInterfaceGetName,   virInterfaceGetXMLDesc,   virInterfaceFree,   VIR_ERR_NO_INTERFACE)
+INVENTORY_TRAITS(virNetworkPtr,     virt::inventory::NETWORK,      virConnectListAllNetworks,     virNetworkLookupByUUIDString,
+                 virNetworkGetName,     virNetworkGetXMLDesc,     virNetworkFree,     VIR_ERR_NO_NETWORK)
+INVENTORY_TRAITS(virStoragePoolPtr, virt::inventory::STORAGE_POOL, virConnectListAllStoragePools, virStoragePoolLookupByUUIDString,
+                 virStoragePoolGetName, virStoragePoolGetXMLDesc, virStoragePoolFree, VIR_ERR_NO_STORAGE_POOL)
+
+#undef INVENTORY_TRAITS
+
+namespace virt {
+    namespace inventory {
+
+        Tracker::Tracker(virConnectPtr conn) : conn(conn), refs(1), busy(false), registered(false), stopped(false) {
+            uv_mutex_init(&this->lock);
+
+            for (int i = 0; i < KINDS; i++) {
+                this->states[i].scanned = false;
+                this->states[i].watched = false;
+                this->states[i].overflow = false;
+            }
+        }
+
+        Tracker::~Tracker() {
+            uv_mutex_destroy(&this->lock);
+        }
+
+        void Tracker::Ref() {
+            uv_mutex_lock(&this->lock);
+            this->refs++;
+            uv_mutex_unlock(&this->lock);
+        }
+
+        void Tracker::Unref() {
+            uv_mutex_lock(&this->lock);
+            bool last = 0 == --this->refs;
+            uv_mutex_unlock(&this->lock);
+
+            if (last) {
+                delete this;
+            }
+        }
+
+        bool Tracker::Acquire() {
+            uv_mutex_lock(&this->lock);
+            bool acquired = !this->busy;
+            this->busy = true;
+            uv_mutex_unlock(&this->lock);
+            return acquired;
+        }
+
+        void Tracker::Stop() {
+            std::vector<std::pair<Kind, int> > callbacks;
+
+            uv_mutex_lock(&this->lock);
+            this->stopped = true;
+            callbacks.swap(this->callbacks);
+            uv_mutex_unlock(&this->lock);
+
+            for (size_t i = 0; i < callbacks.size(); i++) {
+                switch (callbacks[i].first) {
+                case DOMAIN:
+                    virConnectDomainEventDeregisterAny(this->conn, callbacks[i].second);
+                    break;
+                case NETWORK:
+                    virConnectNetworkEventDeregisterAny(this->conn, callbacks[i].second);
+                    break;
+                case STORAGE_POOL:
+                    virConnectStoragePoolEventDeregisterAny(this->conn, callbacks[i].second);
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            this->Unref();
+        }
+
+        void Tracker::Diff(unsigned int kinds, bool full, std::vector<Record> *changes, Scan *scans) {
+            if (!this->registered) {
+                this->registered = true;
+                this->Register();
+            }
+
+            if (0 != (kinds & (1 << DOMAIN))) {
+                this->Rescan<virDomainPtr>(full, changes, scans + DOMAIN);
+            }
+
+            if (0 != (kinds & (1 << INTERFACE))) {
+                this->Rescan<virInterfacePtr>(full, changes, scans + INTERFACE);
+            }
+
+            if (0 != (kinds & (1 << NETWORK))) {
+                this->Rescan<virNetworkPtr>(full, changes, scans + NETWORK);
+            }
+
+            if (0 != (kinds & (1 << STORAGE_POOL))) {
+                this->Rescan<virStoragePoolPtr>(full, changes, scans + STORAGE_POOL);
+            }
+
+            uv_mutex_lock(&this->lock);
+            this->busy = false;
+            uv_mutex_unlock(&this->lock);
+        }
+
+        int Tracker::RegisterDomainEvent(int eventID, virConnectDomainEventGenericCallback cb) {
+            this->Ref();
+
+            int id = virConnectDomainEventRegisterAny(this->conn, NULL, eventID, cb, this, OnReleased);
+            if (-1 == id) {
+                this->Unref();
+            }
+
+            return id;
+        }
+
+        void Tracker::Register() {
+            std::vector<std::pair<Kind, int> > callbacks;
+            bool watched[KINDS] = { true, false, true, true };
+            int id;
+
+            // the events which change the description of a domain, others
+            // are only seen by full rescans
+            struct {
+                int eventID;
+                virConnectDomainEventGenericCallback cb;
+            } domainEvents[] = {
+                { VIR_DOMAIN_EVENT_ID_LIFECYCLE,       VIR_DOMAIN_EVENT_CALLBACK(OnLifecycleEvent<virDomainPtr>) },
+                { VIR_DOMAIN_EVENT_ID_DEVICE_ADDED,    VIR_DOMAIN_EVENT_CALLBACK(OnDeviceEvent) },
+                { VIR_DOMAIN_EVENT_ID_DEVICE_REMOVED,  VIR_DOMAIN_EVENT_CALLBACK(OnDeviceEvent) },
+                { VIR_DOMAIN_EVENT_ID_TUNABLE,         VIR_DOMAIN_EVENT_CALLBACK(OnTunableEvent) },
+                { VIR_DOMAIN_EVENT_ID_METADATA_CHANGE, VIR_DOMAIN_EVENT_CALLBACK(OnMetadataEvent) },
+                { VIR_DOMAIN_EVENT_ID_BALLOON_CHANGE,  VIR_DOMAIN_EVENT_CALLBACK(OnBalloonEvent) },
+                { VIR_DOMAIN_EVENT_ID_TRAY_CHANGE,     VIR_DOMAIN_EVENT_CALLBACK(OnTrayEvent) }
+            };
+
+            for (size_t i = 0; i < sizeof(domainEvents) / sizeof(domainEvents[0]); i++) {
+                if (-1 == (id = this->RegisterDomainEvent(domainEvents[i].eventID, domainEvents[i].cb))) {
+                    watched[DOMAIN] = false;
+                } else {
+                    callbacks.push_back(std::make_pair(DOMAIN, id));
+                }
+            }
+
+            this->Ref();
+            id = virConnectNetworkEventRegisterAny(this->conn, NULL, VIR_NETWORK_EVENT_ID_LIFECYCLE,
+                    VIR_NETWORK_EVENT_CALLBACK(OnLifecycleEvent<virNetworkPtr>), this, OnReleased);
+            if (-1 == id) {
+                watched[NETWORK] = false;
+                this->Unref();
+            } else {
+                callbacks.push_back(std::make_pair(NETWORK, id));
+            }
+
+            this->Ref();
+            id = virConnectStoragePoolEventRegisterAny(this->conn, NULL, VIR_STORAGE_POOL_EVENT_ID_LIFECYCLE,
+                    VIR_STORAGE_POOL_EVENT_CALLBACK(OnLifecycleEvent<virStoragePoolPtr>), this, OnReleased);
+            if (-1 == id) {
+                watched[STORAGE_POOL] = false;
+                this->Unref();
+            } else {
+                callbacks.push_back(std::make_pair(STORAGE_POOL, id));
+            }
+
+            // a refresh updates the allocation in the description
+            this->Ref();
+            id = virConnectStoragePoolEventRegisterAny(this->conn, NULL, VIR_STORAGE_POOL_EVENT_ID_REFRESH,
+                    VIR_STORAGE_POOL_EVENT_CALLBACK(OnObjectEvent<virStoragePoolPtr>), this, OnReleased);
+            if (-1 == id) {
+                watched[STORAGE_POOL] = false;
+                this->Unref();
+            } else {
+                callbacks.push_back(std::make_pair(STORAGE_POOL, id));
+            }
+
+            // older daemons lack some of the events, those kinds are listed
+            // on every diff
+            virResetLastError();
+
+            uv_mutex_lock(&this->lock);
+            bool stopped = this->stopped;
+
+            if (!stopped) {
+                this->callbacks.swap(callbacks);
+
+                for (int i = 0; i < KINDS; i++) {
+                    this->states[i].watched = watched[i];
+                }
+            }
+
+            uv_mutex_unlock(&this->lock);
+
+            // stopped while registering
+            for (size_t i = 0; stopped && i < callbacks.size(); i++) {
+                switch (callbacks[i].first) {
+                case DOMAIN:
+                    virConnectDomainEventDeregisterAny(this->conn, callbacks[i].second);
+                    break;
+                case NETWORK:
+                    virConnectNetworkEventDeregisterAny(this->conn, callbacks[i].second);
+                    break;
+                default:
+                    virConnectStoragePoolEventDeregisterAny(this->conn, callbacks[i].second);
+                    break;
+                }
+            }
+        }
+
+        void Tracker::Mark(Kind kind, const std::string& key) {
+            State& state = this->states[kind];
+
+            uv_mutex_lock(&this->lock);
+
+            if (key.empty() || state.dirty.size() >= MAX_DIRTY) {
+                state.overflow = true;
+                state.dirty.clear();
+            } else if (!state.overflow) {
+                state.dirty.insert(key);
+            }
+
+            uv_mutex_unlock(&this->lock);
+        }
+
+        template <typename T>
+        void Tracker::Rescan(bool full, std::vector<Record> *changes, Scan *scan) {
+            typedef InventoryTraits<T> Traits;
+
+            State& state = this->states[Traits::kKind];
+            std::set<std::string> dirty;
+            bool overflow;
+
+            uv_mutex_lock(&this->lock);
+            dirty.swap(state.dirty);
+            overflow = state.overflow;
+            state.overflow = false;
+            bool rescan = full || overflow || !state.scanned || !state.watched;
+            uv_mutex_unlock(&this->lock);
+
+            if (!rescan && dirty.empty()) {
+                scan->mode = "skipped";
+                return;
+            }
+
+            // the changes are only committed if the scan succeeds
+            std::map<std::string, Item> updates;
+            std::set<std::string> removals;
+
+            if (rescan) {
+                T *items = NULL;
+                int n = Traits::List(this->conn, &items);
+
+                if (n < 0) {
+                    const char *msg = virGetLastErrorMessage();
+                    scan->error = NULL == msg ? "Unknown error" : msg;
+
+                    // the events seen meanwhile are covered by the next one
+                    this->Mark(Traits::kKind, "");
+                    return;
+                }
+
+                for (int i = 0; i < n; i++) {
+                    std::string key = Traits::Key(items[i]);
+                    const char *name = Traits::Name(items[i]);
+                    char *xml = key.empty() ? NULL : Traits::XML(items[i]);
+
+                    // gone since it has been listed
+                    if (NULL != xml) {
+                        Item& item = updates[key];
+                        item.name = NULL == name ? "" : name;
+                        item.hash = virt::hash::Fnv1a(xml);
+                        free(xml);
+                    }
+
+                    Traits::Release(items[i]);
+                }
+
+                free(items);
+                virResetLastError();
+
+                for (std::map<std::string, Item>::iterator i = state.items.begin(); i != state.items.end(); ++i) {
+                    if (updates.find(i->first) == updates.end()) {
+                        removals.insert(i->first);
+                    }
+                }
+
+                scan->mode = "full";
+            } else {
+                for (std::set<std::string>::iterator i = dirty.begin(); i != dirty.end(); ++i) {
+                    T obj = Traits::Lookup(this->conn, i->c_str());
+
+                    if (NULL == obj) {
+                        virErrorPtr error = virGetLastError();
+
+                        if (NULL != error && Traits::kNotFound == error->code) {
+                            removals.insert(*i);
+                            virResetLastError();
+                            continue;
+                        }
+
+                        const char *msg = virGetLastErrorMessage();
+                        scan->error = NULL == msg ? "Unknown error" : msg;
+                        this->Mark(Traits::kKind, "");
+                        return;
+                    }
+
+                    const char *name = Traits::Name(obj);
+                    char *xml = Traits::XML(obj);
+
+                    if (NULL != xml) {
+                        Item& item = updates[*i];
+                        item.name = NULL == name ? "" : name;
+                        item.hash = virt::hash::Fnv1a(xml);
+                        free(xml);
+                    } else {
+                        removals.insert(*i);
+                        virResetLastError();
+                    }
+
+                    Traits::Release(obj);
+                }
+
+                scan->mode = "partial";
+            }
+
+            for (std::set<std::string>::iterator i = removals.begin(); i != removals.end(); ++i) {
+                std::map<std::string, Item>::iterator it = state.items.find(*i);
+
+                if (it != state.items.end()) {
+                    Record record = { Traits::kKind, it->first, it->second.name, "removed", 0 };
+                    changes->push_back(record);
+                    state.items.erase(it);
+                }
+            }
+
+            for (std::map<std::string, Item>::iterator i = updates.begin(); i != updates.end(); ++i) {
+                std::map<std::string, Item>::iterator it = state.items.find(i->first);
+                const char *change = NULL;
+
+                if (it == state.items.end()) {
+                    change = "added";
+                } else if (it->second.hash != i->second.hash || it->second.name != i->second.name) {
+                    change = "changed";
+                }
+
+                if (NULL != change) {
+                    Record record = { Traits::kKind, i->first, i->second.name, change, i->second.hash };
+                    changes->push_back(record);
+                    state.items[i->first] = i->second;
+                }
+            }
+
+            state.scanned = true;
+        }
+
+        template <typename T>
+        void Tracker::OnObjectEvent(virConnectPtr conn, T obj, void *opaque) {
+            static_cast<Tracker*>(opaque)->Mark(InventoryTraits<T>::kKind, InventoryTraits<T>::Key(obj));
+        }
+
+        template <typename T>
+        void Tracker::OnLifecycleEvent(virConnectPtr conn, T obj, int event, int detail, void *opaque) {
+            OnObjectEvent(conn, obj, opaque);
+        }
+
+        void Tracker::OnDeviceEvent(virConnectPtr conn, virDomainPtr dom, const char *alias, void *opaque) {
+            OnObjectEvent(conn, dom, opaque);
+        }
+
+        void Tracker::OnTunableEvent(virConnectPtr conn, virDomainPtr dom, virTypedParameterPtr params, int nparams, void *opaque) {
+            OnObjectEvent(conn, dom, opaque);
+        }
+
+        void Tracker::OnMetadataEvent(virConnectPtr conn, virDomainPtr dom, int type, const char *nsuri, void *opaque) {
+            OnObjectEvent(conn, dom, opaque);
+        }
+
+        void Tracker::OnBalloonEvent(virConnectPtr conn, virDomainPtr dom, unsigned long long actual, void *opaque) {
+            OnObjectEvent(conn, dom, opaque);
+        }
+
+        void Tracker::OnTrayEvent(virConnectPtr conn, virDomainPtr dom, const char *alias, int reason, void *opaque) {
+            OnObjectEvent(conn, dom, opaque);
+        }
+
+        void Tracker::OnReleased(void *opaque) {
+            static_cast<Tracker*>(opaque)->Unref();
+        }
+
+    } // namespace inventory
+} // namespace virt
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+class DiffInventoryWorker : public virt::Worker {
+public:
+    inline DiffInventoryWorker(virConnectPtr conn, virt::inventory::Tracker *tracker, unsigned int kinds, bool full)
+        : conn(conn), tracker(tracker), kinds(kinds), full(full) {
+        this->tracker->Ref();
+    }
+
+    virtual ~DiffInventoryWorker() {
+        this->tracker->Unref();
+    }
+
+    virtual void Execute() {
+        this->tracker->Diff(this->kinds, this->full, &this->changes, this->scans);
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        v8::Local<v8::Array> changes = v8::Array::New(isolate, this->changes.size());
+        v8::Local<v8::Object> scans = v8::Object::New(isolate);
+        v8::Local<v8::Object> errors = v8::Object::New(isolate);
+        v8::Local<v8::String> kType = v8::String::NewFromUtf8(isolate, "type");
+        v8::Local<v8::String> kKey = v8::String::NewFromUtf8(isolate, "key");
+        v8::Local<v8::String> kName = v8::String::NewFromUtf8(isolate, "name");
+        v8::Local<v8::String> kChange = v8::String::NewFromUtf8(isolate, "change");
+        v8::Local<v8::String> kHash = v8::String::NewFromUtf8(isolate, "hash");
+        bool failed = false;
+
+        for (size_t i = 0; i < this->changes.size(); i++) {
+            const virt::inventory::Record& record = this->changes[i];
+            v8::Local<v8::Object> obj = v8::Object::New(isolate);
+            char hash[17];
+
+            snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(record.hash));
+            obj->Set(kType, v8::String::NewFromUtf8(isolate, kindNames[record.kind]));
+            obj->Set(kKey, v8::String::NewFromUtf8(isolate, record.key.c_str()));
+            obj->Set(kName, v8::String::NewFromUtf8(isolate, record.name.c_str()));
+            obj->Set(kChange, v8::String::NewFromUtf8(isolate, record.change));
+
+            if (0 != record.hash) {
+                obj->Set(kHash, v8::String::NewFromUtf8(isolate, hash));
+            }
+
+            changes->Set(i, obj);
+        }
+
+        for (int i = 0; i < virt::inventory::KINDS; i++) {
+            if (0 == (this->kinds & (1 << i))) {
+                continue;
+            }
+
+            v8::Local<v8::String> kind = v8::String::NewFromUtf8(isolate, kindNames[i]);
+
+            if (!this->scans[i].error.empty()) {
+                errors->Set(kind, v8::String::NewFromUtf8(isolate, this->scans[i].error.c_str()));
+                failed = true;
+            } else {
+                scans->Set(kind, v8::String::NewFromUtf8(isolate, this->scans[i].mode));
+            }
+        }
+
+        result->Set(v8::String::NewFromUtf8(isolate, "changes"), changes);
+        result->Set(v8::String::NewFromUtf8(isolate, "scans"), scans);
+
+        if (failed) {
+            result->Set(v8::String::NewFromUtf8(isolate, "errors"), errors);
+        }
+
+        return result;
+    }
+
+private:
+    // the tracker calls the connection without a reference of its own
+    virt::Reference<virConnectPtr> conn;
+    virt::inventory::Tracker *tracker;
+    unsigned int kinds;
+    bool full;
+    std::vector<virt::inventory::Record> changes;
+    virt::inventory::Scan scans[virt::inventory::KINDS];
+};
+
+class ResetInventoryWorker : public virt::Worker {
+public:
+    inline ResetInventoryWorker(virConnectPtr conn, virt::inventory::Tracker *tracker) : conn(conn), tracker(tracker) {}
+
+    virtual void Execute() {
+        if (NULL != this->tracker) {
+            this->tracker->Stop();
+        }
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    virt::inventory::Tracker *tracker;
+};
+
+static void __diffInventory(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    // all kinds unless given
+    unsigned int mask = (1 << virt::inventory::KINDS) - 1;
+    bool full = false;
+
+    if (args.Length() > 0 && args[0]->IsObject() && !args[0]->IsFunction()) {
+        v8::Local<v8::Object> options = v8::Local<v8::Object>::Cast(args[0]);
+        v8::Local<v8::Value> types = options->Get(v8::String::NewFromUtf8(isolate, "types"));
+
+        full = options->Get(v8::String::NewFromUtf8(isolate, "full"))->BooleanValue();
+
+        if (types->IsArray()) {
+            v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(types);
+            mask = 0;
+
+            for (uint32_t i = 0; i < array->Length(); i++) {
+                v8::String::Utf8Value type(array->Get(i)->ToString());
+                int kind = 0;
+
+                while (kind < virt::inventory::KINDS && 0 != strcmp(*type, kindNames[kind])) {
+                    kind++;
+                }
+
+                if (virt::inventory::KINDS == kind) {
+                    virt::throwTypeError(isolate, "Unknown inventory type");
+                    return;
+                }
+
+                mask |= 1 << kind;
+            }
+        }
+    }
+
+    virt::inventory::Tracker *tracker = native->GetInventory();
+
+    if (NULL == tracker) {
+        tracker = new virt::inventory::Tracker(**native);
+        native->SetInventory(tracker);
+    }
+
+    if (!tracker->Acquire()) {
+        virt::throwError(isolate, "An inventory diff is running already");
+        return;
+    }
+
+    virt::Worker::Run(args, new DiffInventoryWorker(**native, tracker, mask, full), native->GetExecutor());
+}
+
+static void __resetInventory(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::inventory::Tracker *tracker = native->GetInventory();
+    native->SetInventory(NULL);
+    virt::Worker::Run(args, new ResetInventoryWorker(**native, tracker), native->GetExecutor());
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace virt {
+    namespace inventory {
+
+        void prototype(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "diffInventory",                 __diffInventory);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "resetInventory",                __resetInventory);
+        }
+
+    } // namespace inventory
+} // namespace virt
@@ -0,0 +1,173 @@
+#ifndef __NODE_VIRT_INVENTORY_H__
+#define __NODE_VIRT_INVENTORY_H__
+
+// standard c
+#include <stdint.h>
+
+// standard c++
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// libvirt
+#include <libvirt/libvirt.h>
+
+// node
+#include <node.h>
+#include <uv.h>
+
+namespace virt {
+    namespace inventory {
+
+        void prototype(v8::Local<v8::FunctionTemplate> tpl);
+
+        enum Kind {
+            DOMAIN,
+            INTERFACE,
+            NETWORK,
+            STORAGE_POOL,
+            KINDS
+        };
+
+        /**
+         * An added, removed or changed object
+         */
+        struct Record {
+            Kind kind;
+            // the UUID, or the name of interfaces which have none
+            std::string key;
+            std::string name;
+            const char *change;
+            // hash of the XML description, 0 for removed objects
+            uint64_t hash;
+        };
+
+        /**
+         * The result of a diff per kind
+         */
+        struct Scan {
+            // "full", "partial" or "skipped"
+            const char *mode;
+            // empty unless the scan failed, the snapshot is kept as is then
+            std::string error;
+        };
+
+        /**
+         * The inventory of the objects of a connection as of the last diff,
+         * with the hash of the XML description per object.
+         *
+         * A diff lists the objects of a kind again and hashes their XML
+         * off the loop, and reports the objects which appeared, vanished
+         * or whose XML changed. Kinds whose events could be registered are
+         * only looked at again where the events say something happened:
+         * not at all if nothing did, and only the objects concerned
+         * otherwise. Interfaces have no events and are always listed.
+         *
+         * The events are delivered on the libvirt event loop thread, they
+         * only mark objects dirty under the lock. The tracker is shared by
+         * the connection, a running diff and the registered callbacks, and
+         * deleted once all of them let it go.
+         */
+        class Tracker {
+        public:
+
+            Tracker(virConnectPtr conn);
+
+            /**
+             * Marks the tracker busy, returns false if a diff is running
+             * already
+             */
+            bool Acquire();
+
+            /**
+             * Diffs the kinds of the mask, bit <code>n</code> for kind
+             * <code>n</code>, and clears the busy mark. Every kind is
+             * rescanned completely if <code>full</code>. May block on the
+             * hypervisor.
+             */
+            void Diff(unsigned int kinds, bool full, std::vector<Record> *changes, Scan *scans);
+
+            /**
+             * Deregisters the events and drops the reference of the owner,
+             * may block on the hypervisor
+             */
+            void Stop();
+
+            void Ref();
+
+            void Unref();
+
+        private:
+
+            struct Item {
+                std::string name;
+                uint64_t hash;
+            };
+
+            struct State {
+                std::map<std::string, Item> items;
+                // whether the items have been listed once
+                bool scanned;
+                // whether events mark the dirty objects of the kind
+                bool watched;
+                std::set<std::string> dirty;
+                // too many or unknown objects are dirty, rescan all of them
+                bool overflow;
+            };
+
+            ~Tracker();
+
+            /**
+             * Registers the events of every kind which has them
+             */
+            void Register();
+
+            int RegisterDomainEvent(int eventID, virConnectDomainEventGenericCallback cb);
+
+            void Mark(Kind kind, const std::string& key);
+
+            template <typename T>
+            void Rescan(bool full, std::vector<Record> *changes, Scan *scan);
+
+            template <typename T>
+            static void OnObjectEvent(virConnectPtr conn, T obj, void *opaque);
+
+            template <typename T>
+            static void OnLifecycleEvent(virConnectPtr conn, T obj, int event, int detail, void *opaque);
+
+            static void OnDeviceEvent(virConnectPtr conn, virDomainPtr dom, const char *alias, void *opaque);
+
+            static void OnTunableEvent(virConnectPtr conn, virDomainPtr dom, virTypedParameterPtr params, int nparams, void *opaque);
+
+            static void OnMetadataEvent(virConnectPtr conn, virDomainPtr dom, int type, const char *nsuri, void *opaque);
+
+            static void OnBalloonEvent(virConnectPtr conn, virDomainPtr dom, unsigned long long actual, void *opaque);
+
+            static void OnTrayEvent(virConnectPtr conn, virDomainPtr dom, const char *alias, int reason, void *opaque);
+
+            static void OnReleased(void *opaque);
+
+            uv_mutex_t lock;
+
+            virConnectPtr conn;
+
+            unsigned int refs;
+
+            bool busy;
+
+            bool registered;
+
+            bool stopped;
+
+            // the kind and the id of every registered callback
+            std::vector<std::pair<Kind, int> > callbacks;
+
+            State states[KINDS];
+        };
+
+    } // namespace inventory
+} // namespace virt
+
+#endif /* __NODE_VIRT_INVENTORY_H__ */
@@ -0,0 +1,664 @@
+/**
+ * Native mirror of the domain states for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+#include "virt-error.h"
+#include "virt-host.h"
+#include "virt-mirror.h"
+#include "virt-worker.h"
+
+namespace virt {
+    namespace mirror {
+
+        Mirror::Mirror(virConnectPtr conn)
+            : conn(conn), callbackID(-1), refs(1), seeding(true), ready(false), stopped(false), generation(0) {
+            uv_mutex_init(&this->lock);
+        }
+
+        Mirror::~Mirror() {
+            uv_mutex_destroy(&this->lock);
+        }
+
+        void Mirror::Ref() {
+            uv_mutex_lock(&this->lock);
+            this->refs++;
+            uv_mutex_unlock(&this->lock);
+        }
+
+        void Mirror::Unref() {
+            uv_mutex_lock(&this->lock);
+            bool last = 0 == --this->refs;
+            uv_mutex_unlock(&this->lock);
+
+            if (last) {
+                delete this;
+            }
+        }
+
+        bool Mirror::Start() {
+            // the reference of the callback, dropped by OnReleased()
+            this->Ref();
+
+            int id = virConnectDomainEventRegisterAny(this->conn, NULL, VIR_DOMAIN_EVENT_ID_LIFECYCLE,
+                    VIR_DOMAIN_EVENT_CALLBACK(OnLifecycle), this, OnReleased);
+
+            if (-1 == id) {
+                uv_mutex_lock(&this->lock);
+                this->seeding = false;
+                uv_mutex_unlock(&this->lock);
+
+                this->Unref();
+                return false;
+            }
+
+            uv_mutex_lock(&this->lock);
+            bool stopped = this->stopped;
+            this->callbackID = stopped ? -1 : id;
+            uv_mutex_unlock(&this->lock);
+
+            // stopped while registering
+            if (stopped) {
+                virConnectDomainEventDeregisterAny(this->conn, id);
+                return true;
+            }
+
+            // the events arriving meanwhile are applied already, the seed
+            // only fills in what they did not touch
+            std::vector<DomainState> seed;
+            bool seeded = this->Seed(&seed);
+
+            uv_mutex_lock(&this->lock);
+
+            if (seeded) {
+                for (size_t i = 0; i < seed.size(); i++) {
+                    const DomainState& state = seed[i];
+                    std::map<std::string, DomainState>::iterator it = this->domains.find(state.uuid);
+
+                    if (this->removed.count(state.uuid) > 0) {
+                        continue;
+                    }
+
+                    if (it == this->domains.end()) {
+                        this->Put(state);
+                    } else if (0 == this->defined.count(state.uuid)) {
+                        it->second.persistent = state.persistent;
+                    }
+                }
+
+                // stopped transient domains are gone
+                std::vector<std::string> gone;
+
+                for (std::map<std::string, DomainState>::iterator it = this->domains.begin(); it != this->domains.end(); ++it) {
+                    if (VIR_DOMAIN_SHUTOFF == it->second.state && !it->second.persistent) {
+                        gone.push_back(it->first);
+                    }
+                }
+
+                for (size_t i = 0; i < gone.size(); i++) {
+                    this->Remove(gone[i]);
+                }
+
+                this->ready = true;
+                this->generation++;
+            } else {
+                id = this->callbackID;
+                this->callbackID = -1;
+            }
+
+            this->seeding = false;
+            this->defined.clear();
+            this->removed.clear();
+            uv_mutex_unlock(&this->lock);
+
+            if (!seeded && -1 != id) {
+                // keeps the error of the seed
+                virErrorPtr error = virSaveLastError();
+                virConnectDomainEventDeregisterAny(this->conn, id);
+                virSetError(error);
+                virFreeError(error);
+            }
+
+            return seeded;
+        }
+
+        void Mirror::Stop() {
+            uv_mutex_lock(&this->lock);
+            int id = this->callbackID;
+            this->stopped = true;
+            this->callbackID = -1;
+            uv_mutex_unlock(&this->lock);
+
+            if (-1 != id) {
+                virConnectDomainEventDeregisterAny(this->conn, id);
+            }
+
+            this->Unref();
+        }
+
+        bool Mirror::IsReady() {
+            uv_mutex_lock(&this->lock);
+            bool ready = this->ready;
+            uv_mutex_unlock(&this->lock);
+            return ready;
+        }
+
+        bool Mirror::IsFailed() {
+            uv_mutex_lock(&this->lock);
+            bool failed = !this->ready && !this->seeding;
+            uv_mutex_unlock(&this->lock);
+            return failed;
+        }
+
+        void Mirror::Fail() {
+            uv_mutex_lock(&this->lock);
+            this->ready = false;
+            uv_mutex_unlock(&this->lock);
+        }
+
+        uint64_t Mirror::GetGeneration() {
+            uv_mutex_lock(&this->lock);
+            uint64_t generation = this->generation;
+            uv_mutex_unlock(&this->lock);
+            return generation;
+        }
+
+        bool Mirror::Lookup(const std::string& key, bool byName, DomainState *result) {
+            bool found = false;
+
+            uv_mutex_lock(&this->lock);
+
+            std::string uuid = key;
+            if (byName) {
+                std::map<std::string, std::string>::iterator i = this->names.find(key);
+                uuid = i == this->names.end() ? "" : i->second;
+            }
+
+            std::map<std::string, DomainState>::iterator i = this->domains.find(uuid);
+            if (i != this->domains.end()) {
+                *result = i->second;
+                found = true;
+            }
+
+            uv_mutex_unlock(&this->lock);
+            return found;
+        }
+
+        void Mirror::List(unsigned int states, std::vector<DomainState> *result) {
+            uv_mutex_lock(&this->lock);
+
+            for (std::map<std::string, DomainState>::iterator i = this->domains.begin(); i != this->domains.end(); ++i) {
+                int state = i->second.state;
+
+                if (state >= 0 && state < 32 && 0 != (states & (1u << state))) {
+                    result->push_back(i->second);
+                }
+            }
+
+            uv_mutex_unlock(&this->lock);
+        }
+
+        void Mirror::OnLifecycle(virConnectPtr conn, virDomainPtr dom, int event, int detail, void *opaque) {
+            Mirror *self = static_cast<Mirror*>(opaque);
+
+            uv_mutex_lock(&self->lock);
+
+            if (self->Apply(dom, event, detail)) {
+                self->generation++;
+            }
+
+            uv_mutex_unlock(&self->lock);
+        }
+
+        void Mirror::OnReleased(void *opaque) {
+            static_cast<Mirror*>(opaque)->Unref();
+        }
+
+        bool Mirror::Apply(virDomainPtr dom, int event, int detail) {
+            char uuid[VIR_UUID_STRING_BUFLEN];
+
+            // both are known locally, no call to the hypervisor
+            if (0 != virDomainGetUUIDString(dom, uuid)) {
+                return false;
+            }
+
+            const char *name = virDomainGetName(dom);
+            std::map<std::string, DomainState>::iterator it = this->domains.find(uuid);
+            bool known = it != this->domains.end();
+            DomainState state;
+
+            if (known) {
+                state = it->second;
+            } else {
+                state.uuid = uuid;
+                state.state = VIR_DOMAIN_NOSTATE;
+                state.persistent = false;
+            }
+
+            if (NULL != name) {
+                state.name = name;
+            }
+
+            switch (event) {
+            case VIR_DOMAIN_EVENT_DEFINED:
+                if (!known) {
+                    state.state = VIR_DOMAIN_SHUTOFF;
+                }
+                state.persistent = true;
+                break;
+            case VIR_DOMAIN_EVENT_UNDEFINED:
+                // followed by the definition under the new name
+                if (VIR_DOMAIN_EVENT_UNDEFINED_RENAMED == detail) {
+                    return false;
+                }
+
+                if (!known || VIR_DOMAIN_SHUTOFF == state.state) {
+                    this->Remove(state.uuid);
+                    return known;
+                }
+
+                state.persistent = false;
+                break;
+            case VIR_DOMAIN_EVENT_STARTED:
+            case VIR_DOMAIN_EVENT_RESUMED:
+                state.state = VIR_DOMAIN_RUNNING;
+                break;
+            case VIR_DOMAIN_EVENT_SUSPENDED:
+                state.state = VIR_DOMAIN_PAUSED;
+                break;
+            case VIR_DOMAIN_EVENT_STOPPED:
+                // transient domains vanish, while seeding their persistence
+                // may not be known yet
+                if (known && !state.persistent && !this->seeding) {
+                    this->Remove(state.uuid);
+                    return true;
+                }
+
+                state.state = VIR_DOMAIN_SHUTOFF;
+                break;
+            case VIR_DOMAIN_EVENT_SHUTDOWN:
+                state.state = VIR_DOMAIN_SHUTDOWN;
+                break;
+            case VIR_DOMAIN_EVENT_PMSUSPENDED:
+                state.state = VIR_DOMAIN_PMSUSPENDED;
+                break;
+            case VIR_DOMAIN_EVENT_CRASHED:
+                state.state = VIR_DOMAIN_CRASHED;
+                break;
+            default:
+                return false;
+            }
+
+            if (this->seeding && (VIR_DOMAIN_EVENT_DEFINED == event || VIR_DOMAIN_EVENT_UNDEFINED == event)) {
+                this->defined.insert(state.uuid);
+            }
+
+            if (known && it->second.state == state.state && it->second.name == state.name
+                    && it->second.persistent == state.persistent) {
+                return false;
+            }
+
+            this->Put(state);
+            return true;
+        }
+
+        bool Mirror::Seed(std::vector<DomainState> *seed) {
+            virDomainStatsRecordPtr *records = NULL;
+            int n = virConnectGetAllDomainStats(this->conn, VIR_DOMAIN_STATS_STATE, &records, 0);
+
+            if (n >= 0) {
+                for (int i = 0; i < n; i++) {
+                    DomainState state;
+                    char uuid[VIR_UUID_STRING_BUFLEN];
+                    const char *name = virDomainGetName(records[i]->dom);
+
+                    if (0 != virDomainGetUUIDString(records[i]->dom, uuid)) {
+                        continue;
+                    }
+
+                    state.uuid = uuid;
+                    state.name = NULL == name ? "" : name;
+                    state.state = VIR_DOMAIN_NOSTATE;
+                    state.persistent = true;
+
+                    for (int j = 0; j < records[i]->nparams; j++) {
+                        virTypedParameterPtr param = records[i]->params + j;
+                        if (VIR_TYPED_PARAM_INT == param->type && 0 == strcmp(param->field, "state.state")) {
+                            state.state = param->value.i;
+                            break;
+                        }
+                    }
+
+                    seed->push_back(state);
+                }
+
+                virDomainStatsRecordListFree(records);
+            } else {
+                // older daemons, one state request per domain
+                virDomainPtr *doms = NULL;
+
+                virResetLastError();
+                if ((n = virConnectListAllDomains(this->conn, &doms, 0)) < 0) {
+                    return false;
+                }
+
+                for (int i = 0; i < n; i++) {
+                    DomainState state;
+                    char uuid[VIR_UUID_STRING_BUFLEN];
+                    const char *name = virDomainGetName(doms[i]);
+                    int reason;
+
+                    if (0 == virDomainGetUUIDString(doms[i], uuid)) {
+                        state.uuid = uuid;
+                        state.name = NULL == name ? "" : name;
+                        state.persistent = true;
+
+                        if (0 != virDomainGetState(doms[i], &state.state, &reason, 0)) {
+                            state.state = VIR_DOMAIN_NOSTATE;
+                        }
+
+                        seed->push_back(state);
+                    }
+
+                    virDomainFree(doms[i]);
+                }
+
+                free(doms);
+            }
+
+            // transient domains are few, so they are listed rather than
+            // asking every domain
+            virDomainPtr *transient = NULL;
+            int m = virConnectListAllDomains(this->conn, &transient, VIR_CONNECT_LIST_DOMAINS_TRANSIENT);
+
+            if (m < 0) {
+                return false;
+            }
+
+            std::set<std::string> uuids;
+
+            for (int i = 0; i < m; i++) {
+                char uuid[VIR_UUID_STRING_BUFLEN];
+
+                if (0 == virDomainGetUUIDString(transient[i], uuid)) {
+                    uuids.insert(uuid);
+                }
+
+                virDomainFree(transient[i]);
+            }
+
+            free(transient);
+
+            for (size_t i = 0; i < seed->size(); i++) {
+                (*seed)[i].persistent = 0 == uuids.count((*seed)[i].uuid);
+            }
+
+            return true;
+        }
+
+        void Mirror::Put(const DomainState& state) {
+            std::map<std::string, DomainState>::iterator it = this->domains.find(state.uuid);
+
+            if (it != this->domains.end()) {
+                if (it->second.name != state.name) {
+                    this->names.erase(it->second.name);
+                }
+
+                it->second = state;
+            } else {
+                this->domains[state.uuid] = state;
+            }
+
+            this->names[state.name] = state.uuid;
+        }
+
+        void Mirror::Remove(const std::string& uuid) {
+            std::map<std::string, DomainState>::iterator it = this->domains.find(uuid);
+
+            if (this->seeding) {
+                this->removed.insert(uuid);
+            }
+
+            if (it != this->domains.end()) {
+                this->names.erase(it->second.name);
+                this->domains.erase(it);
+            }
+        }
+
+    } // namespace mirror
+} // namespace virt
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+class MirrorWorker : public virt::Worker {
+public:
+    inline MirrorWorker(virConnectPtr conn, virt::mirror::Mirror *mirror) : conn(conn), mirror(mirror) {
+        this->mirror->Ref();
+    }
+
+    virtual ~MirrorWorker() {
+        this->mirror->Unref();
+    }
+
+    virtual void Execute() {
+        if (!this->mirror->Start()) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return v8::Number::New(isolate, static_cast<double>(this->mirror->GetGeneration()));
+    }
+
+private:
+    // the mirror calls the connection without a reference of its own
+    virt::Reference<virConnectPtr> conn;
+    virt::mirror::Mirror *mirror;
+};
+
+class UnmirrorWorker : public virt::Worker {
+public:
+    inline UnmirrorWorker(virConnectPtr conn, virt::mirror::Mirror *mirror) : conn(conn), mirror(mirror) {}
+
+    virtual void Execute() {
+        if (NULL != this->mirror) {
+            this->mirror->Stop();
+        }
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    virt::mirror::Mirror *mirror;
+};
+
+static void __mirrorDomainStates(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::mirror::Mirror *mirror = native->GetMirror();
+
+    if (NULL != mirror && !mirror->IsFailed() && 1 == virConnectIsAlive(**native)) {
+        virt::throwError(isolate, "Domain states are mirrored already");
+        return;
+    }
+
+    // a failed seed has no events registered, a dead connection has none
+    // which work
+    if (NULL != mirror) {
+        mirror->Stop();
+    }
+
+    mirror = new virt::mirror::Mirror(**native);
+    native->SetMirror(mirror);
+    virt::Worker::Run(args, new MirrorWorker(**native, mirror), native->GetExecutor());
+}
+
+static void __unmirrorDomainStates(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::mirror::Mirror *mirror = native->GetMirror();
+    native->SetMirror(NULL);
+    virt::Worker::Run(args, new UnmirrorWorker(**native, mirror), native->GetExecutor());
+}
+
+/**
+ * Returns the seeded mirror of the connection, throws and returns NULL if
+ * there is none or its connection has died
+ */
+static virt::mirror::Mirror *getMirror(v8::Isolate *isolate, virt::host::Connection *native) {
+    virt::mirror::Mirror *mirror = native->GetMirror();
+
+    if (NULL == mirror || !mirror->IsReady()) {
+        virt::throwError(isolate, "Domain states are not mirrored");
+        return NULL;
+    }
+
+    // no events arrive on a dead connection, the states would go stale;
+    // only looks at the local state of the connection
+    if (1 != virConnectIsAlive(**native)) {
+        mirror->Fail();
+        virt::throwError(isolate, "Domain states are no longer mirrored, the connection is dead");
+        return NULL;
+    }
+
+    return mirror;
+}
+
+static v8::Local<v8::Object> toObject(v8::Isolate *isolate, const virt::mirror::DomainState& state) {
+    v8::Local<v8::Object> obj = v8::Object::New(isolate);
+
+    obj->Set(v8::String::NewFromUtf8(isolate, "uuid"), v8::String::NewFromUtf8(isolate, state.uuid.c_str()));
+    obj->Set(v8::String::NewFromUtf8(isolate, "name"), v8::String::NewFromUtf8(isolate, state.name.c_str()));
+    obj->Set(v8::String::NewFromUtf8(isolate, "state"), v8::Integer::New(isolate, state.state));
+    obj->Set(v8::String::NewFromUtf8(isolate, "persistent"), v8::Boolean::New(isolate, state.persistent));
+    return obj;
+}
+
+static void lookupMirroredDomainState(const v8::FunctionCallbackInfo<v8::Value>& args, bool byName) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    virt::mirror::Mirror *mirror = getMirror(isolate, native);
+    if (NULL == mirror) {
+        return;
+    }
+
+    v8::String::Utf8Value key(args[0]->ToString());
+    virt::mirror::DomainState state;
+
+    if (mirror->Lookup(*key, byName, &state)) {
+        args.GetReturnValue().Set(toObject(isolate, state));
+    } else {
+        args.GetReturnValue().SetNull();
+    }
+}
+
+static void __lookupMirroredDomainStateByName(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    lookupMirroredDomainState(args, true);
+}
+
+static void __lookupMirroredDomainStateByUUID(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    lookupMirroredDomainState(args, false);
+}
+
+static void __listMirroredDomainStates(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    virt::mirror::Mirror *mirror = getMirror(isolate, native);
+    if (NULL == mirror) {
+        return;
+    }
+
+    // all states unless given as a single state or an array of them
+    unsigned int states = ~0u;
+
+    if (args.Length() > 0 && args[0]->IsArray()) {
+        v8::Local<v8::Array> filter = v8::Local<v8::Array>::Cast(args[0]);
+        states = 0;
+
+        for (uint32_t i = 0; i < filter->Length(); i++) {
+            v8::Local<v8::Value> state = filter->Get(i);
+
+            if (!state->IsUint32() || state->Uint32Value() >= 32) {
+                virt::throwTypeError(isolate, "Invalid domain state");
+                return;
+            }
+
+            states |= 1u << state->Uint32Value();
+        }
+    } else if (args.Length() > 0 && args[0]->IsUint32()) {
+        states = args[0]->Uint32Value() < 32 ? 1u << args[0]->Uint32Value() : 0;
+    }
+
+    std::vector<virt::mirror::DomainState> domains;
+    mirror->List(states, &domains);
+
+    v8::Local<v8::Array> result = v8::Array::New(isolate, domains.size());
+    for (size_t i = 0; i < domains.size(); i++) {
+        result->Set(i, toObject(isolate, domains[i]));
+    }
+
+    args.GetReturnValue().Set(result);
+}
+
+static void __getMirroredDomainStateGeneration(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    virt::mirror::Mirror *mirror = getMirror(isolate, native);
+    if (NULL == mirror) {
+        return;
+    }
+
+    args.GetReturnValue().Set(v8::Number::New(isolate, static_cast<double>(mirror->GetGeneration())));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace virt {
+    namespace mirror {
+
+        void prototype(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getMirroredDomainStateGeneration", __getMirroredDomainStateGeneration);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "listMirroredDomainStates",         __listMirroredDomainStates);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "lookupMirroredDomainStateByName",  __lookupMirroredDomainStateByName);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "lookupMirroredDomainStateByUUID",  __lookupMirroredDomainStateByUUID);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "mirrorDomainStates",               __mirrorDomainStates);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "unmirrorDomainStates",             __unmirrorDomainStates);
+        }
+
+    } // namespace mirror
+} // namespace virt
@@ -0,0 +1,154 @@
+#ifndef __NODE_VIRT_MIRROR_H__
+#define __NODE_VIRT_MIRROR_H__
+
+// standard c
+#include <stdint.h>
+
+// standard c++
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// libvirt
+#include <libvirt/libvirt.h>
+
+// node
+#include <node.h>
+#include <uv.h>
+
+namespace virt {
+    namespace mirror {
+
+        void prototype(v8::Local<v8::FunctionTemplate> tpl);
+
+        /**
+         * The state of a mirrored domain
+         */
+        struct DomainState {
+            std::string uuid;
+            std::string name;
+            // one of virDomainState
+            int state;
+            bool persistent;
+        };
+
+        /**
+         * A table of the states of all domains of a connection, seeded
+         * once and kept current by the lifecycle events, so it can be
+         * queried without any call to the hypervisor.
+         *
+         * The events are delivered on the libvirt event loop thread and
+         * queries come from the JS threads, the table is guarded by a lock.
+         * The mirror is shared by the connection, a running seed and the
+         * registered callback, and deleted once all of them let it go.
+         */
+        class Mirror {
+        public:
+
+            Mirror(virConnectPtr conn);
+
+            /**
+             * Registers for the lifecycle events and seeds the table, may
+             * block on the hypervisor. Returns false with the libvirt error
+             * set if either fails.
+             */
+            bool Start();
+
+            /**
+             * Deregisters the events and drops the reference of the owner,
+             * may block on the hypervisor
+             */
+            void Stop();
+
+            void Ref();
+
+            void Unref();
+
+            /**
+             * Whether the table has been seeded
+             */
+            bool IsReady();
+
+            /**
+             * Whether the seed has failed or the connection has died, the
+             * mirror is of no use then
+             */
+            bool IsFailed();
+
+            /**
+             * Marks the mirror failed, the events ended with the connection
+             */
+            void Fail();
+
+            /**
+             * Returns the number of changes of the table so far
+             */
+            uint64_t GetGeneration();
+
+            /**
+             * Looks up a domain by UUID, or by name if <code>byName</code>
+             */
+            bool Lookup(const std::string& key, bool byName, DomainState *result);
+
+            /**
+             * Returns the domains whose state is in the mask, bit
+             * <code>n</code> for virDomainState <code>n</code>
+             */
+            void List(unsigned int states, std::vector<DomainState> *result);
+
+        private:
+
+            ~Mirror();
+
+            static void OnLifecycle(virConnectPtr conn, virDomainPtr dom, int event, int detail, void *opaque);
+
+            static void OnReleased(void *opaque);
+
+            /**
+             * Applies a lifecycle event, must be called with the lock held
+             */
+            bool Apply(virDomainPtr dom, int event, int detail);
+
+            /**
+             * Collects the states of all domains, without the lock
+             */
+            bool Seed(std::vector<DomainState> *seed);
+
+            void Put(const DomainState& state);
+
+            void Remove(const std::string& uuid);
+
+            uv_mutex_t lock;
+
+            virConnectPtr conn;
+
+            int callbackID;
+
+            unsigned int refs;
+
+            bool seeding;
+
+            bool ready;
+
+            bool stopped;
+
+            uint64_t generation;
+
+            // keyed by UUID
+            std::map<std::string, DomainState> domains;
+
+            // UUID by name
+            std::map<std::string, std::string> names;
+
+            // domains whose persistence has been set by an event since the
+            // seeding started, and the ones removed meanwhile
+            std::set<std::string> defined;
+
+            std::set<std::string> removed;
+        };
+
+    } // namespace mirror
+} // namespace virt
+
+#endif /* __NODE_VIRT_MIRROR_H__ */
@@ -22,10 +22,12 @@ extern "C" {
 namespace virt {
     namespace nwfilter {
 
-        v8::Persistent<v8::Function> NetworkFilter::constructor;
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          NetworkFilter::Free<NetworkFilter>);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            NetworkFilter::Export<NetworkFilter>(exports, "NetworkFilter");
+            NetworkFilter::Export<NetworkFilter>(exports, "NetworkFilter", methods);
         }
 
     } // namespace nwfilter
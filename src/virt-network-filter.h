@@ -15,8 +15,6 @@ namespace virt {
 
         class NetworkFilter : public Pointer<virNWFilterPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline NetworkFilter(virNWFilterPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virNWFilterPtr>;
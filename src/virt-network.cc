@@ -22,10 +22,12 @@ extern "C" {
 namespace virt {
     namespace network {
 
-        v8::Persistent<v8::Function> Network::constructor;
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          Network::Free<Network>);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            Network::Export<Network>(exports, "Network");
+            Network::Export<Network>(exports, "Network", methods);
         }
 
     } // namespace network
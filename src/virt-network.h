@@ -15,8 +15,6 @@ namespace virt {
 
         class Network : public Pointer<virNetworkPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline Network(virNetworkPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virNetworkPtr>;
@@ -22,10 +22,12 @@ extern "C" {
 namespace virt {
     namespace nodedev {
 
-        v8::Persistent<v8::Function> NodeDevice::constructor;
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          NodeDevice::Free<NodeDevice>);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            NodeDevice::Export<NodeDevice>(exports, "NodeDevice");
+            NodeDevice::Export<NodeDevice>(exports, "NodeDevice", methods);
         }
 
     } // namespace nodedev
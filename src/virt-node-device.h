@@ -15,8 +15,6 @@ namespace virt {
 
         class NodeDevice : public Pointer<virNodeDevicePtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline NodeDevice(virNodeDevicePtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virNodeDevicePtr>;
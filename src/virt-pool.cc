@@ -0,0 +1,321 @@
+/**
+ * libvirt connection pool for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+// standard c++
+#include <map>
+#include <string>
+#include <vector>
+
+// node
+#include <uv.h>
+
+#include "virt-host.h"
+#include "virt-pool.h"
+#include "virt-worker.h"
+
+/**
+ * Pooled connections are shared: a connection is handed out again while
+ * still in use once the limit of its URI has been reached, libvirt
+ * connections being safe to use from several threads.
+ *
+ * libvirt takes the lock of the connection before invoking the close
+ * callback, so the pool lock is never held while calling into libvirt.
+ */
+
+struct Entry {
+    virConnectPtr conn;
+    std::string key;
+    unsigned int users;
+    bool dead;
+    bool detached;
+};
+
+struct Bucket {
+    std::vector<Entry*> entries;
+    unsigned int opening;
+};
+
+static uv_mutex_t lock;
+
+static uv_cond_t opened;
+
+static unsigned int limit = 4;
+
+static std::map<std::string, Bucket> buckets;
+
+static std::map<virConnectPtr, Entry*> pooled;
+
+static inline std::string keyOf(const char *name, bool readOnly) {
+    return std::string(readOnly ? "ro:" : "rw:") + (NULL == name ? "" : name);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void onClosed(virConnectPtr conn, int reason, void *opaque) {
+    uv_mutex_lock(&lock);
+    static_cast<Entry*>(opaque)->dead = true;
+    uv_mutex_unlock(&lock);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+static void dispose(Entry *entry) {
+    virConnectUnregisterCloseCallback(entry->conn, onClosed);
+    virConnectClose(entry->conn);
+    delete entry;
+}
+
+/**
+ * Removes the dead entries from the bucket, the ones which are not in use
+ * any more are returned to be disposed outside the lock
+ */
+static void purge(Bucket& bucket, std::vector<Entry*>& garbage) {
+    for (size_t i = 0; i < bucket.entries.size();) {
+        Entry *entry = bucket.entries[i];
+
+        if (!entry->dead) {
+            i++;
+            continue;
+        }
+
+        bucket.entries.erase(bucket.entries.begin() + i);
+        entry->detached = true;
+
+        if (0 == entry->users) {
+            pooled.erase(entry->conn);
+            garbage.push_back(entry);
+        }
+    }
+}
+
+static void dispose(std::vector<Entry*>& garbage) {
+    for (size_t i = 0; i < garbage.size(); i++) {
+        dispose(garbage[i]);
+    }
+
+    garbage.clear();
+}
+
+namespace virt {
+    namespace pool {
+
+        virConnectPtr Acquire(const char *name, bool readOnly) {
+            std::string key = keyOf(name, readOnly);
+            std::vector<Entry*> garbage;
+
+            for (;;) {
+                Entry *entry = NULL;
+
+                uv_mutex_lock(&lock);
+                Bucket& bucket = buckets[key];
+                purge(bucket, garbage);
+
+                // the limit is taken by connections being opened
+                while (bucket.entries.empty() && bucket.opening >= limit) {
+                    uv_cond_wait(&opened, &lock);
+                    purge(bucket, garbage);
+                }
+
+                for (size_t i = 0; i < bucket.entries.size(); i++) {
+                    if (NULL == entry || bucket.entries[i]->users < entry->users) {
+                        entry = bucket.entries[i];
+                    }
+                }
+
+                bool open = (NULL == entry || entry->users > 0) && bucket.entries.size() + bucket.opening < limit;
+                if (open) {
+                    bucket.opening++;
+                } else if (NULL != entry) {
+                    entry->users++;
+                }
+                uv_mutex_unlock(&lock);
+
+                dispose(garbage);
+
+                if (open) {
+                    break;
+                }
+
+                if (1 == virConnectIsAlive(entry->conn)) {
+                    virConnectRef(entry->conn);
+                    return entry->conn;
+                }
+
+                uv_mutex_lock(&lock);
+                entry->dead = true;
+                entry->users--;
+                uv_mutex_unlock(&lock);
+            }
+
+            virConnectPtr conn = readOnly ? virConnectOpenReadOnly(name) : virConnectOpen(name);
+            Entry *entry = NULL;
+
+            if (NULL != conn) {
+                entry = new Entry();
+                entry->conn = conn;
+                entry->key = key;
+                entry->users = 1;
+                entry->dead = false;
+                entry->detached = false;
+
+                // the close callback is optional, dead connections are also
+                // caught by the liveness check
+                virConnectRegisterCloseCallback(conn, onClosed, entry, NULL);
+                virConnectRef(conn);
+            }
+
+            uv_mutex_lock(&lock);
+            Bucket& bucket = buckets[key];
+            bucket.opening--;
+            if (NULL != entry) {
+                bucket.entries.push_back(entry);
+                pooled[conn] = entry;
+            }
+            uv_cond_broadcast(&opened);
+            uv_mutex_unlock(&lock);
+
+            return conn;
+        }
+
+        void Release(virConnectPtr conn) {
+            Entry *entry = NULL;
+
+            uv_mutex_lock(&lock);
+            std::map<virConnectPtr, Entry*>::iterator i = pooled.find(conn);
+            if (i != pooled.end() && i->second->users > 0 && 0 == --i->second->users && i->second->detached) {
+                entry = i->second;
+                pooled.erase(i);
+            }
+            uv_mutex_unlock(&lock);
+
+            if (NULL != entry) {
+                dispose(entry);
+            }
+        }
+
+    } // namespace pool
+} // namespace virt
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+class AcquireWorker : public virt::Worker {
+public:
+    inline AcquireWorker(const char *name, bool readOnly)
+        : name(NULL == name ? NULL : strdup(name)), readOnly(readOnly), conn(NULL) {}
+
+    virtual ~AcquireWorker() {
+        free(this->name);
+    }
+
+    virtual void Execute() {
+        if (NULL == (this->conn = virt::pool::Acquire(this->name, this->readOnly))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        return virt::host::Connection::NewInstance<virt::host::Connection>(this->conn);
+    }
+
+private:
+    char *name;
+    bool readOnly;
+    virConnectPtr conn;
+};
+
+static void __acquireConnection(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    bool readOnly = args.Length() > 1 && args[1]->IsBoolean() && args[1]->BooleanValue();
+
+    if (0 == args.Length() || args[0]->IsUndefined() || args[0]->IsNull() || args[0]->IsFunction()) {
+        virt::Worker::Run(args, new AcquireWorker(NULL, readOnly));
+    } else if (!args[0]->IsString()) {
+        virt::throwTypeError(isolate, "Invalid argument");
+    } else {
+        v8::String::Utf8Value name(args[0]->ToString());
+        virt::Worker::Run(args, new AcquireWorker(*name, readOnly));
+    }
+}
+
+static void __setConnectionPoolLimit(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    if (args.Length() < 1) {
+        virt::throwError(isolate, "Too few arguments");
+        return;
+    }
+
+    CHK_ARGUMENT_TYPE(isolate, args[0], Uint32);
+
+    if (0 == args[0]->Uint32Value()) {
+        virt::throwError(isolate, "Invalid argument");
+        return;
+    }
+
+    uv_mutex_lock(&lock);
+    limit = args[0]->Uint32Value();
+    uv_mutex_unlock(&lock);
+}
+
+static void __drainConnectionPool(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+    std::vector<Entry*> garbage;
+
+    // idle connections are closed, the ones in use are closed on release
+    uv_mutex_lock(&lock);
+    for (std::map<std::string, Bucket>::iterator i = buckets.begin(); i != buckets.end(); ++i) {
+        for (size_t j = 0; j < i->second.entries.size(); j++) {
+            i->second.entries[j]->dead = true;
+        }
+
+        purge(i->second, garbage);
+    }
+    uv_mutex_unlock(&lock);
+
+    v8::Local<v8::Number> count = v8::Number::New(isolate, garbage.size());
+    dispose(garbage);
+    args.GetReturnValue().Set(count);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace virt {
+    namespace pool {
+
+        static uv_once_t once = UV_ONCE_INIT;
+
+        static void initialize() {
+            uv_mutex_init(&lock);
+            uv_cond_init(&opened);
+        }
+
+        void exports(v8::Handle<v8::Object> exports) {
+            // the pool is shared by all isolates
+            uv_once(&once, initialize);
+
+            VIRT_SET_METHOD(exports, "acquireConnection",                   __acquireConnection);
+            VIRT_SET_METHOD(exports, "setConnectionPoolLimit",              __setConnectionPoolLimit);
+            VIRT_SET_METHOD(exports, "drainConnectionPool",                 __drainConnectionPool);
+        }
+
+    } // namespace pool
+} // namespace virt
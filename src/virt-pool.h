@@ -0,0 +1,35 @@
+#ifndef __NODE_VIRT_POOL_H__
+#define __NODE_VIRT_POOL_H__
+
+// libvirt
+#include <libvirt/libvirt.h>
+
+// node
+#include <node.h>
+
+namespace virt {
+    namespace pool {
+
+        void exports(v8::Handle<v8::Object> exports);
+
+        /**
+         * Returns a live pooled connection to the URI, opens a new one if
+         * every pooled connection is in use and the limit of the URI has
+         * not been reached yet. The returned connection holds a reference
+         * which is dropped by virConnectClose, returns NULL on error.
+         *
+         * May be called from any thread.
+         */
+        virConnectPtr Acquire(const char *name, bool readOnly);
+
+        /**
+         * Gives the connection back to the pool, does nothing if the
+         * connection does not belong to the pool. Must be called before
+         * virConnectClose drops the reference of the caller.
+         */
+        void Release(virConnectPtr conn);
+
+    } // namespace pool
+} // namespace virt
+
+#endif /* __NODE_VIRT_POOL_H__ */
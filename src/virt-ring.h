@@ -0,0 +1,101 @@
+#ifndef __NODE_VIRT_RING_H__
+#define __NODE_VIRT_RING_H__
+
+// standard c
+#include <stddef.h>
+#include <stdint.h>
+
+namespace virt {
+
+    /**
+     * Growable FIFO ring buffer.
+     *
+     * Every item is addressed by an absolute sequence number which stays
+     * valid until the item is shifted out, even across growth, so callers
+     * can remember where an item lives and update it in place.
+     */
+    template <typename T>
+    class Ring {
+    public:
+
+        inline Ring(size_t capacity = 64) : head(0), tail(0) {
+            size_t n = 1;
+            while (n < capacity) {
+                n <<= 1;
+            }
+
+            this->items = new T[n];
+            this->mask = n - 1;
+        }
+
+        inline ~Ring() {
+            delete[] this->items;
+        }
+
+        inline size_t Size() const { return static_cast<size_t>(this->tail - this->head); }
+
+        inline bool IsEmpty() const { return this->tail == this->head; }
+
+        /**
+         * Returns the sequence number of the oldest item
+         */
+        inline uint64_t Head() const { return this->head; }
+
+        /**
+         * Returns the sequence number the next pushed item will get
+         */
+        inline uint64_t Tail() const { return this->tail; }
+
+        inline bool Contains(uint64_t seq) const {
+            return seq >= this->head && seq < this->tail;
+        }
+
+        inline T& At(uint64_t seq) {
+            return this->items[seq & this->mask];
+        }
+
+        inline uint64_t Push(const T& item) {
+            if (this->Size() > this->mask) {
+                this->Grow();
+            }
+
+            this->items[this->tail & this->mask] = item;
+            return this->tail++;
+        }
+
+        inline T Shift() {
+            return this->items[this->head++ & this->mask];
+        }
+
+    private:
+
+        void Grow() {
+            size_t capacity = (this->mask + 1) << 1;
+            size_t mask = capacity - 1;
+            T *items = new T[capacity];
+
+            for (uint64_t seq = this->head; seq < this->tail; seq++) {
+                items[seq & mask] = this->items[seq & this->mask];
+            }
+
+            delete[] this->items;
+            this->items = items;
+            this->mask = mask;
+        }
+
+        Ring(const Ring&);
+
+        Ring& operator=(const Ring&);
+
+        T *items;
+
+        size_t mask;
+
+        uint64_t head;
+
+        uint64_t tail;
+    };
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_RING_H__ */
@@ -22,10 +22,12 @@ extern "C" {
 namespace virt {
     namespace secret {
 
-        v8::Persistent<v8::Function> Secret::constructor;
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          Secret::Free<Secret>);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            Secret::Export<Secret>(exports, "Secret");
+            Secret::Export<Secret>(exports, "Secret", methods);
         }
 
     } // namespace secret
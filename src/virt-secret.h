@@ -15,8 +15,6 @@ namespace virt {
 
         class Secret : public Pointer<virSecretPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline Secret(virSecretPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virSecretPtr>;
@@ -0,0 +1,586 @@
+/**
+ * Call instrumentation for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// standard c++
+#include <map>
+#include <string>
+#include <vector>
+
+// node
+#include <uv.h>
+
+#include "pointer.h"
+#include "virt-stats.h"
+
+/**
+ * The native functions are exported through a trampoline which calls them
+ * directly while the instrumentation is disabled. Once enabled, every
+ * thread adds its samples to its own counters, which only that thread
+ * writes, so recording needs neither locks nor atomic read-modify-write
+ * operations; a snapshot merges the counters of all threads. When a thread
+ * exits, its counters are folded into a shared table and released.
+ *
+ * The latencies are kept in log-linear histograms: 8 linear buckets per
+ * power of two nanoseconds, i.e. within 12.5% of the recorded value.
+ */
+
+namespace {
+
+    static const int SUB_BUCKET_BITS = 3;
+
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    // the last bucket collects everything above 2^40ns (~18 minutes)
+    static const int MAX_EXPONENT = 40;
+
+    static const int BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    struct Histogram {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> min;
+        std::atomic<uint64_t> max;
+        std::atomic<uint64_t> buckets[BUCKETS];
+    };
+
+    struct Entry {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> errors;
+        Histogram phases[virt::stats::PHASES];
+    };
+
+    /**
+     * The counters of one thread, entries are allocated by the thread on its
+     * first sample of the binding
+     */
+    struct Counters {
+        size_t size;
+        std::atomic<Entry*> *entries;
+        Counters *next;
+    };
+
+    static std::atomic<bool> enabled(false);
+
+    // shared by the isolates, a function loaded by several of them is
+    // counted once
+    static uv_mutex_t lock;
+
+    static uv_once_t once = UV_ONCE_INIT;
+
+    static std::vector<virt::stats::Binding*> bindings;
+
+    static std::map<std::string, virt::stats::Binding*> bindingsByName;
+
+    static thread_local std::string clazz;
+
+    // the counters of the live threads, guarded by the lock
+    static Counters *threads = NULL;
+
+    // the entries of the exited threads by binding id, guarded by the lock
+    static std::vector<Entry*> retired;
+
+    static void retire(Counters *self);
+
+    /**
+     * Retires the counters of the thread when it exits
+     */
+    struct Local {
+        Counters *counters;
+
+        ~Local() {
+            if (NULL != this->counters) {
+                retire(this->counters);
+            }
+        }
+    };
+
+    static thread_local Local local = { NULL };
+
+    /**
+     * Adds to a counter only written by the calling thread
+     */
+    static inline void add(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static inline int bucketOf(uint64_t ns) {
+        if (ns < SUB_BUCKETS) {
+            return static_cast<int>(ns);
+        }
+
+        int exponent = 63 - __builtin_clzll(ns);
+        if (exponent > MAX_EXPONENT) {
+            return BUCKETS - 1;
+        }
+
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+            + static_cast<int>((ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    }
+
+    static inline uint64_t lowestOf(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+
+        int exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+        return static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - SUB_BUCKET_BITS);
+    }
+
+    static inline uint64_t highestOf(int bucket) {
+        return (bucket + 1 < BUCKETS) ? lowestOf(bucket + 1) - 1 : UINT64_MAX;
+    }
+
+    static Counters *counters() {
+        if (NULL != local.counters) {
+            return local.counters;
+        }
+
+        // every binding is registered when the module is loaded first
+        Counters *self = new Counters();
+        uv_mutex_lock(&lock);
+        self->size = bindings.size();
+        self->entries = new std::atomic<Entry*>[self->size];
+
+        for (size_t i = 0; i < self->size; i++) {
+            self->entries[i].store(NULL, std::memory_order_relaxed);
+        }
+
+        self->next = threads;
+        threads = self;
+        uv_mutex_unlock(&lock);
+
+        return local.counters = self;
+    }
+
+    /**
+     * Adds a histogram to another one, the lock must be held
+     */
+    static void fold(Histogram& into, const Histogram& from) {
+        uint64_t n = from.count.load(std::memory_order_relaxed);
+        if (0 == n) {
+            return;
+        }
+
+        uint64_t lo = from.min.load(std::memory_order_relaxed);
+        uint64_t hi = from.max.load(std::memory_order_relaxed);
+
+        if (0 == into.count.load(std::memory_order_relaxed) || lo < into.min.load(std::memory_order_relaxed)) {
+            into.min.store(lo, std::memory_order_relaxed);
+        }
+
+        if (hi > into.max.load(std::memory_order_relaxed)) {
+            into.max.store(hi, std::memory_order_relaxed);
+        }
+
+        add(into.count, n);
+        add(into.sum, from.sum.load(std::memory_order_relaxed));
+
+        for (int i = 0; i < BUCKETS; i++) {
+            add(into.buckets[i], from.buckets[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    /**
+     * Folds the counters of an exiting thread into the retired entries and
+     * releases them
+     */
+    static void retire(Counters *self) {
+        uv_mutex_lock(&lock);
+
+        for (Counters **c = &threads; NULL != *c; c = &(*c)->next) {
+            if (*c == self) {
+                *c = self->next;
+                break;
+            }
+        }
+
+        if (retired.size() < self->size) {
+            retired.resize(self->size, NULL);
+        }
+
+        for (size_t id = 0; id < self->size; id++) {
+            Entry *entry = self->entries[id].load(std::memory_order_relaxed);
+            if (NULL == entry) {
+                continue;
+            }
+
+            if (NULL == retired[id]) {
+                retired[id] = new Entry();
+            }
+
+            add(retired[id]->calls, entry->calls.load(std::memory_order_relaxed));
+            add(retired[id]->errors, entry->errors.load(std::memory_order_relaxed));
+
+            for (int phase = 0; phase < virt::stats::PHASES; phase++) {
+                fold(retired[id]->phases[phase], entry->phases[phase]);
+            }
+
+            delete entry;
+        }
+
+        uv_mutex_unlock(&lock);
+
+        delete[] self->entries;
+        delete self;
+    }
+
+    static Entry *entryOf(const virt::stats::Binding *binding) {
+        Counters *self = counters();
+
+        if (binding->id >= self->size) {
+            return NULL;
+        }
+
+        Entry *entry = self->entries[binding->id].load(std::memory_order_relaxed);
+        if (NULL == entry) {
+            entry = new Entry();
+            self->entries[binding->id].store(entry, std::memory_order_release);
+        }
+
+        return entry;
+    }
+
+    static void trampoline(const v8::FunctionCallbackInfo<v8::Value>& args) {
+        const virt::stats::Binding *binding = static_cast<const virt::stats::Binding*>(v8::Local<v8::External>::Cast(args.Data())->Value());
+
+        if (!enabled.load(std::memory_order_relaxed)) {
+            binding->callback(args);
+            return;
+        }
+
+        v8::TryCatch tryCatch(args.GetIsolate());
+        virt::stats::Call call = { binding, uv_hrtime(), 0, NULL };
+        virt::stats::Call *outer = virt::stats::current;
+
+        virt::stats::current = &call;
+        binding->callback(args);
+        virt::stats::current = outer;
+
+        uint64_t elapsed = uv_hrtime() - call.started;
+        Entry *entry = entryOf(binding);
+
+        if (NULL != entry) {
+            add(entry->calls, 1);
+        }
+
+        if (tryCatch.HasCaught()) {
+            virt::stats::RecordError(binding);
+            tryCatch.ReThrow();
+        }
+
+        if (NULL != call.deferred) {
+            call.deferred->dispatched = elapsed;
+        } else {
+            virt::stats::Record(binding, virt::stats::LATENCY, elapsed);
+            virt::stats::Record(binding, virt::stats::V8, elapsed - call.libvirt);
+        }
+    }
+
+    static void initialize() {
+        uv_mutex_init(&lock);
+    }
+
+    static virt::stats::Binding *bind(const char *name, v8::FunctionCallback callback) {
+        std::string qualified = clazz.empty() ? name : clazz + "#" + name;
+
+        uv_once(&once, initialize);
+        uv_mutex_lock(&lock);
+
+        virt::stats::Binding *&binding = bindingsByName[qualified];
+        if (NULL == binding) {
+            binding = new virt::stats::Binding();
+            binding->callback = callback;
+            binding->name = strdup(qualified.c_str());
+            binding->id = bindings.size();
+            bindings.push_back(binding);
+        }
+
+        uv_mutex_unlock(&lock);
+
+        return binding;
+    }
+
+    /**
+     * Merges the histogram of an entry into the given one
+     */
+    static void mergeEntry(const Entry *entry, virt::stats::Phase phase, uint64_t *calls, uint64_t *errors, uint64_t *count, uint64_t *sum, uint64_t *min, uint64_t *max, uint64_t *buckets) {
+        const Histogram& h = entry->phases[phase];
+        uint64_t n = h.count.load(std::memory_order_relaxed);
+
+        if (NULL != calls) {
+            *calls += entry->calls.load(std::memory_order_relaxed);
+            *errors += entry->errors.load(std::memory_order_relaxed);
+        }
+
+        if (0 == n) {
+            return;
+        }
+
+        uint64_t lo = h.min.load(std::memory_order_relaxed);
+        uint64_t hi = h.max.load(std::memory_order_relaxed);
+
+        *min = (0 == *count || lo < *min) ? lo : *min;
+        *max = (hi > *max) ? hi : *max;
+        *count += n;
+        *sum += h.sum.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < BUCKETS; i++) {
+            buckets[i] += h.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Merges the histogram of all threads, live or exited, into the given
+     * one, the lock must be held
+     */
+    static void merge(unsigned int id, virt::stats::Phase phase, uint64_t *calls, uint64_t *errors, uint64_t *count, uint64_t *sum, uint64_t *min, uint64_t *max, uint64_t *buckets) {
+        for (Counters *c = threads; NULL != c; c = c->next) {
+            if (id >= c->size) {
+                continue;
+            }
+
+            Entry *entry = c->entries[id].load(std::memory_order_acquire);
+            if (NULL != entry) {
+                mergeEntry(entry, phase, calls, errors, count, sum, min, max, buckets);
+            }
+        }
+
+        if (id < retired.size() && NULL != retired[id]) {
+            mergeEntry(retired[id], phase, calls, errors, count, sum, min, max, buckets);
+        }
+    }
+
+    static double percentile(const uint64_t *buckets, uint64_t count, uint64_t max, double q) {
+        uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+        uint64_t seen = 0;
+
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+
+            if (seen >= rank && seen > 0) {
+                uint64_t highest = highestOf(i);
+                return ((highest < max) ? highest : max) / 1e3;
+            }
+        }
+
+        return max / 1e3;
+    }
+
+    /**
+     * Converts the histogram to JS, the times are in microseconds
+     */
+    static v8::Local<v8::Object> histogram(v8::Isolate *isolate, uint64_t count, uint64_t sum, uint64_t min, uint64_t max, const uint64_t *buckets) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+
+        result->Set(v8::String::NewFromUtf8(isolate, "count"), v8::Number::New(isolate, count));
+        result->Set(v8::String::NewFromUtf8(isolate, "mean"),  v8::Number::New(isolate, (0 == count) ? 0 : sum / 1e3 / count));
+        result->Set(v8::String::NewFromUtf8(isolate, "min"),   v8::Number::New(isolate, min / 1e3));
+        result->Set(v8::String::NewFromUtf8(isolate, "max"),   v8::Number::New(isolate, max / 1e3));
+        result->Set(v8::String::NewFromUtf8(isolate, "p50"),   v8::Number::New(isolate, percentile(buckets, count, max, 0.5)));
+        result->Set(v8::String::NewFromUtf8(isolate, "p90"),   v8::Number::New(isolate, percentile(buckets, count, max, 0.9)));
+        result->Set(v8::String::NewFromUtf8(isolate, "p99"),   v8::Number::New(isolate, percentile(buckets, count, max, 0.99)));
+        result->Set(v8::String::NewFromUtf8(isolate, "p999"),  v8::Number::New(isolate, percentile(buckets, count, max, 0.999)));
+
+        return result;
+    }
+
+} // namespace
+
+namespace virt {
+    namespace stats {
+
+        thread_local Call *current = NULL;
+
+        void SetClass(const char *name) {
+            clazz = (NULL == name) ? "" : name;
+        }
+
+        void SetMethod(v8::Local<v8::Object> recv, const char *name, v8::FunctionCallback callback) {
+            v8::Isolate *isolate = v8::Isolate::GetCurrent();
+            v8::HandleScope scope(isolate);
+            v8::Local<v8::External> data = v8::External::New(isolate, bind(name, callback));
+            v8::Local<v8::Function> fn = v8::FunctionTemplate::New(isolate, trampoline, data)->GetFunction();
+            v8::Local<v8::String> fnName = v8::String::NewFromUtf8(isolate, name);
+
+            fn->SetName(fnName);
+            recv->Set(fnName, fn);
+        }
+
+        void SetPrototypeMethod(v8::Local<v8::FunctionTemplate> tpl, const char *name, v8::FunctionCallback callback) {
+            v8::Isolate *isolate = v8::Isolate::GetCurrent();
+            v8::HandleScope scope(isolate);
+            v8::Local<v8::External> data = v8::External::New(isolate, bind(name, callback));
+            v8::Local<v8::Signature> signature = v8::Signature::New(isolate, tpl);
+            v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New(isolate, trampoline, data, signature);
+            v8::Local<v8::String> fnName = v8::String::NewFromUtf8(isolate, name);
+
+            t->SetClassName(fnName);
+            tpl->PrototypeTemplate()->Set(fnName, t);
+        }
+
+        void Record(const Binding *binding, Phase phase, uint64_t ns) {
+            Entry *entry = entryOf(binding);
+
+            if (NULL == entry) {
+                return;
+            }
+
+            Histogram& h = entry->phases[phase];
+            uint64_t count = h.count.load(std::memory_order_relaxed);
+
+            if (0 == count || ns < h.min.load(std::memory_order_relaxed)) {
+                h.min.store(ns, std::memory_order_relaxed);
+            }
+
+            if (ns > h.max.load(std::memory_order_relaxed)) {
+                h.max.store(ns, std::memory_order_relaxed);
+            }
+
+            add(h.sum, ns);
+            add(h.buckets[bucketOf(ns)], 1);
+            h.count.store(count + 1, std::memory_order_relaxed);
+        }
+
+        void RecordError(const Binding *binding) {
+            Entry *entry = entryOf(binding);
+
+            if (NULL != entry) {
+                add(entry->errors, 1);
+            }
+        }
+
+        void Complete(const Sample *sample, uint64_t converted, bool failed) {
+            Record(sample->binding, V8, sample->dispatched + converted);
+            Record(sample->binding, LATENCY, uv_hrtime() - sample->started);
+
+            if (failed) {
+                RecordError(sample->binding);
+            }
+        }
+
+    } // namespace stats
+} // namespace virt
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static void __setInstrumentation(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Boolean);
+
+    args.GetReturnValue().Set(enabled.exchange(args[0]->BooleanValue(), std::memory_order_relaxed));
+}
+
+static void __getStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+    v8::Local<v8::Object> result = v8::Object::New(isolate);
+    static const char *names[] = { "latency", "libvirt", "v8" };
+    uint64_t buckets[virt::stats::PHASES][BUCKETS];
+
+    uv_mutex_lock(&lock);
+    std::vector<virt::stats::Binding*> snapshot(bindings);
+    uv_mutex_unlock(&lock);
+
+    for (size_t i = 0; i < snapshot.size(); i++) {
+        uint64_t calls = 0, errors = 0;
+        uint64_t count[virt::stats::PHASES] = { 0 }, sum[virt::stats::PHASES] = { 0 };
+        uint64_t min[virt::stats::PHASES] = { 0 }, max[virt::stats::PHASES] = { 0 };
+
+        memset(buckets, 0, sizeof(buckets));
+
+        // keeps exiting threads from releasing their counters meanwhile
+        uv_mutex_lock(&lock);
+        for (int phase = 0; phase < virt::stats::PHASES; phase++) {
+            merge(i, static_cast<virt::stats::Phase>(phase), (0 == phase) ? &calls : NULL, &errors, &count[phase], &sum[phase], &min[phase], &max[phase], buckets[phase]);
+        }
+        uv_mutex_unlock(&lock);
+
+        if (0 == calls) {
+            continue;
+        }
+
+        v8::Local<v8::Object> stats = v8::Object::New(isolate);
+
+        for (int phase = 0; phase < virt::stats::PHASES; phase++) {
+            if (count[phase] > 0) {
+                stats->Set(v8::String::NewFromUtf8(isolate, names[phase]), histogram(isolate, count[phase], sum[phase], min[phase], max[phase], buckets[phase]));
+            }
+        }
+
+        stats->Set(v8::String::NewFromUtf8(isolate, "calls"), v8::Number::New(isolate, calls));
+        stats->Set(v8::String::NewFromUtf8(isolate, "errors"), v8::Number::New(isolate, errors));
+        result->Set(v8::String::NewFromUtf8(isolate, snapshot[i]->name), stats);
+    }
+
+    args.GetReturnValue().Set(result);
+}
+
+/**
+ * Clears the counters of all threads, samples recorded at the same time
+ * may get lost
+ */
+static void __resetStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    uv_mutex_lock(&lock);
+
+    for (size_t i = 0; i < retired.size(); i++) {
+        delete retired[i];
+        retired[i] = NULL;
+    }
+
+    for (Counters *c = threads; NULL != c; c = c->next) {
+        for (size_t i = 0; i < c->size; i++) {
+            Entry *entry = c->entries[i].load(std::memory_order_acquire);
+
+            if (NULL == entry) {
+                continue;
+            }
+
+            entry->calls.store(0, std::memory_order_relaxed);
+            entry->errors.store(0, std::memory_order_relaxed);
+
+            for (int phase = 0; phase < virt::stats::PHASES; phase++) {
+                Histogram& h = entry->phases[phase];
+
+                h.count.store(0, std::memory_order_relaxed);
+                h.sum.store(0, std::memory_order_relaxed);
+                h.min.store(0, std::memory_order_relaxed);
+                h.max.store(0, std::memory_order_relaxed);
+
+                for (int j = 0; j < BUCKETS; j++) {
+                    h.buckets[j].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    uv_mutex_unlock(&lock);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace virt {
+    namespace stats {
+
+        void exports(v8::Handle<v8::Object> exports) {
+            NODE_SET_METHOD(exports, "setInstrumentation",                  __setInstrumentation);
+            NODE_SET_METHOD(exports, "getStats",                            __getStats);
+            NODE_SET_METHOD(exports, "resetStats",                          __resetStats);
+        }
+
+    } // namespace stats
+} // namespace virt
@@ -0,0 +1,130 @@
+#ifndef __NODE_VIRT_STATS_H__
+#define __NODE_VIRT_STATS_H__
+
+// standard c
+#include <stdint.h>
+
+// standard c++
+#include <atomic>
+
+// node
+#include <node.h>
+
+/**
+ * Same as NODE_SET_METHOD, but the function is counted by the
+ * instrumentation while it is enabled
+ */
+#define VIRT_SET_METHOD(recv, name, callback) \
+    virt::stats::SetMethod((recv), (name), (callback))
+
+/**
+ * Same as NODE_SET_PROTOTYPE_METHOD, but the method is counted by the
+ * instrumentation while it is enabled
+ */
+#define VIRT_SET_PROTOTYPE_METHOD(tpl, name, callback) \
+    virt::stats::SetPrototypeMethod((tpl), (name), (callback))
+
+namespace virt {
+
+    namespace stats {
+
+        /**
+         * The phases the time of a call is split into: the whole call as seen
+         * by JS (until the callback for asynchronous calls), the libvirt call
+         * made by its worker, and the conversion between V8 and C
+         */
+        enum Phase {
+            LATENCY = 0,
+            LIBVIRT,
+            V8,
+            PHASES
+        };
+
+        /**
+         * A native function exported to JS
+         */
+        struct Binding {
+            v8::FunctionCallback callback;
+            char *name;
+            unsigned int id;
+        };
+
+        /**
+         * Timing of a call which completes later, e.g. by a queued worker
+         */
+        struct Sample {
+            // NULL if the call is not instrumented
+            const Binding *binding;
+            uint64_t started;
+            // time spent in the native function itself
+            uint64_t dispatched;
+            // time spent in libvirt
+            uint64_t executed;
+        };
+
+        /**
+         * The native call in progress on the main thread
+         */
+        struct Call {
+            const Binding *binding;
+            uint64_t started;
+            // time spent in libvirt by synchronous workers
+            uint64_t libvirt;
+            // set when the call completes later
+            Sample *deferred;
+        };
+
+        extern thread_local Call *current;
+
+        /**
+         * Returns the call in progress, NULL while the instrumentation is
+         * disabled; main thread only
+         */
+        inline Call *Current() { return current; }
+
+        /**
+         * Starts the sample of a call which completes later
+         */
+        inline void Defer(Sample *sample) {
+            if (NULL != current) {
+                sample->binding = current->binding;
+                sample->started = current->started;
+                sample->dispatched = 0;
+                current->deferred = sample;
+            }
+        }
+
+        /**
+         * Records the completion of a deferred call, <code>converted</code>
+         * is the time it took to build the result
+         */
+        void Complete(const Sample *sample, uint64_t converted, bool failed);
+
+        /**
+         * Prefixes the prototype methods registered until the next call with
+         * the class name, NULL for module functions
+         */
+        void SetClass(const char *clazz);
+
+        void SetMethod(v8::Local<v8::Object> recv, const char *name, v8::FunctionCallback callback);
+
+        void SetPrototypeMethod(v8::Local<v8::FunctionTemplate> tpl, const char *name, v8::FunctionCallback callback);
+
+        /**
+         * Adds a sample to the counters of the calling thread, lock free and
+         * may be called from any thread
+         */
+        void Record(const Binding *binding, Phase phase, uint64_t ns);
+
+        void RecordError(const Binding *binding);
+
+        /**
+         * Exports <code>setInstrumentation</code>, <code>getStats</code> and
+         * <code>resetStats</code>
+         */
+        void exports(v8::Handle<v8::Object> exports);
+
+    } // namespace stats
+} // namespace virt
+
+#endif /* __NODE_VIRT_STATS_H__ */
@@ -1,14 +1,638 @@
 // standard c
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
+// standard c++
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "virt-host.h"
 #include "virt-storage.h"
+#include "virt-worker.h"
+
+/**
+ * Volumes are transferred between libvirt and a local file on a worker
+ * thread with a blocking stream. With sparse streams, holes of the volume
+ * are skipped in the file instead of being written as zeros, and holes of
+ * the file are sent as hole markers instead of data.
+ */
+
+struct VolumeTransfer {
+    int fd;
+    // bytes left to send, or -1 for everything up to the end of the file
+    long long remaining;
+    unsigned long long data;
+    unsigned long long holes;
+    // errno of the failed file operation
+    int error;
+};
+
+static inline void consume(VolumeTransfer *t, long long n) {
+    if (t->remaining >= 0) {
+        t->remaining -= n;
+    }
+}
+
+static inline long long clamp(VolumeTransfer *t, long long n) {
+    return t->remaining >= 0 && n > t->remaining ? t->remaining : n;
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+static int onSinkData(virStreamPtr st, const char *data, size_t nbytes, void *opaque) {
+    VolumeTransfer *t = static_cast<VolumeTransfer*>(opaque);
+    size_t done = 0;
+
+    while (done < nbytes) {
+        ssize_t n = write(t->fd, data + done, nbytes - done);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+
+            t->error = errno;
+            return -1;
+        }
+
+        done += n;
+    }
+
+    t->data += nbytes;
+    return nbytes;
+}
+
+static int onSinkHole(virStreamPtr st, long long length, void *opaque) {
+    VolumeTransfer *t = static_cast<VolumeTransfer*>(opaque);
+
+    // the file is truncated, so seeking leaves the range unallocated
+    if (lseek(t->fd, length, SEEK_CUR) < 0) {
+        t->error = errno;
+        return -1;
+    }
+
+    t->holes += length;
+    return 0;
+}
+
+static int onSourceData(virStreamPtr st, char *data, size_t nbytes, void *opaque) {
+    VolumeTransfer *t = static_cast<VolumeTransfer*>(opaque);
+    ssize_t n;
+
+    do {
+        n = read(t->fd, data, clamp(t, nbytes));
+    } while (n < 0 && EINTR == errno);
+
+    if (n < 0) {
+        t->error = errno;
+        return -1;
+    }
+
+    t->data += n;
+    consume(t, n);
+    return n;
+}
+
+/**
+ * Tells whether the file position is in data or in a hole, and how long
+ * that section is
+ */
+static int onSourceHole(virStreamPtr st, int *inData, long long *length, void *opaque) {
+    VolumeTransfer *t = static_cast<VolumeTransfer*>(opaque);
+    off_t cur = lseek(t->fd, 0, SEEK_CUR);
+
+    if (cur < 0) {
+        t->error = errno;
+        return -1;
+    }
+
+    *inData = 1;
+    *length = std::numeric_limits<long long>::max();
+
+#ifdef SEEK_DATA
+    off_t data = lseek(t->fd, cur, SEEK_DATA);
+
+    if (data < 0 && ENXIO == errno) {
+        // in the trailing hole
+        off_t end = lseek(t->fd, 0, SEEK_END);
+        *inData = 0;
+        *length = end - cur;
+    } else if (data > cur) {
+        *inData = 0;
+        *length = data - cur;
+    } else if (data == cur) {
+        off_t hole = lseek(t->fd, cur, SEEK_HOLE);
+        if (hole > cur) {
+            *length = hole - cur;
+        }
+    }
+#endif
+
+    // holes are not supported by the file system or the file, send it all
+    if (*inData && std::numeric_limits<long long>::max() == *length) {
+        off_t end = lseek(t->fd, 0, SEEK_END);
+        if (end >= cur) {
+            *length = end - cur;
+        }
+    }
+
+    if (lseek(t->fd, cur, SEEK_SET) < 0) {
+        t->error = errno;
+        return -1;
+    }
+
+    *length = clamp(t, *length);
+
+    // a zero length data section ends the transfer
+    if (0 == *length) {
+        *inData = 1;
+    }
+
+    return 0;
+}
+
+static int onSourceSkip(virStreamPtr st, long long length, void *opaque) {
+    VolumeTransfer *t = static_cast<VolumeTransfer*>(opaque);
+
+    if (lseek(t->fd, length, SEEK_CUR) < 0) {
+        t->error = errno;
+        return -1;
+    }
+
+    t->holes += length;
+    consume(t, length);
+    return 0;
+}
+
+/**
+ * Worker of virStorageVolDownload and virStorageVolUpload, transfers the
+ * volume from or to a local file
+ */
+class VolumeTransferWorker : public virt::Worker {
+public:
+    inline VolumeTransferWorker(virStorageVolPtr vol, const char *path, bool upload,
+            unsigned long long offset, unsigned long long length, unsigned int flags)
+        : vol(vol), path(path), upload(upload), offset(offset), length(length), flags(flags) {}
+
+    virtual void Execute() {
+        VolumeTransfer t;
+        t.fd = open(this->path.c_str(), this->upload ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        t.remaining = this->upload && this->length > 0 ? static_cast<long long>(this->length) : -1;
+        t.data = 0;
+        t.holes = 0;
+        t.error = 0;
+
+        if (t.fd < 0) {
+            this->SetError(strerror(errno));
+            return;
+        }
+
+        virStreamPtr st = virStreamNew(virStorageVolGetConnect(this->vol), 0);
+        if (NULL == st) {
+            this->SetVirtError();
+            close(t.fd);
+            return;
+        }
+
+        if (this->upload ? 0 == this->Upload(st, &t) : 0 == this->Download(st, &t)) {
+            if (0 != virStreamFinish(st)) {
+                this->SetVirtError();
+            }
+        } else if (0 != t.error) {
+            this->SetError(strerror(t.error));
+        } else {
+            this->SetVirtError();
+        }
+
+        virStreamFree(st);
+
+        if (0 != close(t.fd) && !this->HasError()) {
+            this->SetError(strerror(errno));
+        }
+
+        this->data = t.data;
+        this->holes = t.holes;
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        result->Set(v8::String::NewFromUtf8(isolate, "data"), v8::Number::New(isolate, this->data));
+        result->Set(v8::String::NewFromUtf8(isolate, "holes"), v8::Number::New(isolate, this->holes));
+        return result;
+    }
+
+private:
+
+    int Download(virStreamPtr st, VolumeTransfer *t) {
+#if LIBVIR_CHECK_VERSION(3, 4, 0)
+        unsigned int sparse = VIR_STORAGE_VOL_DOWNLOAD_SPARSE_STREAM;
+        int result = virStorageVolDownload(this->vol, st, this->offset, this->length, this->flags | sparse);
+
+        if (0 != result && this->IsSparseUnsupported(sparse)) {
+            sparse = 0;
+            result = virStorageVolDownload(this->vol, st, this->offset, this->length, this->flags);
+        }
+
+        if (0 != result) {
+            return -1;
+        }
+
+        if (0 != (sparse ? virStreamSparseRecvAll(st, onSinkData, onSinkHole, t) : virStreamRecvAll(st, onSinkData, t))) {
+            return -1;
+        }
+#else
+        if (0 != virStorageVolDownload(this->vol, st, this->offset, this->length, this->flags)) {
+            return -1;
+        }
+
+        if (0 != virStreamRecvAll(st, onSinkData, t)) {
+            return -1;
+        }
+#endif
+
+        // a trailing hole only moved the position, make it part of the file
+        struct stat sb;
+        off_t size = lseek(t->fd, 0, SEEK_CUR);
+
+        if (0 == fstat(t->fd, &sb) && S_ISREG(sb.st_mode) && size > sb.st_size && 0 != ftruncate(t->fd, size)) {
+            t->error = errno;
+            virStreamAbort(st);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    int Upload(virStreamPtr st, VolumeTransfer *t) {
+#if LIBVIR_CHECK_VERSION(3, 4, 0)
+        unsigned int sparse = VIR_STORAGE_VOL_UPLOAD_SPARSE_STREAM;
+        int result = virStorageVolUpload(this->vol, st, this->offset, this->length, this->flags | sparse);
+
+        if (0 != result && this->IsSparseUnsupported(sparse)) {
+            sparse = 0;
+            result = virStorageVolUpload(this->vol, st, this->offset, this->length, this->flags);
+        }
+
+        if (0 != result) {
+            return -1;
+        }
+
+        return sparse ? virStreamSparseSendAll(st, onSourceData, onSourceHole, onSourceSkip, t) : virStreamSendAll(st, onSourceData, t);
+#else
+        if (0 != virStorageVolUpload(this->vol, st, this->offset, this->length, this->flags)) {
+            return -1;
+        }
+
+        return virStreamSendAll(st, onSourceData, t);
+#endif
+    }
+
+    /**
+     * Whether the transfer failed because the driver or an older daemon
+     * does not know the sparse flag, unless the caller asked for it
+     */
+    bool IsSparseUnsupported(unsigned int sparse) const {
+        virErrorPtr err = virGetLastError();
+
+        if (0 != (this->flags & sparse) || NULL == err) {
+            return false;
+        }
+
+        return VIR_ERR_NO_SUPPORT == err->code || VIR_ERR_INVALID_ARG == err->code;
+    }
+
+    virt::Reference<virStorageVolPtr> vol;
+    std::string path;
+    bool upload;
+    unsigned long long offset;
+    unsigned long long length;
+    unsigned int flags;
+    unsigned long long data;
+    unsigned long long holes;
+};
+
+/**
+ * Worker of the virStorageVolLookupBy* functions
+ */
+class LookupVolumeWorker : public virt::Worker {
+public:
+    typedef virStorageVolPtr (*Lookup)(virConnectPtr conn, const char *s);
+
+    inline LookupVolumeWorker(virConnectPtr conn, Lookup lookup, const char *s)
+        : conn(conn), lookup(lookup), s(s), vol(NULL) {}
+
+    virtual ~LookupVolumeWorker() {
+        if (NULL != this->vol) {
+            virStorageVolFree(this->vol);
+        }
+    }
+
+    virtual void Execute() {
+        if (NULL == (this->vol = this->lookup(this->conn, this->s.c_str()))) {
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        virStorageVolPtr vol = this->vol;
+        this->vol = NULL;
+        return virt::storage::StorageVolume::NewInstance<virt::storage::StorageVolume>(vol);
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    Lookup lookup;
+    std::string s;
+    virStorageVolPtr vol;
+};
+
+static void lookupVolume(const v8::FunctionCallbackInfo<v8::Value>& args, LookupVolumeWorker::Lookup lookup) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    v8::String::Utf8Value s(args[0]->ToString());
+    virt::Worker::Run(args, new LookupVolumeWorker(**native, lookup, *s), native->GetExecutor());
+}
+
+static void __virStorageVolLookupByKey(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    lookupVolume(args, virStorageVolLookupByKey);
+}
+
+static void __virStorageVolLookupByPath(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    lookupVolume(args, virStorageVolLookupByPath);
+}
+
+static void transferVolume(const v8::FunctionCallbackInfo<v8::Value>& args, bool upload) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], String);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::storage::StorageVolume *native = node::ObjectWrap::Unwrap<virt::storage::StorageVolume>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    v8::String::Utf8Value path(args[0]->ToString());
+    unsigned long long offset = args.Length() > 1 && args[1]->IsNumber() ? args[1]->IntegerValue() : 0;
+    unsigned long long length = args.Length() > 2 && args[2]->IsNumber() ? args[2]->IntegerValue() : 0;
+    unsigned int flags = args.Length() > 3 && args[3]->IsUint32() ? args[3]->Uint32Value() : 0;
+
+    // transfers take long, keep them off the dedicated thread of the connection
+    virt::Worker::Run(args, new VolumeTransferWorker(**native, *path, upload, offset, length, flags));
+}
+
+static void __virStorageVolDownload(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    transferVolume(args, false);
+}
+
+static void __virStorageVolUpload(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    transferVolume(args, true);
+}
+
+/**
+ * Worker of virConnectListAllStoragePools
+ */
+class ListAllStoragePoolsWorker : public virt::Worker {
+public:
+    inline ListAllStoragePoolsWorker(virConnectPtr conn, unsigned int flags)
+        : conn(conn), flags(flags), pools(NULL), npools(0) {}
+
+    virtual ~ListAllStoragePoolsWorker() {
+        for (int i = 0; i < this->npools; i++) {
+            if (NULL != this->pools[i]) {
+                virStoragePoolFree(this->pools[i]);
+            }
+        }
+
+        free(this->pools);
+    }
+
+    virtual void Execute() {
+        if (-1 == (this->npools = virConnectListAllStoragePools(this->conn, &this->pools, this->flags))) {
+            this->npools = 0;
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Array> result = v8::Array::New(isolate, this->npools);
+        v8::Local<v8::String> kPool = v8::String::NewFromUtf8(isolate, "pool");
+        v8::Local<v8::String> kName = v8::String::NewFromUtf8(isolate, "name");
+        v8::Local<v8::String> kUUID = v8::String::NewFromUtf8(isolate, "uuid");
+
+        for (int i = 0; i < this->npools; i++) {
+            virStoragePoolPtr pool = this->pools[i];
+            v8::Local<v8::Object> obj = v8::Object::New(isolate);
+            const char *name = virStoragePoolGetName(pool);
+            char uuid[VIR_UUID_STRING_BUFLEN];
+
+            if (0 != virStoragePoolGetUUIDString(pool, uuid)) {
+                uuid[0] = '\0';
+            }
+
+            obj->Set(kName, v8::String::NewFromUtf8(isolate, NULL == name ? "" : name));
+            obj->Set(kUUID, v8::String::NewFromUtf8(isolate, uuid));
+
+            // the wrapper takes over the reference
+            obj->Set(kPool, virt::storage::StoragePool::NewInstance<virt::storage::StoragePool>(pool));
+            this->pools[i] = NULL;
+
+            result->Set(i, obj);
+        }
+
+        return result;
+    }
+
+private:
+    virt::Reference<virConnectPtr> conn;
+    unsigned int flags;
+    virStoragePoolPtr *pools;
+    int npools;
+};
+
+static void __virConnectListAllStoragePools(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new ListAllStoragePoolsWorker(**native, flags), native->GetExecutor());
+}
+
+/**
+ * Worker of virStoragePoolListAllVolumes
+ */
+class ListAllVolumesWorker : public virt::Worker {
+public:
+    inline ListAllVolumesWorker(virStoragePoolPtr pool, unsigned int flags)
+        : pool(pool), flags(flags), vols(NULL), nvols(0) {}
+
+    virtual ~ListAllVolumesWorker() {
+        for (int i = 0; i < this->nvols; i++) {
+            if (NULL != this->vols[i]) {
+                virStorageVolFree(this->vols[i]);
+            }
+        }
+
+        free(this->vols);
+    }
+
+    virtual void Execute() {
+        if (-1 == (this->nvols = virStoragePoolListAllVolumes(this->pool, &this->vols, this->flags))) {
+            this->nvols = 0;
+            this->SetVirtError();
+        }
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        v8::Local<v8::Array> result = v8::Array::New(isolate, this->nvols);
+        v8::Local<v8::String> kVolume = v8::String::NewFromUtf8(isolate, "volume");
+        v8::Local<v8::String> kName = v8::String::NewFromUtf8(isolate, "name");
+        v8::Local<v8::String> kKey = v8::String::NewFromUtf8(isolate, "key");
+
+        for (int i = 0; i < this->nvols; i++) {
+            virStorageVolPtr vol = this->vols[i];
+            v8::Local<v8::Object> obj = v8::Object::New(isolate);
+            const char *name = virStorageVolGetName(vol);
+            const char *key = virStorageVolGetKey(vol);
+
+            obj->Set(kName, v8::String::NewFromUtf8(isolate, NULL == name ? "" : name));
+            obj->Set(kKey, v8::String::NewFromUtf8(isolate, NULL == key ? "" : key));
+
+            // the wrapper takes over the reference
+            obj->Set(kVolume, virt::storage::StorageVolume::NewInstance<virt::storage::StorageVolume>(vol));
+            this->vols[i] = NULL;
+
+            result->Set(i, obj);
+        }
+
+        return result;
+    }
+
+private:
+    virt::Reference<virStoragePoolPtr> pool;
+    unsigned int flags;
+    virStorageVolPtr *vols;
+    int nvols;
+};
+
+static void __virStoragePoolListAllVolumes(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::storage::StoragePool *native = node::ObjectWrap::Unwrap<virt::storage::StoragePool>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virt::Worker::Run(args, new ListAllVolumesWorker(**native, flags));
+}
+
+/**
+ * Lists the volumes of a pool and gets the info of every volume in one
+ * go, the info is laid out as one column per field in a single buffer.
+ * Volumes which vanish while the inventory is taken are skipped.
+ */
+class VolumeInventoryWorker : public virt::Worker {
+public:
+    inline VolumeInventoryWorker(virStoragePoolPtr pool) : pool(pool) {}
+
+    virtual void Execute() {
+        virStorageVolPtr *vols = NULL;
+        int n = virStoragePoolListAllVolumes(this->pool, &vols, 0);
+
+        if (n < 0) {
+            this->SetVirtError();
+            return;
+        }
+
+        this->capacity.reserve(n);
+        this->allocation.reserve(n);
+        this->type.reserve(n);
+
+        for (int i = 0; i < n; i++) {
+            virStorageVolInfo info;
+
+            if (0 == virStorageVolGetInfo(vols[i], &info)) {
+                const char *name = virStorageVolGetName(vols[i]);
+                const char *key = virStorageVolGetKey(vols[i]);
+
+                this->names.push_back(NULL == name ? "" : name);
+                this->keys.push_back(NULL == key ? "" : key);
+                this->capacity.push_back(info.capacity);
+                this->allocation.push_back(info.allocation);
+                this->type.push_back(info.type);
+            }
+
+            virStorageVolFree(vols[i]);
+        }
+
+        free(vols);
+    }
+
+    virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+        size_t n = this->names.size();
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        v8::Local<v8::Array> names = v8::Array::New(isolate, n);
+        v8::Local<v8::Array> keys = v8::Array::New(isolate, n);
+        v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, n * (2 * sizeof(double) + sizeof(int32_t)));
+        char *data = static_cast<char*>(buffer->GetContents().Data());
+
+        for (size_t i = 0; i < n; i++) {
+            names->Set(i, v8::String::NewFromUtf8(isolate, this->names[i].c_str()));
+            keys->Set(i, v8::String::NewFromUtf8(isolate, this->keys[i].c_str()));
+        }
+
+        if (n > 0) {
+            memcpy(data, &this->capacity[0], n * sizeof(double));
+            memcpy(data + n * sizeof(double), &this->allocation[0], n * sizeof(double));
+            memcpy(data + 2 * n * sizeof(double), &this->type[0], n * sizeof(int32_t));
+        }
+
+        result->Set(v8::String::NewFromUtf8(isolate, "names"), names);
+        result->Set(v8::String::NewFromUtf8(isolate, "keys"), keys);
+        result->Set(v8::String::NewFromUtf8(isolate, "capacity"), v8::Float64Array::New(buffer, 0, n));
+        result->Set(v8::String::NewFromUtf8(isolate, "allocation"), v8::Float64Array::New(buffer, n * sizeof(double), n));
+        result->Set(v8::String::NewFromUtf8(isolate, "type"), v8::Int32Array::New(buffer, 2 * n * sizeof(double), n));
+        return result;
+    }
+
+private:
+    virt::Reference<virStoragePoolPtr> pool;
+    std::vector<std::string> names;
+    std::vector<std::string> keys;
+    std::vector<double> capacity;
+    std::vector<double> allocation;
+    std::vector<int32_t> type;
+};
+
+static void __getVolumeInventory(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::storage::StoragePool *native = node::ObjectWrap::Unwrap<virt::storage::StoragePool>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::Worker::Run(args, new VolumeInventoryWorker(**native));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,12 +640,28 @@ extern "C" {
 namespace virt {
     namespace storage {
 
-        v8::Persistent<v8::Function> StoragePool::constructor;
+        void prototype(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "listAllStoragePools",           __virConnectListAllStoragePools);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "lookupStorageVolumeByKey",      __virStorageVolLookupByKey);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "lookupStorageVolumeByPath",     __virStorageVolLookupByPath);
+        }
+
+        static void poolMethods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          StoragePool::Free<StoragePool>);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "listAllVolumes",                __virStoragePoolListAllVolumes);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "getVolumeInventory",            __getVolumeInventory);
+        }
+
+        static void volumeMethods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          StorageVolume::Free<StorageVolume>);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "download",                      __virStorageVolDownload);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "upload",                        __virStorageVolUpload);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            StoragePool::Export<StoragePool>(exports, "StoragePool");
+            StoragePool::Export<StoragePool>(exports, "StoragePool", poolMethods);
+            StorageVolume::Export<StorageVolume>(exports, "StorageVolume", volumeMethods);
         }
 
     } // namespace storage
 } // namespace virt
-
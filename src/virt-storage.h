@@ -8,20 +8,32 @@
 
 template class Pointer<virStoragePoolPtr>;
 
+template class Pointer<virStorageVolPtr>;
+
 namespace virt {
     namespace storage {
 
         void exports(v8::Handle<v8::Object> exports);
 
+        /**
+         * Installs the storage related methods onto the Connection prototype
+         */
+        void prototype(v8::Local<v8::FunctionTemplate> tpl);
+
         class StoragePool : public Pointer<virStoragePoolPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline StoragePool(virStoragePoolPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virStoragePoolPtr>;
         };
 
+        class StorageVolume : public Pointer<virStorageVolPtr> {
+        private:
+            inline StorageVolume(virStorageVolPtr ptr) : Pointer(ptr) {}
+
+            friend class Pointer<virStorageVolPtr>;
+        };
+
     } // namespace storage
 } // namespace virt
 
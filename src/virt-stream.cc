@@ -9,12 +9,238 @@
 #include <stdlib.h>
 #include <string.h>
 
+// node
+#include <node_buffer.h>
+
+#include "virt-event.h"
+#include "virt-host.h"
 #include "virt-stream.h"
+#include "virt-worker.h"
+
+/**
+ * Streams are always non-blocking. Data is received into and sent from the
+ * memory of the JS Buffers directly, and readiness is reported by the
+ * libvirt event loop which runs on the libuv loop (see virt-event.cc), so
+ * none of the transfers below ever blocks the loop. Finishing or aborting
+ * waits for the other end to confirm, so they run on a worker thread.
+ */
+
+struct StreamCallback {
+    v8::Persistent<v8::Function> callback;
+};
+
+/**
+ * Returns the memory of the buffer at offset, or NULL if the buffer or the
+ * range is invalid
+ */
+static char *bufferRange(const v8::FunctionCallbackInfo<v8::Value>& args, size_t *length) {
+    if (args.Length() < 1 || !node::Buffer::HasInstance(args[0])) {
+        return NULL;
+    }
+
+    v8::Local<v8::Object> buffer = v8::Local<v8::Object>::Cast(args[0]);
+    size_t size = node::Buffer::Length(buffer);
+    size_t offset = args.Length() > 1 && args[1]->IsUint32() ? args[1]->Uint32Value() : 0;
+
+    if (offset > size) {
+        return NULL;
+    }
+
+    *length = args.Length() > 2 && args[2]->IsUint32() ? args[2]->Uint32Value() : size - offset;
+
+    if (*length > size - offset) {
+        return NULL;
+    }
+
+    return node::Buffer::Data(buffer) + offset;
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Worker of virStreamFinish and virStreamAbort
+ */
+class EndStreamWorker : public virt::Worker {
+public:
+    typedef int (*End)(virStreamPtr st);
+
+    inline EndStreamWorker(virStreamPtr st, End end) : st(st), end(end) {}
+
+    virtual void Execute() {
+        if (0 != this->end(this->st)) {
+            this->SetVirtError();
+        }
+    }
+
+private:
+    virt::Reference<virStreamPtr> st;
+    End end;
+};
+
+static void onStreamEvent(virStreamPtr st, int events, void *opaque) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+    StreamCallback *sc = static_cast<StreamCallback*>(opaque);
+
+    v8::Local<v8::Function> cb = v8::Local<v8::Function>::New(isolate, sc->callback);
+    v8::Local<v8::Value> argv[] = { v8::Integer::New(isolate, events) };
+    node::MakeCallback(isolate, isolate->GetCurrentContext()->Global(), cb, 1, argv);
+}
+
+static void onStreamCallbackReleased(void *opaque) {
+    StreamCallback *sc = static_cast<StreamCallback*>(opaque);
+    sc->callback.Reset();
+    delete sc;
+}
+
+static void __virStreamNew(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::host::Connection *native = node::ObjectWrap::Unwrap<virt::host::Connection>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    unsigned int flags = args.Length() > 0 && args[0]->IsUint32() ? args[0]->Uint32Value() : 0;
+    virStreamPtr st = virStreamNew(**native, flags | VIR_STREAM_NONBLOCK);
+    if (NULL == st) {
+        virt::throwVirtError(isolate);
+        return;
+    }
+
+    virt::stream::Stream::NewInstance<virt::stream::Stream>(st, args);
+}
+
+static void __virStreamRecv(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    size_t length = 0;
+    char *data = bufferRange(args, &length);
+    if (NULL == data) {
+        virt::throwTypeError(isolate, "Invalid arguments");
+        return;
+    }
+
+    // -2 means no data is available yet
+    int n = virStreamRecv(**native, data, length);
+    if (-1 == n) {
+        virt::throwVirtError(isolate);
+        return;
+    }
+
+    args.GetReturnValue().Set(v8::Integer::New(isolate, n));
+}
+
+static void __virStreamSend(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    size_t length = 0;
+    const char *data = bufferRange(args, &length);
+    if (NULL == data) {
+        virt::throwTypeError(isolate, "Invalid arguments");
+        return;
+    }
+
+    // -2 means the outgoing buffer is full
+    int n = virStreamSend(**native, data, length);
+    if (-1 == n) {
+        virt::throwVirtError(isolate);
+        return;
+    }
+
+    args.GetReturnValue().Set(v8::Integer::New(isolate, n));
+}
+
+static void __virStreamEventAddCallback(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 2);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    CHK_ARGUMENT_TYPE(isolate, args[1], Function);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    // libvirt invokes the callback right on its event loop
+    if (!virt::event::IsLoopThread()) {
+        virt::throwError(isolate, "Stream events are only available on the main thread");
+        return;
+    }
+
+    StreamCallback *sc = new StreamCallback();
+    sc->callback.Reset(isolate, v8::Local<v8::Function>::Cast(args[1]));
+
+    if (0 != virStreamEventAddCallback(**native, args[0]->Int32Value(), onStreamEvent, sc, onStreamCallbackReleased)) {
+        onStreamCallbackReleased(sc);
+        virt::throwVirtError(isolate);
+    }
+}
+
+static void __virStreamEventUpdateCallback(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    CHK_NATIVE_CLASS_FUNCTION_ARGUMENTS(args, isolate, 1);
+    CHK_ARGUMENT_TYPE(isolate, args[0], Int32);
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    if (0 != virStreamEventUpdateCallback(**native, args[0]->Int32Value())) {
+        virt::throwVirtError(isolate);
+    }
+}
+
+static void __virStreamEventRemoveCallback(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY(isolate, native);
+
+    if (0 != virStreamEventRemoveCallback(**native)) {
+        virt::throwVirtError(isolate);
+    }
+}
+
+static void __virStreamFinish(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::Worker::Run(args, new EndStreamWorker(**native, virStreamFinish));
+}
+
+static void __virStreamAbort(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Object> holder = args.Holder();
+    virt::stream::Stream *native = node::ObjectWrap::Unwrap<virt::stream::Stream>(holder);
+    CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native);
+
+    virt::Worker::Run(args, new EndStreamWorker(**native, virStreamAbort));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,12 +248,24 @@ extern "C" {
 namespace virt {
     namespace stream {
 
-        v8::Persistent<v8::Function> Stream::constructor;
+        void prototype(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "newStream",                     __virStreamNew);
+        }
+
+        static void methods(v8::Local<v8::FunctionTemplate> tpl) {
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "free",                          Stream::Free<Stream>);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "recv",                          __virStreamRecv);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "send",                          __virStreamSend);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "addEventCallback",              __virStreamEventAddCallback);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "updateEventCallback",           __virStreamEventUpdateCallback);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "removeEventCallback",           __virStreamEventRemoveCallback);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "finish",                        __virStreamFinish);
+            VIRT_SET_PROTOTYPE_METHOD(tpl, "abort",                         __virStreamAbort);
+        }
 
         void exports(v8::Handle<v8::Object> exports) {
-            Stream::Export<Stream>(exports, "Stream");
+            Stream::Export<Stream>(exports, "Stream", methods);
         }
 
     } // namespace stream
 } // namespace virt
-
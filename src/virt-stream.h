@@ -13,10 +13,13 @@ namespace virt {
 
         void exports(v8::Handle<v8::Object> exports);
 
+        /**
+         * Installs the stream related methods onto the Connection prototype
+         */
+        void prototype(v8::Local<v8::FunctionTemplate> tpl);
+
         class Stream : public Pointer<virStreamPtr> {
         private:
-            static v8::Persistent<v8::Function> constructor;
-
             inline Stream(virStreamPtr ptr) : Pointer(ptr) {}
 
             friend class Pointer<virStreamPtr>;
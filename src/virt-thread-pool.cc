@@ -0,0 +1,214 @@
+/**
+ * Bounded pool of native threads for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <pthread.h>
+
+// standard c++
+#include <atomic>
+#include <deque>
+
+// node
+#include <uv.h>
+
+#include "virt-thread-pool.h"
+
+/**
+ * The threads are started on demand up to the limit and shared by all
+ * isolates. Unlike the libuv pool, a thread whose job is given up leaves
+ * the pool and another one is started in its place, so calls blocked on
+ * a dead host do not starve the others.
+ */
+
+namespace {
+
+    using virt::threadpool::Job;
+
+    /**
+     * A loop of ForEach, drained by every job of the batch
+     */
+    struct Batch {
+        std::atomic<size_t> next;
+        size_t count;
+        void (*run)(void *data, size_t i);
+        void *data;
+        void (*done)(void *data);
+        // jobs of the batch which have not finished yet
+        std::atomic<unsigned int> remaining;
+    };
+
+    class Drain : public Job {
+    public:
+
+        inline explicit Drain(Batch *batch) : batch(batch) {}
+
+        virtual void Run() {
+            for (;;) {
+                size_t i = this->batch->next.fetch_add(1);
+
+                if (i >= this->batch->count) {
+                    return;
+                }
+
+                this->batch->run(this->batch->data, i);
+            }
+        }
+
+        virtual void Done() {
+            Batch *batch = this->batch;
+
+            delete this;
+
+            if (0 == --batch->remaining) {
+                batch->done(batch->data);
+                delete batch;
+            }
+        }
+
+    private:
+
+        Batch *batch;
+    };
+
+    static uv_mutex_t lock;
+
+    static uv_cond_t cond;
+
+    static uv_once_t once = UV_ONCE_INIT;
+
+    static std::deque<Job*> queue;
+
+    static unsigned int limit = 16;
+
+    static unsigned int busy = 0;
+
+    static unsigned int nthreads = 0;
+
+    static void loop(void *arg);
+
+    static void initialize() {
+        uv_mutex_init(&lock);
+        uv_cond_init(&cond);
+    }
+
+    /**
+     * Starts another thread if all of them are busy and the limit allows,
+     * must be called with the lock held
+     */
+    static void grow() {
+        if (nthreads < limit && nthreads < busy + queue.size()) {
+            uv_thread_t thread;
+            if (0 == uv_thread_create(&thread, loop, NULL)) {
+                // never joined, a thread replaced after a timeout exits
+                pthread_detach(thread);
+                nthreads++;
+            }
+        }
+    }
+
+    static void loop(void *arg) {
+        for (;;) {
+            uv_mutex_lock(&lock);
+
+            while (queue.empty() || busy >= limit) {
+                uv_cond_wait(&cond, &lock);
+            }
+
+            Job *job = queue.front();
+            queue.pop_front();
+            job->running = true;
+            busy++;
+
+            uv_mutex_unlock(&lock);
+
+            job->Run();
+
+            uv_mutex_lock(&lock);
+            job->running = false;
+            bool abandoned = job->abandoned;
+            if (!abandoned) {
+                busy--;
+                uv_cond_signal(&cond);
+            }
+            uv_mutex_unlock(&lock);
+
+            job->Done();
+
+            // replaced when the job was given up
+            if (abandoned) {
+                return;
+            }
+        }
+    }
+
+} // namespace
+
+namespace virt {
+    namespace threadpool {
+
+        void Submit(Job *job) {
+            uv_once(&once, initialize);
+
+            uv_mutex_lock(&lock);
+            queue.push_back(job);
+            grow();
+            uv_cond_signal(&cond);
+            uv_mutex_unlock(&lock);
+        }
+
+        bool Abandon(Job *job) {
+            uv_once(&once, initialize);
+
+            uv_mutex_lock(&lock);
+
+            if (!job->running || job->abandoned) {
+                uv_mutex_unlock(&lock);
+                return false;
+            }
+
+            job->abandoned = true;
+            busy--;
+            nthreads--;
+            grow();
+            uv_cond_signal(&cond);
+
+            uv_mutex_unlock(&lock);
+            return true;
+        }
+
+        void SetLimit(unsigned int n) {
+            uv_once(&once, initialize);
+
+            uv_mutex_lock(&lock);
+            limit = n;
+            grow();
+            uv_cond_broadcast(&cond);
+            uv_mutex_unlock(&lock);
+        }
+
+        void ForEach(size_t count, unsigned int concurrency, void (*run)(void *data, size_t i), void *data, void (*done)(void *data)) {
+            unsigned int njobs = static_cast<unsigned int>(count < concurrency ? count : concurrency);
+
+            if (0 == njobs) {
+                done(data);
+                return;
+            }
+
+            Batch *batch = new Batch();
+            batch->next.store(0);
+            batch->count = count;
+            batch->run = run;
+            batch->data = data;
+            batch->done = done;
+            batch->remaining.store(njobs);
+
+            for (unsigned int i = 0; i < njobs; i++) {
+                Submit(new Drain(batch));
+            }
+        }
+
+    } // namespace threadpool
+} // namespace virt
@@ -0,0 +1,62 @@
+#ifndef __NODE_VIRT_THREAD_POOL_H__
+#define __NODE_VIRT_THREAD_POOL_H__
+
+// standard c
+#include <stddef.h>
+
+namespace virt {
+    namespace threadpool {
+
+        /**
+         * Work queued onto the pool. {@link Job::Run()} may block for as
+         * long as the libvirt calls it makes, {@link Job::Done()} follows
+         * on the same thread once the pool is done with the job, so the job
+         * may release itself there.
+         */
+        class Job {
+        public:
+
+            inline Job() : running(false), abandoned(false) {}
+
+            virtual ~Job() {}
+
+            virtual void Run() = 0;
+
+            virtual void Done() {}
+
+            // set by the pool under its lock
+            bool running;
+
+            bool abandoned;
+        };
+
+        /**
+         * Queues the job, may be called from any thread
+         */
+        void Submit(Job *job);
+
+        /**
+         * Gives up the running job: its thread no longer counts against the
+         * limit, another one takes over the queue and the given up one
+         * exits once the job is done. Returns false if the job is not
+         * running.
+         */
+        bool Abandon(Job *job);
+
+        /**
+         * Sets the number of jobs which run at once, 16 by default
+         */
+        void SetLimit(unsigned int limit);
+
+        /**
+         * Runs <code>run(data, i)</code> for every <code>i</code> below
+         * <code>count</code> on up to <code>concurrency</code> pool threads,
+         * then <code>done(data)</code> on the thread which finished last, or
+         * right away on the calling one if there is nothing to run
+         */
+        void ForEach(size_t count, unsigned int concurrency, void (*run)(void *data, size_t i), void *data, void (*done)(void *data));
+
+    } // namespace threadpool
+} // namespace virt
+
+#endif /* __NODE_VIRT_THREAD_POOL_H__ */
@@ -0,0 +1,218 @@
+/**
+ * libvirt-typed-parameter for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c++
+#include <map>
+#include <string>
+
+#include "virt-error.h"
+#include "virt-instance.h"
+#include "virt-typed-parameter.h"
+
+// field names are bounded in practice, but per-device stats are not
+#define MAX_CACHED_KEYS 4096
+
+namespace virt {
+    namespace typedparam {
+
+        v8::Local<v8::String> Key(v8::Isolate *isolate, const char *field) {
+            std::map<std::string, v8::Persistent<v8::String>*>& keys = Instance::Current()->keys;
+            std::map<std::string, v8::Persistent<v8::String>*>::iterator i = keys.find(field);
+            if (i != keys.end()) {
+                return v8::Local<v8::String>::New(isolate, *i->second);
+            }
+
+            v8::Local<v8::String> key = v8::String::NewFromUtf8(isolate, field, v8::String::kInternalizedString);
+
+            if (keys.size() < MAX_CACHED_KEYS) {
+                keys[field] = new v8::Persistent<v8::String>(isolate, key);
+            }
+
+            return key;
+        }
+
+        v8::Local<v8::Value> ToValue(v8::Isolate *isolate, virTypedParameterPtr param) {
+            switch (param->type) {
+            case VIR_TYPED_PARAM_INT:
+                return v8::Number::New(isolate, param->value.i);
+            case VIR_TYPED_PARAM_UINT:
+                return v8::Number::New(isolate, param->value.ui);
+            case VIR_TYPED_PARAM_LLONG:
+                return v8::Number::New(isolate, param->value.l);
+            case VIR_TYPED_PARAM_ULLONG:
+                return v8::Number::New(isolate, param->value.ul);
+            case VIR_TYPED_PARAM_DOUBLE:
+                return v8::Number::New(isolate, param->value.d);
+            case VIR_TYPED_PARAM_BOOLEAN:
+                return v8::Boolean::New(isolate, 0 != param->value.b);
+            case VIR_TYPED_PARAM_STRING:
+                return NULL == param->value.s
+                        ? v8::Local<v8::Value>(v8::Null(isolate))
+                        : v8::Local<v8::Value>(v8::String::NewFromUtf8(isolate, param->value.s));
+            default:
+                return v8::Undefined(isolate);
+            }
+        }
+
+        v8::Local<v8::Array> ToArray(v8::Isolate *isolate, virTypedParameterPtr params, int nparams) {
+            Instance *instance = Instance::Current();
+            v8::Local<v8::Array> result = v8::Array::New(isolate, nparams < 0 ? 0 : nparams);
+            v8::Local<v8::ObjectTemplate> tpl = v8::Local<v8::ObjectTemplate>::New(isolate, instance->paramTemplate);
+            v8::Local<v8::String> type = v8::Local<v8::String>::New(isolate, instance->keyType);
+            v8::Local<v8::String> field = v8::Local<v8::String>::New(isolate, instance->keyField);
+            v8::Local<v8::String> value = v8::Local<v8::String>::New(isolate, instance->keyValue);
+
+            for (int i = 0; i < nparams; i++) {
+                virTypedParameterPtr param = params + i;
+                v8::Local<v8::Object> item = tpl->NewInstance();
+
+                item->Set(type, v8::Integer::New(isolate, param->type));
+                item->Set(field, Key(isolate, param->field));
+                item->Set(value, ToValue(isolate, param));
+                result->Set(i, item);
+            }
+
+            return result;
+        }
+
+        v8::Local<v8::Object> ToObject(v8::Isolate *isolate, virTypedParameterPtr params, int nparams) {
+            v8::Local<v8::Object> result = v8::Object::New(isolate);
+
+            for (int i = 0; i < nparams; i++) {
+                result->Set(Key(isolate, params[i].field), ToValue(isolate, params + i));
+            }
+
+            return result;
+        }
+
+        bool FromArray(v8::Isolate *isolate, v8::Local<v8::Value> value, Arena *arena, virTypedParameterPtr *params, int *nparams) {
+            if (!value->IsArray()) {
+                virt::throwTypeError(isolate, "Invalid arguments");
+                return false;
+            }
+
+            Instance *instance = Instance::Current();
+            v8::Local<v8::Array> items = v8::Local<v8::Array>::Cast(value);
+            v8::Local<v8::String> keyType = v8::Local<v8::String>::New(isolate, instance->keyType);
+            v8::Local<v8::String> keyField = v8::Local<v8::String>::New(isolate, instance->keyField);
+            v8::Local<v8::String> keyValue = v8::Local<v8::String>::New(isolate, instance->keyValue);
+            int n = items->Length();
+            virTypedParameterPtr result = arena->Allocate<virTypedParameter>(n);
+
+            if (NULL == result) {
+                virt::throwError(isolate, "Out of memory");
+                return false;
+            }
+
+            for (int i = 0; i < n; i++) {
+                v8::Local<v8::Value> item = items->Get(i);
+
+                if (!item->IsObject()) {
+                    virt::throwTypeError(isolate, "Invalid arguments");
+                    return false;
+                }
+
+                v8::Local<v8::Object> obj = v8::Local<v8::Object>::Cast(item);
+                virTypedParameterPtr param = result + i;
+
+                // an absent property reads as undefined, which fails the
+                // type checks, so no separate Has() lookup is needed
+                v8::Local<v8::Value> field = obj->Get(keyField);
+                if (!field->IsString()) {
+                    virt::throwTypeError(isolate, field->IsUndefined()
+                            ? "Property `field` not found"
+                            : "Property `field` was supposed to be string");
+                    return false;
+                }
+
+                // a truncated name would set another parameter, or none
+                v8::Local<v8::String> name = v8::Local<v8::String>::Cast(field);
+                if (name->Utf8Length() >= VIR_TYPED_PARAM_FIELD_LENGTH) {
+                    virt::throwTypeError(isolate, "Property `field` is too long");
+                    return false;
+                }
+
+                // the parameter is zeroed, so the name stays terminated
+                name->WriteUtf8(param->field, VIR_TYPED_PARAM_FIELD_LENGTH - 1);
+
+                v8::Local<v8::Value> type = obj->Get(keyType);
+                if (!type->IsInt32()) {
+                    virt::throwTypeError(isolate, type->IsUndefined()
+                            ? "Property `type` not found"
+                            : "Property `type` was supposed to be integer");
+                    return false;
+                }
+
+                param->type = type->Int32Value();
+
+                v8::Local<v8::Value> val = obj->Get(keyValue);
+                if (val->IsUndefined()) {
+                    virt::throwTypeError(isolate, "Property `value` not found");
+                    return false;
+                }
+
+                switch (param->type) {
+                case VIR_TYPED_PARAM_INT:
+                    param->value.i = val->Int32Value();
+                    break;
+                case VIR_TYPED_PARAM_UINT:
+                    param->value.ui = val->Uint32Value();
+                    break;
+                case VIR_TYPED_PARAM_LLONG:
+                    param->value.l = val->IntegerValue();
+                    break;
+                case VIR_TYPED_PARAM_ULLONG:
+                    param->value.ul = val->IntegerValue();
+                    break;
+                case VIR_TYPED_PARAM_DOUBLE:
+                    param->value.d = val->NumberValue();
+                    break;
+                case VIR_TYPED_PARAM_BOOLEAN:
+                    param->value.b = val->BooleanValue() ? 1 : 0;
+                    break;
+                case VIR_TYPED_PARAM_STRING:
+                    param->value.s = arena->Copy(val->ToString());
+
+                    if (NULL == param->value.s) {
+                        virt::throwError(isolate, "Out of memory");
+                        return false;
+                    }
+                    break;
+                default:
+                    virt::throwTypeError(isolate, "Property `type` was supposed to be a virTypedParameterType");
+                    return false;
+                }
+            }
+
+            *params = result;
+            *nparams = n;
+            return true;
+        }
+
+        void exports(v8::Handle<v8::Object> exports) {
+            v8::Isolate *isolate = v8::Isolate::GetCurrent();
+            v8::HandleScope scope(isolate);
+            Instance *instance = Instance::Current();
+
+            v8::Local<v8::String> type = v8::String::NewFromUtf8(isolate, "type", v8::String::kInternalizedString);
+            v8::Local<v8::String> field = v8::String::NewFromUtf8(isolate, "field", v8::String::kInternalizedString);
+            v8::Local<v8::String> value = v8::String::NewFromUtf8(isolate, "value", v8::String::kInternalizedString);
+
+            instance->keyType.Reset(isolate, type);
+            instance->keyField.Reset(isolate, field);
+            instance->keyValue.Reset(isolate, value);
+
+            // the properties are declared up front so every instance starts
+            // with the final shape
+            v8::Local<v8::ObjectTemplate> tpl = v8::ObjectTemplate::New(isolate);
+            tpl->Set(type, v8::Integer::New(isolate, 0));
+            tpl->Set(field, v8::String::Empty(isolate));
+            tpl->Set(value, v8::Undefined(isolate));
+            instance->paramTemplate.Reset(isolate, tpl);
+        }
+
+    } // namespace typedparam
+} // namespace virt
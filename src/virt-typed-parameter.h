@@ -0,0 +1,52 @@
+#ifndef __NODE_VIRT_TYPED_PARAMETER_H__
+#define __NODE_VIRT_TYPED_PARAMETER_H__
+
+// libvirt
+#include <libvirt/libvirt.h>
+
+// node
+#include <node.h>
+
+#include "virt-arena.h"
+
+namespace virt {
+    namespace typedparam {
+
+        void exports(v8::Handle<v8::Object> exports);
+
+        /**
+         * Returns the internalized string of the field name, the strings
+         * are created once and shared by every conversion
+         */
+        v8::Local<v8::String> Key(v8::Isolate *isolate, const char *field);
+
+        /**
+         * Converts the value of the typed parameter
+         */
+        v8::Local<v8::Value> ToValue(v8::Isolate *isolate, virTypedParameterPtr param);
+
+        /**
+         * Converts the typed parameters into an array of
+         * <code>{ type, field, value }</code> objects which share the same
+         * hidden class
+         */
+        v8::Local<v8::Array> ToArray(v8::Isolate *isolate, virTypedParameterPtr params, int nparams);
+
+        /**
+         * Converts the typed parameters into an object keyed by field
+         */
+        v8::Local<v8::Object> ToObject(v8::Isolate *isolate, virTypedParameterPtr params, int nparams);
+
+        /**
+         * Converts an array of <code>{ type, field, value }</code> objects
+         * into typed parameters in a single pass. The parameters and their
+         * strings are allocated from the arena and live as long as it does.
+         * Throws and returns false if the array is malformed, a field name
+         * does not fit into a parameter or the memory is exhausted.
+         */
+        bool FromArray(v8::Isolate *isolate, v8::Local<v8::Value> value, Arena *arena, virTypedParameterPtr *params, int *nparams);
+
+    } // namespace typedparam
+} // namespace virt
+
+#endif /* __NODE_VIRT_TYPED_PARAMETER_H__ */
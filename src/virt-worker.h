@@ -0,0 +1,244 @@
+#ifndef __NODE_VIRT_WORKER_H__
+#define __NODE_VIRT_WORKER_H__
+
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+// node
+#include <node.h>
+#include <uv.h>
+
+#include "virt-error.h"
+#include "virt-instance.h"
+#include "virt-stats.h"
+
+/**
+ * Same as CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY, but a closed instance
+ * still completes the pending callback (with undefined) when the call was
+ * made asynchronously.
+ */
+#define CHK_NATIVE_CLASS_INSTANCE_ACCESSIBILITY_ASYNC(args, isolate, native) \
+    do {                                                         \
+        if (NULL == (native)) {                                  \
+            virt::throwError((isolate), "Invalid arguments");    \
+            return;                                              \
+        }                                                        \
+                                                                 \
+        if ((native)->IsNull()) {                                \
+            virt::Worker::Run((args), new virt::NullWorker());   \
+            return;                                              \
+        }                                                        \
+    } while (0);
+
+namespace virt {
+
+    class Executor;
+
+    /**
+     * A single libvirt call which can be executed either synchronously on
+     * the main thread or asynchronously on the libuv thread pool.
+     *
+     * {@link Worker::Execute()} must not touch V8, it only calls libvirt
+     * and copies the results into plain C++ members; {@link Worker::Result()}
+     * is always invoked on the main thread to build the JS value.
+     *
+     * The libvirt objects a worker calls are held as virt::Reference, so
+     * that closing or freeing their wrappers meanwhile is safe.
+     */
+    class Worker {
+    public:
+
+        inline Worker() : error(NULL), next(NULL) {
+            this->request.data = this;
+            this->sample.binding = NULL;
+        }
+
+        virtual ~Worker() {
+            free(this->error);
+            this->callback.Reset();
+            this->holder.Reset();
+        }
+
+        /**
+         * Performs the libvirt call, may run on a worker thread
+         */
+        virtual void Execute() = 0;
+
+        /**
+         * Executes the worker, timing the libvirt call if the call which
+         * created the worker is instrumented
+         */
+        inline void Process() {
+            if (NULL == this->sample.binding) {
+                this->Execute();
+                return;
+            }
+
+            uint64_t started = uv_hrtime();
+            this->Execute();
+            this->sample.executed = uv_hrtime() - started;
+            stats::Record(this->sample.binding, stats::LIBVIRT, this->sample.executed);
+        }
+
+        /**
+         * Converts the result into JS value, always runs on the main thread
+         */
+        virtual v8::Local<v8::Value> Result(v8::Isolate *isolate) {
+            return v8::Undefined(isolate);
+        }
+
+        inline bool HasError() const { return NULL != this->error; }
+
+        inline const char *GetError() const { return this->error; }
+
+        inline void SetError(const char *msg) {
+            free(this->error);
+            this->error = strdup(msg);
+        }
+
+        /**
+         * Captures the last libvirt error, libvirt keeps it per thread so
+         * this must be called on the thread which executed the call
+         */
+        inline void SetVirtError() {
+            const char *msg = virGetLastErrorMessage();
+            this->SetError((NULL == msg) ? "Unknown error" : msg);
+        }
+
+        /**
+         * Runs the worker. If the last argument is a function, the worker
+         * is queued onto the executor (or the thread pool if there is none)
+         * and the function is called with <code>(err, result)</code> on
+         * completion, otherwise it executes immediately and the result is
+         * returned (or thrown).
+         *
+         * The worker is owned by this function after the call.
+         */
+        static void Run(const v8::FunctionCallbackInfo<v8::Value>& args, Worker *worker, Executor *executor = NULL);
+
+        // timing of the call while the instrumentation is enabled
+        stats::Sample sample;
+
+    protected:
+
+        /**
+         * Queues the worker of an asynchronous call onto the executor, or
+         * the thread pool if there is none. Workers which schedule their
+         * own work override this and call {@link Worker::Complete()} on
+         * the main thread once done.
+         */
+        virtual void Dispatch(Executor *executor);
+
+        /**
+         * Invokes the callback with the error or result, then releases the
+         * worker; must be called on the main thread
+         */
+        void Complete() {
+            v8::Isolate *isolate = v8::Isolate::GetCurrent();
+            v8::HandleScope scope(isolate);
+            v8::Local<v8::Value> argv[2];
+            uint64_t started = (NULL != this->sample.binding) ? uv_hrtime() : 0;
+
+            if (this->HasError()) {
+                argv[0] = v8::Exception::Error(v8::String::NewFromUtf8(isolate, this->error));
+                argv[1] = v8::Undefined(isolate);
+            } else {
+                argv[0] = v8::Null(isolate);
+                argv[1] = this->Result(isolate);
+            }
+
+            if (NULL != this->sample.binding) {
+                stats::Complete(&this->sample, uv_hrtime() - started, this->HasError());
+            }
+
+            v8::Local<v8::Function> cb = v8::Local<v8::Function>::New(isolate, this->callback);
+            delete this;
+            node::MakeCallback(isolate, isolate->GetCurrentContext()->Global(), cb, 2, argv);
+        }
+
+        uv_work_t request;
+
+        char *error;
+
+        v8::Persistent<v8::Function> callback;
+
+        v8::Persistent<v8::Object> holder;
+
+    private:
+
+        // link of the executor queues
+        Worker *next;
+
+        friend class Executor;
+
+        static void Work(uv_work_t *req) {
+            static_cast<Worker*>(req->data)->Process();
+        }
+
+        static void After(uv_work_t *req, int status) {
+            static_cast<Worker*>(req->data)->Complete();
+        }
+
+    };
+
+    /**
+     * Worker of a call on a closed instance, completes with undefined
+     */
+    class NullWorker : public Worker {
+    public:
+        virtual void Execute() {}
+    };
+
+} // namespace virt
+
+#include "virt-executor.h"
+
+namespace virt {
+
+    inline void Worker::Dispatch(Executor *executor) {
+        if (NULL != executor) {
+            executor->Submit(this);
+        } else {
+            uv_queue_work(Instance::Current()->loop, &this->request, Work, After);
+        }
+    }
+
+    inline void Worker::Run(const v8::FunctionCallbackInfo<v8::Value>& args, Worker *worker, Executor *executor) {
+        v8::Isolate *isolate = args.GetIsolate();
+        int argc = args.Length();
+
+        if (argc > 0 && args[argc - 1]->IsFunction()) {
+            worker->callback.Reset(isolate, v8::Local<v8::Function>::Cast(args[argc - 1]));
+
+            // keep the wrapped instance alive while the call is in flight
+            worker->holder.Reset(isolate, args.Holder());
+            stats::Defer(&worker->sample);
+            worker->Dispatch(executor);
+            return;
+        }
+
+        stats::Call *call = stats::Current();
+
+        if (NULL != call) {
+            worker->sample.binding = call->binding;
+        }
+
+        worker->Process();
+
+        if (NULL != call) {
+            call->libvirt += worker->sample.executed;
+        }
+
+        if (worker->HasError()) {
+            throwError(isolate, worker->error);
+        } else {
+            args.GetReturnValue().Set(worker->Result(isolate));
+        }
+
+        delete worker;
+    }
+
+} // namespace virt
+
+#endif /* __NODE_VIRT_WORKER_H__ */
@@ -0,0 +1,354 @@
+/**
+ * Streaming XML extractor for node js
+ *
+ * @author Johnson Lee <g.johnsonlee@gmail.com>
+ */
+
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+#include "virt-error.h"
+#include "virt-xml.h"
+
+static inline bool isSpace(char c) {
+    return ' ' == c || '\t' == c || '\r' == c || '\n' == c;
+}
+
+static inline bool isNameChar(char c) {
+    return !isSpace(c) && '\0' != c && '/' != c && '>' != c && '=' != c;
+}
+
+static void appendUtf8(std::string& out, unsigned long cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x110000) {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+/**
+ * Appends the character data between begin and end, decoding the entities
+ */
+static void decode(std::string& out, const char *begin, const char *end) {
+    for (const char *p = begin; p < end; p++) {
+        if ('&' != *p) {
+            out += *p;
+            continue;
+        }
+
+        const char *semi = static_cast<const char*>(memchr(p, ';', end - p));
+        if (NULL == semi) {
+            out += *p;
+            continue;
+        }
+
+        std::string entity(p + 1, semi);
+
+        if ("lt" == entity) {
+            out += '<';
+        } else if ("gt" == entity) {
+            out += '>';
+        } else if ("amp" == entity) {
+            out += '&';
+        } else if ("quot" == entity) {
+            out += '"';
+        } else if ("apos" == entity) {
+            out += '\'';
+        } else if (entity.size() > 1 && '#' == entity[0]) {
+            bool hex = 'x' == entity[1] || 'X' == entity[1];
+            appendUtf8(out, strtoul(entity.c_str() + (hex ? 2 : 1), NULL, hex ? 16 : 10));
+        } else {
+            out.append(p, semi + 1);
+        }
+
+        p = semi;
+    }
+}
+
+namespace virt {
+    namespace xml {
+
+        Extractor *Extractor::New(v8::Isolate *isolate, v8::Local<v8::Value> selectors) {
+            if (!selectors->IsArray()) {
+                virt::throwTypeError(isolate, "Invalid arguments");
+                return NULL;
+            }
+
+            v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(selectors);
+            Extractor *extractor = new Extractor();
+            extractor->selectors.resize(array->Length());
+
+            for (uint32_t i = 0; i < array->Length(); i++) {
+                v8::Local<v8::Value> item = array->Get(i);
+                v8::String::Utf8Value source(item->ToString());
+
+                if (!item->IsString() || !Compile(*source, &extractor->selectors[i])) {
+                    delete extractor;
+                    virt::throwTypeError(isolate, "Invalid selector");
+                    return NULL;
+                }
+            }
+
+            return extractor;
+        }
+
+        bool Extractor::Compile(const std::string& source, Selector *selector) {
+            selector->source = source;
+            selector->steps.clear();
+            selector->attribute.clear();
+            selector->descendant = 0 == source.compare(0, 2, "//");
+            selector->capturing = -1;
+
+            if (source.empty() || '/' != source[0]) {
+                return false;
+            }
+
+            size_t pos = selector->descendant ? 2 : 1;
+
+            for (;;) {
+                size_t slash = source.find('/', pos);
+                std::string step = source.substr(pos, std::string::npos == slash ? std::string::npos : slash - pos);
+
+                if (step.empty()) {
+                    return false;
+                }
+
+                if ('@' == step[0]) {
+                    // the attribute is the last step and belongs to an element
+                    if (std::string::npos != slash || 1 == step.size() || selector->steps.empty()) {
+                        return false;
+                    }
+
+                    selector->attribute = step.substr(1);
+                    return true;
+                }
+
+                selector->steps.push_back(step);
+
+                if (std::string::npos == slash) {
+                    return true;
+                }
+
+                pos = slash + 1;
+            }
+        }
+
+        bool Extractor::Matches(const Selector& selector) const {
+            size_t nsteps = selector.steps.size();
+            size_t depth = this->stack.size();
+
+            if (selector.descendant ? depth < nsteps : depth != nsteps) {
+                return false;
+            }
+
+            for (size_t i = 0; i < nsteps; i++) {
+                const std::string& step = selector.steps[nsteps - 1 - i];
+                if ("*" != step && step != this->stack[depth - 1 - i]) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void Extractor::OnStartElement(const std::vector<std::pair<std::string, std::string> >& attributes) {
+            for (size_t i = 0; i < this->selectors.size(); i++) {
+                Selector& selector = this->selectors[i];
+
+                if (selector.capturing >= 0 || !this->Matches(selector)) {
+                    continue;
+                }
+
+                if (selector.attribute.empty()) {
+                    selector.capturing = static_cast<int>(this->stack.size());
+                    selector.text.clear();
+                    continue;
+                }
+
+                for (size_t j = 0; j < attributes.size(); j++) {
+                    if (attributes[j].first == selector.attribute) {
+                        selector.values.push_back(attributes[j].second);
+                        break;
+                    }
+                }
+            }
+        }
+
+        void Extractor::OnEndElement() {
+            for (size_t i = 0; i < this->selectors.size(); i++) {
+                Selector& selector = this->selectors[i];
+
+                if (selector.capturing == static_cast<int>(this->stack.size())) {
+                    selector.values.push_back(selector.text);
+                    selector.capturing = -1;
+                }
+            }
+
+            this->stack.pop_back();
+        }
+
+        void Extractor::OnText(const std::string& text) {
+            for (size_t i = 0; i < this->selectors.size(); i++) {
+                if (this->selectors[i].capturing >= 0) {
+                    this->selectors[i].text += text;
+                }
+            }
+        }
+
+        void Extractor::Parse(const char *xml) {
+            std::vector<std::pair<std::string, std::string> > attributes;
+            std::string text;
+            const char *p = xml;
+
+            while ('\0' != *p) {
+                if ('<' != *p) {
+                    const char *lt = strchr(p, '<');
+                    const char *end = NULL == lt ? p + strlen(p) : lt;
+
+                    text.clear();
+                    decode(text, p, end);
+                    this->OnText(text);
+                    p = end;
+                    continue;
+                }
+
+                if (0 == strncmp(p, "<!--", 4)) {
+                    const char *end = strstr(p + 4, "-->");
+                    if (NULL == end) {
+                        return;
+                    }
+
+                    p = end + 3;
+                } else if (0 == strncmp(p, "<![CDATA[", 9)) {
+                    const char *end = strstr(p + 9, "]]>");
+                    if (NULL == end) {
+                        return;
+                    }
+
+                    this->OnText(std::string(p + 9, end));
+                    p = end + 3;
+                } else if ('?' == p[1] || '!' == p[1]) {
+                    // processing instructions and declarations
+                    const char *end = strchr(p, '>');
+                    if (NULL == end) {
+                        return;
+                    }
+
+                    p = end + 1;
+                } else if ('/' == p[1]) {
+                    const char *end = strchr(p, '>');
+                    if (NULL == end) {
+                        return;
+                    }
+
+                    if (!this->stack.empty()) {
+                        this->OnEndElement();
+                    }
+
+                    p = end + 1;
+                } else {
+                    const char *name = ++p;
+                    while (isNameChar(*p)) {
+                        p++;
+                    }
+
+                    this->stack.push_back(std::string(name, p));
+                    attributes.clear();
+
+                    for (;;) {
+                        while (isSpace(*p)) {
+                            p++;
+                        }
+
+                        if ('\0' == *p) {
+                            return;
+                        }
+
+                        if ('>' == *p || '/' == *p) {
+                            break;
+                        }
+
+                        const char *key = p;
+                        while (isNameChar(*p)) {
+                            p++;
+                        }
+
+                        std::string attr(key, p);
+
+                        while (isSpace(*p)) {
+                            p++;
+                        }
+
+                        if ('=' != *p) {
+                            // malformed attribute, skip the character
+                            if (p == key) {
+                                p++;
+                            }
+                            continue;
+                        }
+
+                        do {
+                            p++;
+                        } while (isSpace(*p));
+
+                        char quote = *p;
+                        if ('"' != quote && '\'' != quote) {
+                            return;
+                        }
+
+                        const char *value = ++p;
+                        const char *end = strchr(value, quote);
+                        if (NULL == end) {
+                            return;
+                        }
+
+                        attributes.push_back(std::make_pair(attr, std::string()));
+                        decode(attributes.back().second, value, end);
+                        p = end + 1;
+                    }
+
+                    this->OnStartElement(attributes);
+
+                    if ('/' == *p) {
+                        this->OnEndElement();
+                        p++;
+                    }
+
+                    if ('>' == *p) {
+                        p++;
+                    }
+                }
+            }
+        }
+
+        v8::Local<v8::Object> Extractor::Result(v8::Isolate *isolate) {
+            v8::Local<v8::Object> result = v8::Object::New(isolate);
+
+            for (size_t i = 0; i < this->selectors.size(); i++) {
+                const Selector& selector = this->selectors[i];
+                v8::Local<v8::Array> values = v8::Array::New(isolate, selector.values.size());
+
+                for (size_t j = 0; j < selector.values.size(); j++) {
+                    const std::string& value = selector.values[j];
+                    values->Set(j, v8::String::NewFromUtf8(isolate, value.data(), v8::String::kNormalString, value.size()));
+                }
+
+                result->Set(v8::String::NewFromUtf8(isolate, selector.source.c_str()), values);
+            }
+
+            return result;
+        }
+
+    } // namespace xml
+} // namespace virt
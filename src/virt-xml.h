@@ -0,0 +1,81 @@
+#ifndef __NODE_VIRT_XML_H__
+#define __NODE_VIRT_XML_H__
+
+// standard c++
+#include <string>
+#include <vector>
+
+// node
+#include <node.h>
+
+namespace virt {
+    namespace xml {
+
+        /**
+         * Extracts values from an XML document without building a tree.
+         *
+         * A selector is an absolute path of element names, e.g.
+         * <code>/domain/vcpu</code>, which matches the text of the element,
+         * or ends with an attribute, e.g.
+         * <code>/domain/devices/disk/source/@file</code>. A leading
+         * <code>//</code> matches the path at any depth and <code>*</code>
+         * matches any element name.
+         *
+         * {@link Extractor::Parse()} does not touch V8 and may run on a
+         * worker thread.
+         */
+        class Extractor {
+        public:
+
+            /**
+             * Creates an extractor of the selectors given as JS array,
+             * throws and returns NULL if any of them is invalid
+             */
+            static Extractor *New(v8::Isolate *isolate, v8::Local<v8::Value> selectors);
+
+            /**
+             * Scans the document and collects the values of every selector,
+             * malformed documents are scanned as far as possible
+             */
+            void Parse(const char *xml);
+
+            /**
+             * Returns the values keyed by selector, each being an array of
+             * strings in document order
+             */
+            v8::Local<v8::Object> Result(v8::Isolate *isolate);
+
+        private:
+
+            struct Selector {
+                std::string source;
+                std::vector<std::string> steps;
+                std::string attribute;
+                bool descendant;
+                // depth of the element whose text is being captured, or -1
+                int capturing;
+                std::string text;
+                std::vector<std::string> values;
+            };
+
+            inline Extractor() {}
+
+            static bool Compile(const std::string& source, Selector *selector);
+
+            bool Matches(const Selector& selector) const;
+
+            void OnStartElement(const std::vector<std::pair<std::string, std::string> >& attributes);
+
+            void OnEndElement();
+
+            void OnText(const std::string& text);
+
+            std::vector<Selector> selectors;
+
+            std::vector<std::string> stack;
+        };
+
+    } // namespace xml
+} // namespace virt
+
+#endif /* __NODE_VIRT_XML_H__ */
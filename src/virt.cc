@@ -4,42 +4,82 @@
  * @author Johnson Lee <g.johnsonlee@gmail.com>
  */
 
+// standard c
+#include <stdlib.h>
+#include <string.h>
+
+// node
 #include <node.h>
+#include <uv.h>
 
+#include "virt-cpu-matrix.h"
 #include "virt-domain.h"
 #include "virt-domain-snapshot.h"
 #include "virt-event.h"
+#include "virt-gather.h"
 #include "virt-host.h"
+#include "virt-instance.h"
 #include "virt-interface.h"
 #include "virt-network.h"
 #include "virt-node-device.h"
 #include "virt-network-filter.h"
+#include "virt-pool.h"
 #include "virt-secret.h"
 #include "virt-storage.h"
+#include "virt-stats.h"
 #include "virt-stream.h"
+#include "virt-typed-parameter.h"
+
+static uv_once_t once = UV_ONCE_INIT;
+
+static const char *initError = NULL;
+
+/**
+ * Initializes libvirt once per process, whichever thread loads the addon
+ * first
+ */
+static void initializeLibvirt() {
+    if (0 != virInitialize()) {
+        const char *msg = virGetLastErrorMessage();
+        initError = strdup((NULL == msg) ? "Unknown error" : msg);
+    }
+}
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void initialize(v8::Handle<v8::Object> exports) {
-    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+/**
+ * Loads the addon into the isolate of the main thread or of a worker
+ * thread, every isolate gets its own classes and templates
+ */
+void initialize(v8::Local<v8::Object> exports, v8::Local<v8::Value> module, v8::Local<v8::Context> context, void *priv) {
+    v8::Isolate *isolate = context->GetIsolate();
 
-    if (0 != virInitialize()) {
-        virt::throwVirtError(isolate);
+    uv_once(&once, initializeLibvirt);
+
+    if (NULL != initError) {
+        virt::throwError(isolate, initError);
         return;
     }
 
+    virt::Instance::New(isolate);
+
+    virt::typedparam::exports(exports);
+    virt::cpumatrix::exports(exports);
     virt::domain::exports(exports);
     virt::domainsnapshot::exports(exports);
     virt::event::exports(exports);
+    virt::gather::exports(exports);
     virt::host::exports(exports);
     virt::interface::exports(exports);
     virt::network::exports(exports);
     virt::nodedev::exports(exports);
     virt::nwfilter::exports(exports);
+    virt::pool::exports(exports);
     virt::secret::exports(exports);
     virt::storage::exports(exports);
+    virt::stats::exports(exports);
     virt::stream::exports(exports);
 }
 
@@ -47,5 +87,5 @@ void initialize(v8::Handle<v8::Object> exports) {
 }
 #endif
 
-NODE_MODULE(virt, initialize)
+NODE_MODULE_CONTEXT_AWARE(virt, initialize)
 
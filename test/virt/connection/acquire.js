@@ -0,0 +1,19 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('.acquire', function() {
+        it('should return a Connection object', function() {
+            var conn = Connection.acquire('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+            conn.close();
+        });
+
+        it('should reuse the idle pooled connection', function() {
+            Connection.acquire('vbox:///session').close();
+            Connection.acquire('vbox:///session').close();
+            Connection.drainPool().should.be.exactly(1);
+        });
+    });
+});
@@ -0,0 +1,38 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#addDomainEventListener', function() {
+        it('should return the callback id which can be removed', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                // VIR_DOMAIN_EVENT_ID_LIFECYCLE
+                var id = conn.addDomainEventListener(0, function(events) {
+                    events.should.be.an.Array;
+                });
+                id.should.be.a.Number;
+                conn.removeDomainEventListener(id);
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should reject a domain which is not a Domain', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                [{}, conn].forEach(function(domain) {
+                    (function() {
+                        conn.addDomainEventListener(0, function() {}, domain);
+                    }).should.throw('Invalid domain');
+                });
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
@@ -0,0 +1,45 @@
+var should = require('should');
+var virt = require('../../../');
+var Connection = virt.Connection;
+
+describe('Connection', function() {
+    describe('#applyCPUPinning', function() {
+        it('should pin the vCPUs of the domains in a single call', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            var plan = conn.listAllDomains(0).map(function(item) {
+                return {
+                    domain : item.domain,
+                    vcpus  : item.domain.getVcpuPinInfo(0)
+                };
+            });
+
+            conn.applyCPUPinning(plan, 0, function(err, result) {
+                try {
+                    should.not.exist(err);
+                    result.applied.should.be.a.Number;
+                    result.failed.should.be.an.Array;
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
+
+        it('should reject an invalid plan', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                [{}, conn].forEach(function(domain) {
+                    (function() {
+                        conn.applyCPUPinning([{ domain: domain }]);
+                    }).should.throw('Invalid domain');
+                });
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
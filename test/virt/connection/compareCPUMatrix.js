@@ -0,0 +1,51 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('.compareCPUMatrix', function() {
+        it('should return one result per guest and host', function(done) {
+            var conns = [Connection.open('vbox:///session'), Connection.open('vbox:///session')];
+            var cpus = ['<cpu><arch>x86_64</arch></cpu>', '<cpu>\n  <arch>x86_64</arch>\n</cpu>', '<cpu/>'];
+
+            Connection.compareCPUMatrix(cpus, conns, { baseline : true }, function(err, result) {
+                try {
+                    should.not.exist(err);
+                    result.matrix.should.be.an.instanceOf(Int8Array);
+                    result.matrix.should.have.length(cpus.length * conns.length);
+                    result.should.have.property('baseline');
+
+                    // alike CPUs and hosts share their answers
+                    result.matrix[0].should.equal(result.matrix[1]);
+                    result.matrix[0].should.equal(result.matrix[2]);
+                    result.matrix[0].should.equal(result.matrix[3]);
+
+                    var again = Connection.compareCPUMatrix(cpus, conns);
+                    again.compared.should.be.below(result.compared + 1);
+                    done();
+                } finally {
+                    conns.forEach(function(conn) {
+                        conn.close();
+                    });
+                }
+            });
+        });
+
+        it('should reject anything but connections', function() {
+            (function() {
+                Connection.compareCPUMatrix(['<cpu/>'], [{}]);
+            }).should.throw('Invalid connection');
+        });
+
+        it('should reject invalid CPU descriptions', function() {
+            var conn = Connection.open('vbox:///session');
+
+            try {
+                (function() {
+                    Connection.compareCPUMatrix([1], [conn]);
+                }).should.throw('Invalid CPU description');
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
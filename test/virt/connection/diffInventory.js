@@ -0,0 +1,46 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#diffInventory', function() {
+        it('should report the inventory once and then only its changes', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                var domains = conn.listAllDomains(0);
+                var diff = conn.diffInventory({ types : [ 'domain' ] });
+                diff.should.have.property('changes').which.is.an.Array;
+                diff.scans.should.have.property('domain', 'full');
+
+                diff.changes.length.should.equal(domains.length);
+                diff.changes.forEach(function(item) {
+                    item.type.should.equal('domain');
+                    item.change.should.equal('added');
+                    item.hash.should.match(/^[0-9a-f]{16}$/);
+                });
+
+                conn.diffInventory({ types : [ 'domain' ], full : true }).changes.should.be.empty;
+
+                conn.resetInventory();
+                conn.diffInventory({ types : [ 'domain' ] }).changes.length.should.equal(domains.length);
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should throw if the type is unknown', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                (function() {
+                    conn.diffInventory({ types : [ 'volume' ] });
+                }).should.throw('Unknown inventory type');
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
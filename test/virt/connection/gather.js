@@ -0,0 +1,60 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('.gather', function() {
+        it('should pass one result per connection to the callback', function(done) {
+            var conns = [Connection.open('vbox:///session'), Connection.open('vbox:///session')];
+
+            Connection.gather(conns, ['getHostname', ['getNodeCellsFreeMemory', 0, 1]], { timeout: 10000 }, function(err, results) {
+                try {
+                    should.not.exist(err);
+                    results.should.be.an.Array;
+                    results.should.have.length(2);
+                    results.forEach(function(result) {
+                        result.should.have.property('elapsed');
+                        result.should.not.have.property('error');
+                        result.getHostname.should.be.a.String;
+                        result.should.have.property('getNodeCellsFreeMemory');
+                    });
+                    done();
+                } finally {
+                    conns.forEach(function(conn) {
+                        conn.close();
+                    });
+                }
+            });
+        });
+
+        it('should reject unknown queries', function() {
+            var conn = Connection.open('vbox:///session');
+
+            try {
+                (function() {
+                    Connection.gather([conn], ['getCapabilities'], function() {});
+                }).should.throw();
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should reject anything but connections', function() {
+            (function() {
+                Connection.gather([{}], ['getHostname'], function() {});
+            }).should.throw('Invalid connection');
+        });
+
+        it('should call back asynchronously without connections', function(done) {
+            var returned = false;
+
+            Connection.gather([], ['getHostname'], function(err, results) {
+                should.not.exist(err);
+                results.should.be.empty;
+                returned.should.be.true;
+                done();
+            });
+
+            returned = true;
+        });
+    });
+});
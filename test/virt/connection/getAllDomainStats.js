@@ -0,0 +1,39 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#getAllDomainStats', function() {
+        it('should return a Float64Array per stats field', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                var result = conn.getAllDomainStats(0, 0);
+                result.domains.should.be.an.Array;
+
+                for (var field in result.stats) {
+                    result.stats[field].should.be.an.instanceOf(Float64Array);
+                    result.stats[field].length.should.be.exactly(result.domains.length);
+                }
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should return the stats asynchronously if callback specified', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            conn.getAllDomainStats(0, 0, function(err, result) {
+                try {
+                    should.not.exist(err);
+                    result.domains.should.be.an.Array;
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
+    });
+});
@@ -15,5 +15,33 @@ describe('Connection', function() {
                 conn.close();
             }
         });
+
+        it('should pass the capabilities to the callback', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            conn.getCapabilities(function(err, xml) {
+                try {
+                    should.not.exist(err);
+                    xml.should.be.a.String;
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
+
+        it('should return the selected values only', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                var result = conn.getCapabilities(['/capabilities/host/uuid', '//cpu/@type']);
+                result.should.have.property('/capabilities/host/uuid').with.lengthOf(1);
+                result['//cpu/@type'].should.be.an.Array;
+            } finally {
+                conn.close();
+            }
+        });
     });
 });
@@ -1,5 +1,6 @@
 var should = require('should');
-var Connection = require('../../../').Connection;
+var virt = require('../../../');
+var Connection = virt.Connection;
 
 describe('Connection', function() {
     describe('#getNodeCPUMap', function() {
@@ -10,7 +11,9 @@ describe('Connection', function() {
 
             try {
                 var cpumap = conn.getNodeCPUMap();
-                cpumap.should.be.a.ArrayBuffer;
+                cpumap.should.be.an.instanceOf(Uint8Array);
+                virt.CPUMap.count(cpumap).should.be.above(0);
+                virt.CPUMap.toArray(cpumap).length.should.equal(virt.CPUMap.count(cpumap));
             } finally {
                 conn.close();
             }
@@ -23,5 +23,22 @@ describe('Connection', function() {
                 conn.close();
             }
         });
+
+        it('should pass the hardware information to the callback', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            conn.getNodeInfo(function(err, info) {
+                try {
+                    should.not.exist(err);
+                    info.should.be.a.Object;
+                    info.should.have.property('model');
+                    info.should.have.property('cpus');
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
     });
 });
@@ -1,5 +1,12 @@
+require('./acquire');
+require('./addDomainEventListener');
+require('./applyCPUPinning');
 require('./baselineCPU');
 require('./compareCPU');
+require('./compareCPUMatrix');
+require('./diffInventory');
+require('./gather');
+require('./getAllDomainStats');
 require('./getCapabilities');
 require('./getHostname');
 require('./getLibVersion');
@@ -19,9 +26,16 @@ require('./getVersion');
 require('./isAlive');
 require('./isEncrypted');
 require('./isSecure');
+require('./listAllDomains');
+require('./listAllStoragePools');
+require('./lookupStorageVolumeByPath');
+require('./mirrorDomainStates');
+require('./newStream');
 require('./open');
 require('./openReadOnly');
 require('./ref');
+require('./setCacheTTL');
+require('./setDedicatedThread');
 require('./setKeepAlive');
 require('./setNodeMemoryParameters');
 require('./suspendNodeForDuration');
@@ -0,0 +1,66 @@
+var should = require('should');
+var virt = require('../../../');
+var Connection = virt.Connection;
+
+describe('Connection', function() {
+    describe('#listAllDomains', function() {
+        it('should return the wrapped domains with their name, uuid, state and id', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                var domains = conn.listAllDomains(0);
+                domains.should.be.an.Array;
+
+                domains.forEach(function(item) {
+                    item.domain.should.be.an.instanceOf(virt.Domain);
+                    item.name.should.be.a.String;
+                    item.uuid.should.be.a.String;
+                    item.state.should.be.a.Number;
+                    item.id.should.be.a.Number;
+                });
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should return the domains asynchronously if callback specified', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            conn.listAllDomains(0, function(err, domains) {
+                try {
+                    should.not.exist(err);
+                    domains.should.be.an.Array;
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
+
+        it('should keep a freed domain alive for the calls in flight', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            var domains = conn.listAllDomains(0);
+            if (0 === domains.length) {
+                conn.close();
+                return done();
+            }
+
+            var domain = domains[0].domain;
+            domain.getXMLDesc(0, function(err, xml) {
+                try {
+                    should.not.exist(err);
+                    xml.should.be.a.String;
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+            domain.free();
+        });
+    });
+});
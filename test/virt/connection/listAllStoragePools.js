@@ -0,0 +1,33 @@
+var should = require('should');
+var virt = require('../../../');
+var Connection = virt.Connection;
+
+describe('Connection', function() {
+    describe('#listAllStoragePools', function() {
+        it('should return the wrapped pools with their name and uuid', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                var pools = conn.listAllStoragePools(0);
+                pools.should.be.an.Array;
+
+                pools.forEach(function(item) {
+                    item.pool.should.be.an.instanceOf(virt.StoragePool);
+                    item.name.should.be.a.String;
+                    item.uuid.should.be.a.String;
+
+                    var inventory = item.pool.getVolumeInventory();
+                    inventory.names.should.be.an.Array;
+                    inventory.capacity.should.be.an.instanceOf(Float64Array);
+                    inventory.allocation.should.be.an.instanceOf(Float64Array);
+                    inventory.type.should.be.an.instanceOf(Int32Array);
+                    inventory.capacity.length.should.be.exactly(inventory.names.length);
+                });
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
@@ -0,0 +1,33 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#lookupStorageVolumeByPath', function() {
+        it('should throw error if the volume does not exist', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                (function() {
+                    conn.lookupStorageVolumeByPath('/nonexistent/volume.img');
+                }).should.throw();
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should pass error to callback if the volume does not exist', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            conn.lookupStorageVolumeByPath('/nonexistent/volume.img', function(err, vol) {
+                try {
+                    should.exist(err);
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
+    });
+});
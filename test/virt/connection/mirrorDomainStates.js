@@ -0,0 +1,47 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#mirrorDomainStates', function() {
+        it('should answer state queries from the mirror', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                conn.mirrorDomainStates().should.be.a.Number;
+
+                var domains = conn.listAllDomains(0);
+                var states = conn.listMirroredDomainStates();
+                states.should.be.an.Array;
+                states.length.should.equal(domains.length);
+
+                domains.forEach(function(item) {
+                    var state = conn.lookupMirroredDomainStateByUUID(item.uuid);
+                    state.name.should.equal(item.name);
+                    state.state.should.equal(item.state);
+                    conn.lookupMirroredDomainStateByName(item.name).uuid.should.equal(item.uuid);
+                });
+
+                should.not.exist(conn.lookupMirroredDomainStateByName('no such domain'));
+                conn.getMirroredDomainStateGeneration().should.be.above(0);
+            } finally {
+                conn.unmirrorDomainStates();
+                conn.close();
+            }
+        });
+
+        it('should throw if the states are not mirrored', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                (function() {
+                    conn.listMirroredDomainStates();
+                }).should.throw('Domain states are not mirrored');
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
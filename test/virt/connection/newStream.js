@@ -0,0 +1,35 @@
+var should = require('should');
+var stream = require('stream');
+var virt = require('../../../');
+var Connection = virt.Connection;
+
+describe('Connection', function() {
+    describe('#newStream', function() {
+        it('should return a stream which can be used as node streams', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                var st = conn.newStream(0);
+                st.should.be.an.instanceOf(virt.Stream);
+                st.createReadStream().should.be.an.instanceOf(stream.Readable);
+                st.createWriteStream().should.be.an.instanceOf(stream.Writable);
+                st.abort();
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should abort the stream asynchronously', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            var st = conn.newStream(0);
+            st.abort(function(err) {
+                conn.close();
+                done();
+            });
+        });
+    });
+});
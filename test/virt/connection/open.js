@@ -9,5 +9,32 @@ describe('Connection', function() {
             conn.should.be.an.instanceOf(Connection);
             conn.close();
         });
+
+        it('should pass a Connection object to the callback', function(done) {
+            Connection.open('vbox:///session', function(err, conn) {
+                should.not.exist(err);
+                should.exist(conn);
+                conn.should.be.an.instanceOf(Connection);
+                conn.close();
+                done();
+            });
+        });
+
+        it('should be closed once, however often close is called', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            conn.close(function(err, result) {
+                should.not.exist(err);
+                result.should.be.a.Number;
+            });
+
+            // the wrapper is null right away, the call completes empty
+            conn.close(function(err, result) {
+                should.not.exist(err);
+                should.not.exist(result);
+                done();
+            });
+        });
     });
 });
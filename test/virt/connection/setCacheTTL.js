@@ -0,0 +1,44 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#setCacheTTL', function() {
+        it('should return the cached capabilities', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+
+            try {
+                conn.setCacheTTL({ capabilities: 60000 });
+
+                var caps = conn.getCapabilities();
+                conn.getCapabilities().should.be.exactly(caps);
+
+                var stats = conn.getCacheStats();
+                stats.hits.should.be.exactly(1);
+                stats.misses.should.be.exactly(1);
+                stats.size.should.be.exactly(1);
+
+                conn.clearCache();
+                conn.getCacheStats().size.should.be.exactly(0);
+            } finally {
+                conn.close();
+            }
+        });
+
+        it('should freeze the cached objects', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                conn.setCacheTTL({ nodeInfo: 60000 });
+
+                var info = conn.getNodeInfo();
+                Object.isFrozen(info).should.be.true();
+                conn.getNodeInfo().should.be.exactly(info);
+            } finally {
+                conn.close();
+            }
+        });
+    });
+});
@@ -0,0 +1,56 @@
+var should = require('should');
+var Connection = require('../../../').Connection;
+
+describe('Connection', function() {
+    describe('#setDedicatedThread', function() {
+        it('should execute the calls in order on the dedicated thread', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.should.be.an.instanceOf(Connection);
+            conn.setDedicatedThread(true);
+
+            var calls = [];
+
+            conn.getHostname(function(err, hostname) {
+                should.not.exist(err);
+                hostname.should.be.a.String;
+                calls.push('getHostname');
+            });
+
+            conn.getNodeInfo(function(err, info) {
+                should.not.exist(err);
+                info.should.be.a.Object;
+                calls.push('getNodeInfo');
+                calls.should.eql(['getHostname', 'getNodeInfo']);
+                conn.close();
+                done();
+            });
+        });
+
+        it('should execute the calls on domains on the thread of their connection', function(done) {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+            conn.setDedicatedThread(true);
+
+            var domains = conn.listAllDomains(0);
+            if (0 === domains.length) {
+                conn.close();
+                return done();
+            }
+
+            var calls = [];
+
+            domains[0].domain.getMemoryParameters(0, function(err, params) {
+                calls.push('getMemoryParameters');
+            });
+
+            conn.getHostname(function(err, hostname) {
+                should.not.exist(err);
+                calls.push('getHostname');
+                calls.should.eql(['getMemoryParameters', 'getHostname']);
+                conn.close();
+                done();
+            });
+        });
+    });
+});
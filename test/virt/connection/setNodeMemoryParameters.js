@@ -18,5 +18,31 @@ describe('Connection', function() {
                 conn.close();
             }
         });
+
+        it('should reject malformed parameters', function() {
+            var conn = Connection.open('vbox:///session');
+            should.exist(conn);
+
+            try {
+                (function() {
+                    conn.setNodeMemoryParameters([{ type: 1, value: 0 }]);
+                }).should.throw('Property `field` not found');
+
+                (function() {
+                    conn.setNodeMemoryParameters([{ field: 'model', type: 'int', value: 0 }]);
+                }).should.throw('Property `type` was supposed to be integer');
+
+                (function() {
+                    conn.setNodeMemoryParameters([{ field: 'model', type: 1 }]);
+                }).should.throw('Property `value` not found');
+
+                // VIR_TYPED_PARAM_FIELD_LENGTH is 80 including the NUL
+                (function() {
+                    conn.setNodeMemoryParameters([{ field: new Array(81).join('x'), type: 1, value: 0 }]);
+                }).should.throw('Property `field` is too long');
+            } finally {
+                conn.close();
+            }
+        });
     });
 });
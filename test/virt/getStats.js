@@ -0,0 +1,70 @@
+var should = require('should');
+var virt = require('../../');
+
+describe('virt', function() {
+    describe('#getStats', function() {
+        afterEach(function() {
+            virt.setInstrumentation(false);
+            virt.resetStats();
+        });
+
+        it('should count the instrumented calls', function() {
+            virt.setInstrumentation(true);
+            virt.getVersion();
+            virt.getVersion();
+
+            var stats = virt.getStats();
+            stats.should.have.property('virGetVersion');
+            stats.virGetVersion.calls.should.be.exactly(2);
+            stats.virGetVersion.errors.should.be.exactly(0);
+            stats.virGetVersion.latency.count.should.be.exactly(2);
+            stats.virGetVersion.latency.should.have.property('p99');
+        });
+
+        it('should split the time of asynchronous calls', function(done) {
+            var conn = virt.Connection.open('vbox:///session');
+            virt.setInstrumentation(true);
+
+            conn.getHostname(function(err, hostname) {
+                try {
+                    should.not.exist(err);
+                    var stats = virt.getStats()['Connection#getHostname'];
+                    should.exist(stats);
+                    stats.calls.should.be.exactly(1);
+                    stats.libvirt.count.should.be.exactly(1);
+                    stats.v8.count.should.be.exactly(1);
+                    done();
+                } finally {
+                    conn.close();
+                }
+            });
+        });
+
+        it('should keep the calls of exited worker threads', function(done) {
+            var threads;
+            try {
+                threads = require('worker_threads');
+            } catch (e) {
+                return done();
+            }
+
+            var script = [
+                "var virt = require(" + JSON.stringify(require('path').resolve(__dirname, '../../')) + ");",
+                "virt.getVersion();"
+            ].join('\n');
+
+            virt.setInstrumentation(true);
+            new threads.Worker(script, { eval: true }).on('exit', function() {
+                var stats = virt.getStats();
+                stats.should.have.property('virGetVersion');
+                stats.virGetVersion.calls.should.be.exactly(1);
+                done();
+            }).on('error', done);
+        });
+
+        it('should not count calls while disabled', function() {
+            virt.getVersion();
+            virt.getStats().should.not.have.property('virGetVersion');
+        });
+    });
+});
@@ -1,2 +1,4 @@
+require('./getStats');
 require('./getVersion');
+require('./workerThreads');
 require('./connection');
@@ -0,0 +1,44 @@
+var path = require('path');
+var should = require('should');
+var virt = require('../../');
+
+var threads;
+try {
+    threads = require('worker_threads');
+} catch (e) {
+    threads = null;
+}
+
+describe('virt', function() {
+    describe('in worker threads', function() {
+        if (!threads) {
+            return it('requires worker_threads');
+        }
+
+        it('should be loaded by every worker', function(done) {
+            var script = [
+                "var threads = require('worker_threads');",
+                "var virt = require(" + JSON.stringify(path.resolve(__dirname, '../../')) + ");",
+                "var conn = virt.Connection.open('vbox:///session');",
+                "conn.getHostname(function(err, hostname) {",
+                "    conn.close();",
+                "    threads.parentPort.postMessage({ error: err && err.message, hostname: hostname });",
+                "});"
+            ].join('\n');
+            var pending = 2;
+
+            for (var i = 0; i < 2; i++) {
+                new threads.Worker(script, { eval: true }).on('message', function(result) {
+                    should.not.exist(result.error);
+                    result.hostname.should.be.a.String;
+
+                    if (0 === --pending) {
+                        // the main thread keeps working alongside
+                        virt.getVersion().should.be.a.Number;
+                        done();
+                    }
+                }).on('error', done);
+            }
+        });
+    });
+});